@@ -115,10 +115,38 @@ $(document).ready( function() {
 	$('#dash_platform').html(html);
 
 
+	async function updateLatency()
+	{
+		const result = await requestLatency();
+		if (!result || !result.success)
+			return;
+
+		var latency_html = "";
+		result.info.stages.forEach( function(stage) {
+			if (stage.count > 0)
+				latency_html += '<tr><td>'+$.i18n('dashboard_latencybox_stage_'+stage.stage)+'</td><td>'+stage.p50.toFixed(1)+'</td><td>'+stage.p95.toFixed(1)+'</td><td>'+stage.p99.toFixed(1)+'</td><td>'+stage.max.toFixed(1)+'</td></tr>';
+		});
+		$("#dash_latency").html(latency_html);
+	}
+
 	//interval update
 	updateComponents();
 	$(window.hyperion).on("components-updated",updateComponents);
 
+	// live latency, ends when the dashboard is left
+	updateLatency();
+	var latencyInterval = setInterval(function() {
+		if ($('#dash_latency').length == 0)
+			clearInterval(latencyInterval);
+		else
+			updateLatency();
+	}, 2000);
+
+	$('#btn_latency_reset').off().on('click', function() {
+		requestLatencyReset();
+		$("#dash_latency").html("");
+	});
+
 	if(window.showOptHelp)
 		createHintH("intro", $.i18n('dashboard_label_intro'), "dash_intro");
 
@@ -468,6 +468,16 @@ async function requestLedDeviceProperties(type, params)
 	return sendAsyncToHyperion("leddevice", "getProperties", data, Math.floor(Math.random() * 1000));
 }
 
+async function requestLatency()
+{
+	return sendAsyncToHyperion("latency", "get", null, Math.floor(Math.random() * 1000));
+}
+
+function requestLatencyReset()
+{
+	sendToHyperion("latency", "reset");
+}
+
 function requestLedDeviceIdentification(type, params)
 {
 	sendToHyperion("leddevice", "identify", '"ledDeviceType": "'+type+'","params": '+JSON.stringify(params)+'');
@@ -278,6 +278,20 @@ private:
 	///
 	void handleLedDeviceCommand(const QJsonObject &message, const QString &command, int tan);
 
+	///
+	/// Handle an incoming JSON Latency message, the frame latency of the instance per stage
+	///
+	/// @param message the incoming message
+	///
+	void handleLatencyCommand(const QJsonObject &message, const QString &command, int tan);
+
+	///
+	/// Handle an incoming JSON Tracing message, the trace events of all threads (builds with ENABLE_TRACING)
+	///
+	/// @param message the incoming message
+	///
+	void handleTracingCommand(const QJsonObject &message, const QString &command, int tan);
+
 	///
 	/// Handle an incoming JSON message of unknown type
 	///
@@ -1,6 +1,9 @@
 //#include <iostream>
 #pragma once
 
+// STL includes
+#include <vector>
+
 // Utils includes
 #include <utils/Image.h>
 
@@ -276,10 +279,78 @@ namespace hyperion
 			return detectedBorder;
 		}
 
+		///
+		/// scan detection mode (whole lines from each edge, rescanned on scene changes only)
+		///
+		/// Rows are scanned from the top and bottom edge until a row has enough non-black pixels to
+		/// belong to the picture, so dark scenes, noise and small logos do not shrink the border.
+		/// The side borders are the distance to the first non-black pixel from the left and right
+		/// edge which a minimum number of the picture rows agree on. The border is only detected
+		/// again when a sparse grid of pixels differs from the last detected frame, otherwise the
+		/// previous result is returned.
+		///
+		template <typename Pixel_T>
+		BlackBorder process_scan(const Image<Pixel_T> & image)
+		{
+			static_assert(sizeof(Pixel_T) == 3, "the scan works on packed 24 bit pixels");
+
+			const uint8_t* pixels = reinterpret_cast<const uint8_t*>(image.memptr());
+			if (!sceneChanged(pixels, image.width(), image.height(), image.stride()))
+			{
+				return _sceneBorder;
+			}
+
+			_sceneBorder = scan(pixels, image.width(), image.height(), image.stride());
+			return _sceneBorder;
+		}
+
+		/// Number of sampled pixels per row and column of the scene change check
+		static constexpr unsigned SCENE_GRID = 8;
+
+		///
+		/// Get the position of a pixel sampled by the scene change check
+		///
+		/// @param[in] index  The index of the sample in the row or column [0, SCENE_GRID)
+		/// @param[in] size   The width or height of the image
+		///
+		/// @return The x or y coordinate of the sample
+		///
+		static unsigned scenePosition(unsigned index, unsigned size)
+		{
+			return static_cast<unsigned>((2 * index + 1) * static_cast<uint64_t>(size) / (2 * SCENE_GRID));
+		}
 
+		///
+		/// Get the instruction set of the line scan, e.g. for log output
+		///
+		static const char* scanKernelName();
 
 	private:
 
+		///
+		/// Checks if the image differs from the last scanned one, the grid of samples is kept if so.
+		///
+		/// @param[in] pixels  The packed RGB pixels
+		/// @param[in] width   The width of the image
+		/// @param[in] height  The height of the image
+		/// @param[in] stride  The distance between the rows in bytes
+		///
+		/// @return True if the border has to be scanned again
+		///
+		bool sceneChanged(const uint8_t* pixels, unsigned width, unsigned height, size_t stride);
+
+		///
+		/// Scans the rows and columns from each edge, see process_scan()
+		///
+		/// @param[in] pixels  The packed RGB pixels
+		/// @param[in] width   The width of the image
+		/// @param[in] height  The height of the image
+		/// @param[in] stride  The distance between the rows in bytes
+		///
+		/// @return The detected (or not detected) black border info
+		///
+		BlackBorder scan(const uint8_t* pixels, unsigned width, unsigned height, size_t stride);
+
 		///
 		/// Checks if a given color is considered black and therefore could be part of the border.
 		///
@@ -298,5 +369,22 @@ namespace hyperion
 		/// Threshold for the black-border detector [0 .. 255]
 		const uint8_t _blackborderThreshold;
 
+		/// Samples of the last scanned frame and its size, and the samples of the current one
+		std::vector<uint8_t> _sceneSamples;
+		std::vector<uint8_t> _currentSamples;
+		unsigned _sceneWidth;
+		unsigned _sceneHeight;
+		size_t _sceneStride;
+
+		/// Byte offsets of the sampled pixels in frames of the scanned size
+		std::vector<size_t> _sampleOffsets;
+
+		/// The border of the last scanned frame
+		BlackBorder _sceneBorder;
+
+		/// The distances of the first non-black pixels to the left and right edge per picture row
+		std::vector<unsigned> _leftEdges;
+		std::vector<unsigned> _rightEdges;
+
 	};
 } // end namespace hyperion
@@ -3,8 +3,12 @@
 // QT includes
 #include <QJsonObject>
 
+// STL includes
+#include <vector>
+
 // util
 #include <utils/Logger.h>
+#include <utils/SampleDemand.h>
 #include <utils/settings.h>
 #include <utils/Components.h>
 
@@ -50,6 +54,15 @@ namespace hyperion
 		///
 		void setHardDisable(bool disable);
 
+		///
+		/// Get the pixels the detection of the current mode reads from an image of the given size
+		///
+		/// @param width   The width of the image
+		/// @param height  The height of the image
+		/// @param[out] spans  The pixels are appended as spans
+		///
+		void getProbeSpans(unsigned width, unsigned height, std::vector<SampleDemand::Span> & spans) const;
+
 		///
 		/// Processes the image. This performs detection of black-border on the given image and
 		/// updates the current border accordingly. If the current border is updated the method call
@@ -62,18 +75,27 @@ namespace hyperion
 		template <typename Pixel_T>
 		bool process(const Image<Pixel_T> & image)
 		{
-			// get the border for the single image
-			BlackBorder imageBorder;
-			imageBorder.horizontalSize = 0;
-			imageBorder.verticalSize = 0;
-
 			if (!enabled())
 			{
-				imageBorder.unknown=true;
-				_currentBorder = imageBorder;
-				return true;
+				return processDetected(BlackBorder{true, 0, 0});
 			}
 
+			return processDetected(detect(image));
+		}
+
+		///
+		/// Detects the black-border of a single image with the current mode and threshold, without
+		/// changing the current border.
+		///
+		/// @param image The image to detect the border of
+		///
+		/// @return The border of the image
+		///
+		template <typename Pixel_T>
+		BlackBorder detect(const Image<Pixel_T> & image) const
+		{
+			BlackBorder imageBorder {false, 0, 0};
+
 			if (_detectionMode == "default") {
 				imageBorder = _detector->process(image);
 			} else if (_detectionMode == "classic") {
@@ -82,20 +104,30 @@ namespace hyperion
 				imageBorder = _detector->process_osd(image);
 			} else if (_detectionMode == "letterbox") {
 				imageBorder = _detector->process_letterbox(image);
+			} else if (_detectionMode == "scan") {
+				imageBorder = _detector->process_scan(image);
 			}
-			// add blur to the border
-			if (imageBorder.horizontalSize > 0)
-			{
-				imageBorder.horizontalSize += _blurRemoveCnt;
-			}
-			if (imageBorder.verticalSize > 0)
-			{
-				imageBorder.verticalSize += _blurRemoveCnt;
-			}
-
-			const bool borderUpdated = updateBorder(imageBorder);
-			return borderUpdated;
+			return imageBorder;
 		}
+
+		///
+		/// Updates the current border with the border detected in an image, see detect(). While
+		/// disabled, the border becomes unknown.
+		///
+		/// @param imageBorder The border of the image
+		///
+		/// @return True if a different border was detected than the current else false
+		///
+		bool processDetected(BlackBorder imageBorder);
+
+		///
+		/// Identifies the detection settings (mode and threshold), images with equal keys have equal
+		/// detection results.
+		///
+		/// @return The key of the current detection settings
+		///
+		QString detectionKey() const;
+
 	private slots:
 		///
 		/// @brief Handle settings update from Hyperion Settingsmanager emit or this constructor
@@ -1,12 +1,19 @@
 #pragma once
 
 // stl includes
-#include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // Qt includes
 #include <QObject>
-#include <QSocketNotifier>
+#include <QJsonObject>
 #include <QRectF>
 #include <QMap>
 #include <QMultiMap>
@@ -18,25 +25,14 @@
 #include <utils/Components.h>
 #include <cec/CECEvent.h>
 
-// general JPEG decoder includes
-#ifdef HAVE_JPEG_DECODER
-	#include <QImage>
-	#include <QColor>
-#endif
-
-// System JPEG decoder
-#ifdef HAVE_JPEG
-	#include <jpeglib.h>
-	#include <csetjmp>
-#endif
-
-// TurboJPEG decoder
-#ifdef HAVE_TURBO_JPEG
-	#include <turbojpeg.h>
-#endif
-
 /// Capture class for V4L2 devices
 ///
+/// Frames are captured by a pipeline of threads: a dequeue thread takes the filled buffers from
+/// the driver and requeues them right away (compressed frames are copied, raw frames are converted
+/// in place while the driver has enough other buffers to fill), decode workers convert the frames
+/// and the latest converted frame is handed to the grabber's thread, which checks the signal and
+/// emits it. Frames leave the pipeline in capture order, a frame overtaken by a newer one is dropped.
+///
 /// @see http://linuxtv.org/downloads/v4l-dvb-apis/capture-example.html
 class V4L2Grabber : public Grabber
 {
@@ -78,6 +74,16 @@ public:
 	///
 	void setPixelDecimation(int pixelDecimation) override;
 
+	///
+	/// @brief  overwrite Grabber.h implementation
+	///
+	void setVideoMode(VideoMode mode) override;
+
+	///
+	/// @brief  overwrite Grabber.h implementation
+	///
+	void setCropping(unsigned cropLeft, unsigned cropRight, unsigned cropTop, unsigned cropBottom) override;
+
 	///
 	/// @brief  overwrite Grabber.h implementation
 	///
@@ -150,6 +156,11 @@ public:
 	///
 	QStringList getFramerates(const QString& devicePath) const override;
 
+	///
+	/// @brief overwrite Grabber.h implementation
+	///
+	QJsonObject getV4L2pipelineStats() const override;
+
 public slots:
 
 	bool start();
@@ -163,7 +174,15 @@ signals:
 	void readError(const char* err);
 
 private slots:
-	int read_frame();
+	///
+	/// @brief Check the signal of the latest decoded frame and emit it, runs on the grabber's thread
+	///
+	void deliverFrame();
+
+	///
+	/// @brief Stop capturing after the dequeue thread failed to read from the device
+	///
+	void dequeueFailed();
 
 private:
 	void getV4Ldevices();
@@ -190,9 +209,64 @@ private:
 
 	void stop_capturing();
 
-	bool process_image(const void *p, int size);
+	///
+	/// @brief Start the dequeue thread and the decode workers, the device is streaming
+	///
+	void startPipeline();
+
+	///
+	/// @brief Stop the threads of the pipeline and drop the frames in flight
+	///
+	void stopPipeline();
+
+	///
+	/// @brief The loop of the dequeue thread, waits for filled buffers until the pipeline stops
+	///
+	void runDequeue();
+
+	///
+	/// @brief Take a filled buffer from the driver and queue its frame to the decode workers
+	/// @return False if the device failed
+	///
+	bool dequeueFrame();
+
+	///
+	/// @brief Give a driver buffer back to the driver to be filled again
+	/// @param index  The index of the buffer
+	/// @return False if the device failed
+	///
+	bool requeueBuffer(int index);
+
+	struct DecodeWorker;
+
+	///
+	/// @brief The loop of a decode worker, decodes the queued frames until the pipeline stops
+	///
+	void runDecodeWorker(DecodeWorker* worker);
+
+	///
+	/// @brief Decode or convert a captured frame with the current cropping and decimation
+	/// @return True if the frame was decoded
+	///
+	bool decodeFrame(DecodeWorker* worker, const uint8_t * data, int size, Image<ColorRgb> & image);
+
+	///
+	/// @brief Offer a decoded frame to the grabber's thread, replacing a frame it has not taken yet
+	///
+	void handOff(uint64_t sequence, const Image<ColorRgb> & image);
+
+	///
+	/// @brief Publish the pixels read by the signal detection, so they are converted even if the
+	/// 	   led mapping does not read them
+	///
+	void updateSignalDetectionDemand(unsigned width, unsigned height);
 
-	void process_image(const uint8_t *p, int size);
+	///
+	/// @brief The capture time of a dequeued buffer, the driver's timestamp if it is taken from the monotonic clock
+	/// @param buf  The dequeued buffer
+	/// @return The capture time, see LatencyTracker::now()
+	///
+	static int64_t captureTimeOf(const struct v4l2_buffer& buf);
 
 	int xioctl(int request, void *arg);
 
@@ -222,32 +296,31 @@ private:
 			size_t  length;
 	};
 
-#ifdef HAVE_JPEG
-	struct errorManager
+	/// A captured frame on its way from the dequeue thread to a decode worker
+	struct CapturedFrame
 	{
-		jpeg_error_mgr pub;
-		jmp_buf setjmp_buffer;
+		uint64_t sequence = 0;
+		/// Capture time of the frame, see LatencyTracker::now()
+		int64_t captureTime = 0;
+		/// Copy of the frame, unused if the frame is read from a pinned driver buffer
+		std::vector<uint8_t> data;
+		/// Index of the driver buffer holding the frame until it is decoded, -1 if the frame was copied
+		int pinnedBuffer = -1;
+		int size = 0;
 	};
 
-	static void errorHandler(j_common_ptr cInfo)
+	/// Counters of the pipeline, see getV4L2pipelineStats()
+	struct PipelineStats
 	{
-		errorManager* mgr = reinterpret_cast<errorManager*>(cInfo->err);
-		longjmp(mgr->setjmp_buffer, 1);
-	}
-
-	static void outputHandler(j_common_ptr cInfo)
-	{
-		// Suppress fprintf warnings.
-	}
-
-	jpeg_decompress_struct* _decompress;
-	errorManager* _error;
-#endif
-
-#ifdef HAVE_TURBO_JPEG
-	tjhandle _decompress = nullptr;
-	int _subsamp;
-#endif
+		std::atomic<uint64_t> captured{0};
+		std::atomic<uint64_t> copied{0};
+		std::atomic<uint64_t> pinned{0};
+		std::atomic<uint64_t> queueDropped{0};
+		std::atomic<uint64_t> decodeFailed{0};
+		std::atomic<uint64_t> reorderDropped{0};
+		std::atomic<uint64_t> handoffDropped{0};
+		std::atomic<uint64_t> delivered{0};
+	};
 
 private:
 	QString _deviceName;
@@ -268,16 +341,48 @@ private:
 	int      _noSignalCounterThreshold;
 	ColorRgb _noSignalThresholdColor;
 	bool     _signalDetectionEnabled;
-	bool     _cecDetectionEnabled;
-	bool     _cecStandbyActivated;
+	std::atomic<bool> _cecDetectionEnabled;
+	std::atomic<bool> _cecStandbyActivated;
 	bool     _noSignalDetected;
 	int      _noSignalCounter;
 	double   _x_frac_min;
 	double   _y_frac_min;
 	double   _x_frac_max;
 	double   _y_frac_max;
-
-	QSocketNotifier *_streamNotifier;
+	unsigned _signalDemandWidth;
+	unsigned _signalDemandHeight;
+
+	// capture pipeline
+	std::thread _dequeueThread;
+	std::vector<std::unique_ptr<DecodeWorker>> _decodeWorkers;
+	/// Wakes the dequeue thread when the pipeline stops
+	int _wakeupFd;
+	/// True while the pipeline is not running
+	std::atomic<bool> _pipelineQuit;
+	/// Driver buffers queued for filling
+	std::atomic<int> _queuedBuffers;
+	/// Sequence number of the last dequeued frame
+	uint64_t _frameSequence;
+
+	/// Captured frames waiting for a decode worker, the oldest frame is dropped when the queue is full
+	mutable std::mutex _pendingMutex;
+	std::condition_variable _pendingCondition;
+	std::deque<CapturedFrame> _pendingFrames;
+	size_t _pendingCapacity;
+	/// Buffers of decoded frame copies, reused for the next copies
+	std::vector<std::vector<uint8_t>> _spareFrameData;
+
+	/// The latest decoded frame until the grabber's thread takes it
+	mutable std::mutex _handoffMutex;
+	Image<ColorRgb> _handoffImage;
+	bool _handoffPending;
+	/// Sequence number of the latest handed off frame, older frames are dropped
+	uint64_t _handoffSequence;
+
+	/// Serializes the cropping and decimation between the settings and the decode workers
+	std::mutex _decodeSettingsMutex;
+
+	PipelineStats _pipelineStats;
 
 	bool _initialized;
 	bool _deviceAutoDiscoverEnabled;
@@ -33,6 +33,10 @@ public:
 	///
 	/// @param[out] image  The snapped screenshot (should be initialized with correct width and
 	/// height)
+	/// @param[in] forceUpdate  Update the screen dimensions and grab even if the screen did not change
+	///
+	/// @return 0 on success, 1 if the screen did not change since the last grab (the image is left
+	/// untouched), -1 on errors
 	///
 	int grabFrame(Image<ColorRgb> & image, bool forceUpdate=false);
 
@@ -65,7 +69,14 @@ protected:
 	bool nativeEventFilter(const QByteArray & eventType, void * message, long int * result) override;
 
 private:
-	bool _XShmAvailable, _XShmPixmapAvailable, _XRenderAvailable,  _XRandRAvailable;
+	///
+	/// @brief Check the damage reported by the X server since the last grab
+	/// @param force  Grab even without damage
+	/// @return True if the screen has to be grabbed, the damage is reset then
+	///
+	bool takeDamage(bool force);
+
+	bool _XShmAvailable, _XShmPixmapAvailable, _XRenderAvailable,  _XRandRAvailable, _XDamageAvailable;
 
 	XImage* _xImage;
 	XShmSegmentInfo _shminfo;
@@ -84,6 +95,10 @@ private:
 
 	int _XRandREventBase;
 
+	/// Damage of the root window, the screen is grabbed only after it changed (XDamage is optional at build time)
+	XID _damage;
+	int _XDamageEventBase;
+
 	XTransform _transform;
 	int _pixelDecimation;
 
@@ -25,7 +25,22 @@ public:
 	~XcbGrabber() override;
 
 	bool Setup();
+
+	///
+	/// @brief Grab the screen, unless it did not change since the last grab
+	///
+	/// Shared memory grabs are pipelined: the frame requested by the previous call is converted
+	/// while the server grabs the next one into the other buffer, see frameCaptureTime().
+	///
+	/// @return 0 on success, 1 if the screen did not change (the image is left untouched), -1 on errors
+	///
 	int grabFrame(Image<ColorRgb> & image, bool forceUpdate = false);
+
+	///
+	/// @brief overwrite Grabber.h implementation
+	///
+	int64_t frameCaptureTime() const override { return _frameCaptureTime; }
+
 	int updateScreenDimensions(bool force = false);
 	void setVideoMode(VideoMode mode) override;
 	bool setWidthHeight(int width, int height) override { return true; }
@@ -39,6 +54,32 @@ private:
 	void setupRender();
 	void setupRandr();
 	void setupShm();
+	void setupDamage();
+
+	///
+	/// @brief Check the damage reported by the X server since the last grab
+	/// @param force  Grab even without damage
+	/// @return True if the screen has to be grabbed
+	///
+	bool screenChanged(bool force);
+
+	///
+	/// @brief Reset the damage with the next grab, later changes are reported for the following one
+	///
+	void resetDamage();
+
+	///
+	/// @brief Send the requests of a shared memory grab without waiting for the reply
+	/// @param buffer  The index of the buffer the server writes the frame into
+	///
+	void requestFrame(int buffer);
+
+	///
+	/// @brief Wait for the reply of the pending shared memory grab
+	/// @return True if the frame was written into its buffer
+	///
+	bool collectFrame();
+
 	xcb_screen_t * getScreen(const xcb_setup_t *setup, int screen_num) const;
 	xcb_render_pictformat_t findFormatForVisual(xcb_visualid_t visual) const;
 
@@ -50,7 +91,24 @@ private:
 	xcb_render_picture_t _srcPicture;
 	xcb_render_picture_t _dstPicture;
 	xcb_render_transform_t _transform;
-	xcb_shm_seg_t  _shminfo;
+
+	/// A shared memory segment the server writes the grabbed frames into
+	struct ShmBuffer
+	{
+		xcb_shm_seg_t segment;
+		int id;
+		uint8_t * data;
+	};
+
+	/// Double buffered, the server writes the next frame while the current one is converted
+	ShmBuffer _shmBuffers[2];
+	/// The buffer of the grab in flight, -1 if none
+	int _pendingBuffer;
+	xcb_shm_get_image_cookie_t _pendingCookie;
+	/// Time the grab in flight was requested, see LatencyTracker::now()
+	int64_t _pendingRequestTime;
+	/// Time the last converted frame was requested
+	int64_t _frameCaptureTime;
 
 	int _pixelDecimation;
 
@@ -63,9 +121,13 @@ private:
 	bool _XcbRandRAvailable;
 	bool _XcbShmAvailable;
 	bool _XcbShmPixmapAvailable;
+	bool _XcbDamageAvailable;
 	Logger * _logger;
 
-	uint8_t * _shmData;
-
 	int _XcbRandREventBase;
+
+	/// Damage of the root window (xcb_damage_damage_t), the screen is grabbed only after it
+	/// changed (XCB damage is optional at build time)
+	uint32_t _damage;
+	int _XcbDamageEventBase;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 // STL includes
+#include <cstdint>
 #include <QString>
 
 // Utils includes
@@ -31,4 +32,10 @@ public:
 	RgbChannelAdjustment _rgbYellowAdjustment;
 
 	RgbTransform _rgbTransform;
+
+	/// Output of the eight channel adjustments (black, red, green, blue, cyan, magenta, yellow,
+	/// white) per input value at the current brightness, prepared by MultiColorAdjustment.
+	/// Red, green and blue are packed into 11 bit fields (bit 0, 11 and 22), so the outputs of
+	/// all eight channels can be summed up without a carry into the next color.
+	uint32_t _channelTable[8][256];
 };
@@ -12,6 +12,7 @@
 #include <utils/Components.h>
 
 #include <QMultiMap>
+#include <QJsonObject>
 
 ///
 /// @brief The Grabber class is responsible to apply image resizes (with or without ImageResampler)
@@ -149,7 +150,37 @@ public:
 	///
 	virtual QStringList getFramerates(const QString& devicePath) const { return QStringList(); }
 
+	///
+	/// @brief Get the queue depths and drop counters of the V4L capture pipeline
+	/// @return The statistics per pipeline stage on success else empty Object
+	///
+	virtual QJsonObject getV4L2pipelineStats() const { return QJsonObject(); }
+
+	///
+	/// @brief Get the capture time of the last grabbed frame, for grabbers delivering frames captured
+	/// before the grab call (see LatencyTracker::now())
+	/// @return The capture time, 0 if the frame was captured by the grab call
+	///
+	virtual int64_t frameCaptureTime() const { return 0; }
+
 protected:
+	///
+	/// @brief For screen grabbers notified about changes (e.g. by XDamage): check if the screen has
+	/// to be grabbed. An unchanged screen is grabbed every KEEP_ALIVE_INTERVAL_US, as the capture
+	/// input goes inactive after 5 seconds without frames.
+	/// @param force  Grab even if the screen did not change
+	/// @return True if the screen changed (see _screenChanged), the grab is forced or due
+	///
+	bool screenGrabDue(bool force) const;
+
+	///
+	/// @brief Restart the keep-alive interval after a grab, the screen counts as unchanged again
+	///
+	void screenGrabbed();
+
+	/// Interval of the grabs of an unchanged screen, see screenGrabDue()
+	static const int64_t KEEP_ALIVE_INTERVAL_US = 1000000;
+
 	ImageResampler _imageResampler;
 
 	bool _useImageResampler;
@@ -174,6 +205,12 @@ protected:
 
 	bool _enabled;
 
+	/// Set when the screen changed since the last grab, see screenGrabDue()
+	bool _screenChanged;
+
+	/// Time of the last screen grab, see LatencyTracker::now()
+	int64_t _lastScreenGrabTime;
+
 	/// logger instance
 	Logger * _log;
 
@@ -10,6 +10,8 @@
 #include <utils/Logger.h>
 #include <utils/Components.h>
 #include <utils/Image.h>
+#include <utils/LatencyTracker.h>
+#include <utils/Tracer.h>
 #include <utils/ColorRgb.h>
 #include <utils/VideoMode.h>
 #include <utils/settings.h>
@@ -90,6 +92,12 @@ public:
 	///
 	virtual QStringList getFramerates(const QString& devicePath) const;
 
+	///
+	/// @brief Get the queue depths and drop counters of the V4L capture pipeline
+	/// @return The statistics per pipeline stage on success else empty Object
+	///
+	virtual QJsonObject getV4L2pipelineStats() const;
+
 	///
 	/// @brief Get active grabber name
 	/// @return Active grabber name
@@ -99,9 +107,16 @@ public:
 	static QStringList availableGrabbers();
 
 public:
+	///
+	/// @brief Grab a frame and broadcast it. A grabber returns a positive value if the screen did
+	/// not change since its last frame, nothing is broadcast then.
+	/// @return False if the grab failed
+	///
 	template <typename Grabber_T>
 	bool transferFrame(Grabber_T &grabber)
 	{
+		TRACE_SCOPE("grabber.grab");
+
 		unsigned w = grabber.getImageWidth();
 		unsigned h = grabber.getImageHeight();
 		if ( _image.width() != w || _image.height() != h)
@@ -109,13 +124,17 @@ public:
 			_image.resize(w, h);
 		}
 
+		const int64_t captureTime = LatencyTracker::now();
 		int ret = grabber.grabFrame(_image);
-		if (ret >= 0)
+		if (ret == 0)
 		{
+			// pipelined grabbers deliver a frame captured by an earlier call
+			const int64_t frameCaptureTime = grabber.frameCaptureTime();
+			_image.setCaptureTime(frameCaptureTime != 0 ? frameCaptureTime : captureTime);
 			emit systemImage(_grabberName, _image);
 			return true;
 		}
-		return false;
+		return ret > 0;
 	}
 
 public slots:
@@ -1,6 +1,7 @@
 #pragma once
 
 // stl includes
+#include <atomic>
 #include <list>
 
 // QT includes
@@ -11,12 +12,14 @@
 #include <QJsonValue>
 #include <QJsonArray>
 #include <QMap>
+#include <QElapsedTimer>
 
 // hyperion-utils includes
 #include <utils/Image.h>
 #include <utils/ColorRgb.h>
 #include <utils/Components.h>
 #include <utils/VideoMode.h>
+#include <utils/LatencyTracker.h>
 
 // Hyperion includes
 #include <hyperion/LedString.h>
@@ -48,6 +51,7 @@ class CaptureCont;
 class BoblightServer;
 class LedDeviceWrapper;
 class Logger;
+class QTimer;
 
 ///
 /// The main class of Hyperion. This gives other 'users' access to the attached LedDevice through
@@ -300,6 +304,12 @@ public slots:
 	///
 	PriorityMuxer::InputInfo getPriorityInfo(int priority) const;
 
+	///
+	/// @brief Get the latest state of all priority channels without copying them, can be called from any thread
+	/// @return The immutable snapshot of the priority channels
+	///
+	PriorityMuxer::SnapshotPtr getPrioritySnapshot() const;
+
 	/// #############
 	/// SETTINGSMANAGER
 	///
@@ -370,6 +380,44 @@ public slots:
 
 	int getLatchTime() const;
 
+	///
+	/// @brief Get the number of input frames superseded by a newer frame before they were processed
+	/// @return The number of dropped frames since start
+	///
+	uint64_t getDroppedFrames() const { return _droppedFrames; }
+
+	///
+	/// @brief Get the minimum time between two updates, derived from the latch time of the device
+	/// 	   and the smoothing interval
+	/// @return The interval in ms
+	///
+	int getUpdateInterval() const { return _updateInterval_ms; }
+
+	///
+	/// @brief Hands led colors directly to the LedDevice thread, for output clocked outside of the instance thread.
+	/// 	   See LedDeviceWrapper::publishLeds()
+	/// @param ledValues  The RGB-color per led
+	///
+	void publishLedDeviceData(const std::vector<ColorRgb>& ledValues);
+
+	///
+	/// @brief Get the output statistics of the smoothing (rates, timing jitter and missed deadlines)
+	/// @return The statistics of the last period
+	///
+	QJsonObject getSmoothingStatistics() const;
+
+	///
+	/// @brief Get the time the smoothing and the LedDevice were idle, as the output colors did not change
+	/// @return The idle state and times
+	///
+	QJsonObject getIdleStatistics() const;
+
+	///
+	/// @brief Get the latency of the frames from their capture to each stage of the led update, can be used from any thread
+	/// @return The latency tracker of the instance
+	///
+	LatencyTracker* getLatencyTracker() { return &_latency; }
+
 signals:
 	/// Signal which is emitted when a priority channel is actively cleared
 	/// This signal will not be emitted when a priority channel time out
@@ -478,6 +526,13 @@ private slots:
 
 	void handlePriorityChangedLedDevice(const quint8& priority);
 
+protected:
+	///
+	/// @brief Track subscribers of the image signals, see updateImageDemand()
+	///
+	void connectNotify(const QMetaMethod& signal) override;
+	void disconnectNotify(const QMetaMethod& signal) override;
+
 private:
 	friend class HyperionDaemon;
 	friend class HyperionIManager;
@@ -488,6 +543,21 @@ private:
 	///
 	Hyperion(quint8 instance, bool readonlyMode = false);
 
+	///
+	/// @brief Grabbers convert only the pixels read by the led mapping, unless the whole image is
+	/// 	   consumed by the image stream (preview) or the message forwarder. Publishes the
+	/// 	   demand for whole images when there are such subscribers.
+	/// @return True if the image stream has subscribers
+	///
+	bool updateImageDemand();
+
+	///
+	/// @brief Update the leds for new input of the visible priority. Inputs arriving faster than the
+	/// 	   device can take them are coalesced, the muxer holds the latest one which is processed
+	/// 	   by a single deferred update (latest wins).
+	///
+	void scheduleUpdate();
+
 	/// instance index
 	const quint8 _instIndex;
 
@@ -503,7 +573,8 @@ private:
 	/// Image Processor
 	ImageProcessor* _imageProcessor;
 
-	std::vector<ColorOrder> _ledStringColorOrder;
+	/// The color byte order of the leds
+	std::vector<ColorOrderRun> _colorOrderRuns;
 
 	/// The priority muxer
 	PriorityMuxer _muxer;
@@ -545,4 +616,28 @@ private:
 	BoblightServer* _boblightServer;
 
 	bool _readOnlyMode;
+
+	/// True while whole images are demanded from the grabbers
+	std::atomic<bool> _fullImageDemand;
+
+	/// Deferred update for coalesced input, see scheduleUpdate()
+	QTimer* _updateTimer;
+
+	/// Time since the last update
+	QElapsedTimer _lastUpdate;
+
+	/// The latch time of the led device as reported by the device (ms)
+	int _latchTime_ms;
+
+	/// Minimum time between two updates (ms)
+	std::atomic<int> _updateInterval_ms;
+
+	/// Number of input frames superseded before they were processed
+	std::atomic<uint64_t> _droppedFrames;
+
+	/// Latency of the frames from capture to the led device
+	LatencyTracker _latency;
+
+	/// Capture time of the input traced last, repeated updates of an input are not traced again
+	int64_t _tracedCaptureTime;
 };
@@ -8,7 +8,11 @@
 // Hyperion includes
 #include <hyperion/LedString.h>
 #include <hyperion/ImageToLedsMap.h>
+#include <hyperion/ImageToLedsMapCache.h>
+#include <hyperion/IntegralImage.h>
+#include <hyperion/SharedFrameStage.h>
 #include <utils/Logger.h>
+#include <utils/Tracer.h>
 
 // settings
 #include <utils/settings.h>
@@ -102,26 +106,44 @@ public:
 	/// if required and call the image-to-leds mapping to determine the mean color per led.
 	///
 	/// @param[in] image  The image to translate to led values
+	/// @param[in] sharedFrame  True if other instances process the same image (broadcast capture),
+	/// 						the border detection and summed-area table are shared then
 	///
 	/// @return The color value per led
 	///
 	template <typename Pixel_T>
-	std::vector<ColorRgb> process(const Image<Pixel_T>& image)
+	std::vector<ColorRgb> process(const Image<Pixel_T>& image, bool sharedFrame = false)
 	{
+		TRACE_SCOPE("processor.process");
+
 		std::vector<ColorRgb> colors;
 		if (image.width()>0 && image.height()>0)
 		{
+			// Apply a mapping which waited for an image holding its pixels
+			applyNextMapping(image.sampleGeneration());
+
 			// Ensure that the buffer-image is the proper size
 			setSize(image);
 
 			// Check black border detection
-			verifyBorder(image);
+			verifyBorder(image, sharedFrame);
+
+			// Tell the grabbers which pixels are read
+			updateSampleDemand();
 
 			// Create a result vector and call the 'in place' function
-			switch (_mappingType)
+			const hyperion::IntegralImage* integral = nullptr;
+			if (_mappingType == 1)
+			{
+				colors = _imageToLeds->getUniLedColor(image);
+			}
+			else if ((integral = updateIntegralImage(image, sharedFrame)) != nullptr)
 			{
-				case 1: colors = _imageToLeds->getUniLedColor(image); break;
-				default: colors = _imageToLeds->getMeanLedColor(image);
+				colors = _imageToLeds->getIntegralLedColor(*integral);
+			}
+			else
+			{
+				colors = _imageToLeds->getMeanLedColor(image);
 			}
 		}
 		else
@@ -138,23 +160,41 @@ public:
 	///
 	/// @param[in] image  The image to translate to led values
 	/// @param[out] ledColors  The color value per led
+	/// @param[in] sharedFrame  True if other instances process the same image (broadcast capture),
+	/// 						the border detection and summed-area table are shared then
 	///
 	template <typename Pixel_T>
-	void process(const Image<Pixel_T>& image, std::vector<ColorRgb>& ledColors)
+	void process(const Image<Pixel_T>& image, std::vector<ColorRgb>& ledColors, bool sharedFrame = false)
 	{
+		TRACE_SCOPE("processor.process");
+
 		if ( image.width()>0 && image.height()>0)
 		{
+			// Apply a mapping which waited for an image holding its pixels
+			applyNextMapping(image.sampleGeneration());
+
 			// Ensure that the buffer-image is the proper size
 			setSize(image);
 
 			// Check black border detection
-			verifyBorder(image);
+			verifyBorder(image, sharedFrame);
+
+			// Tell the grabbers which pixels are read
+			updateSampleDemand();
 
 			// Determine the mean or uni colors of each led (using the existing mapping)
-			switch (_mappingType)
+			const hyperion::IntegralImage* integral = nullptr;
+			if (_mappingType == 1)
 			{
-				case 1: _imageToLeds->getUniLedColor(image, ledColors); break;
-				default: _imageToLeds->getMeanLedColor(image, ledColors);
+				_imageToLeds->getUniLedColor(image, ledColors);
+			}
+			else if ((integral = updateIntegralImage(image, sharedFrame)) != nullptr)
+			{
+				_imageToLeds->getIntegralLedColor(*integral, ledColors);
+			}
+			else
+			{
+				_imageToLeds->getMeanLedColor(image, ledColors);
 			}
 		}
 		else
@@ -174,39 +214,107 @@ public:
 	/// @return true if the parameters could be retrieved
 	bool getScanParameters(size_t led, double & hscanBegin, double & hscanEnd, double & vscanBegin, double & vscanEnd) const;
 
+	///
+	/// @brief Get the cache of image to leds mappings, e.g. for its statistics
+	/// @return The mapping cache
+	///
+	const hyperion::ImageToLedsMapCache& getMapCache() const { return _mapCache; }
+
 private:
+	///
+	/// Decides if the mean led colors are taken from the summed-area table and rebuilds the table
+	/// from the image in that case. The table is used if requested by the mapping type or if the
+	/// leds overlap so much that building the table is cheaper than summing up their pixels, see
+	/// ImageToLedsMap::preferIntegralImage().
+	///
+	/// @param[in] image  The image to be mapped
+	/// @param[in] sharedFrame  True if the table may be shared with other instances
+	///
+	/// @return The summed-area table to be used, nullptr to map the image
+	///
+	template <typename Pixel_T>
+	const hyperion::IntegralImage* updateIntegralImage(const Image<Pixel_T> & image, bool sharedFrame)
+	{
+		const bool useIntegral = (_mappingType == 2)
+				|| (_mappingType == 0 && _imageToLeds->preferIntegralImage());
+
+		return useIntegral ? buildIntegralImage(image, sharedFrame) : nullptr;
+	}
+
+	template <typename Pixel_T>
+	const hyperion::IntegralImage* buildIntegralImage(const Image<Pixel_T> & image, bool /*sharedFrame*/)
+	{
+		_integralImage.update(image);
+		return _integralImage.valid() ? &_integralImage : nullptr;
+	}
+
+	///
+	/// Builds the summed-area table, for shared frames only the first instance builds it
+	///
+	const hyperion::IntegralImage* buildIntegralImage(const Image<ColorRgb> & image, bool sharedFrame)
+	{
+		if (!sharedFrame)
+		{
+			_integralImage.update(image);
+			return _integralImage.valid() ? &_integralImage : nullptr;
+		}
+
+		_sharedIntegralImage = hyperion::SharedFrameStage::getInstance()->integralImage(image);
+		return _sharedIntegralImage.get();
+	}
+
+	template <typename Pixel_T>
+	hyperion::BlackBorder detectBorder(const Image<Pixel_T> & image, bool /*sharedFrame*/) const
+	{
+		return _borderProcessor->detect(image);
+	}
+
+	///
+	/// Detects the black border of the image, for shared frames only the first instance with the
+	/// same detection settings runs the detection
+	///
+	hyperion::BlackBorder detectBorder(const Image<ColorRgb> & image, bool sharedFrame) const
+	{
+		if (!sharedFrame)
+		{
+			return _borderProcessor->detect(image);
+		}
+
+		return hyperion::SharedFrameStage::getInstance()->blackBorder(image, _borderProcessor->detectionKey(),
+				[&]() { return _borderProcessor->detect(image); });
+	}
+
 	///
 	/// Performs black-border detection (if enabled) on the given image
 	///
 	/// @param[in] image  The image to perform black-border detection on
+	/// @param[in] sharedFrame  True if the detection may be shared with other instances
 	///
 	template <typename Pixel_T>
-	void verifyBorder(const Image<Pixel_T> & image)
+	void verifyBorder(const Image<Pixel_T> & image, bool sharedFrame)
 	{
-		if (!_borderProcessor->enabled() && ( _imageToLeds->horizontalBorder()!=0 || _imageToLeds->verticalBorder()!=0 ))
+		// a deferred mapping is the one in effect for the detection, frames converted before it don't reset again
+		const std::shared_ptr<const hyperion::ImageToLedsMap>& mapping = _nextImageToLeds ? _nextImageToLeds : _imageToLeds;
+		if (!_borderProcessor->enabled() && ( mapping->horizontalBorder()!=0 || mapping->verticalBorder()!=0 ))
 		{
 			Debug(_log, "Reset border");
 			_borderProcessor->process(image);
-			delete _imageToLeds;
-			_imageToLeds = new hyperion::ImageToLedsMap(image.width(), image.height(), 0, 0, _ledString.leds());
+			changeMapping(_mapCache.get(image.width(), image.height(), 0, 0, _ledString.leds()));
 		}
 
-		if(_borderProcessor->enabled() && _borderProcessor->process(image))
+		if(_borderProcessor->enabled() && _borderProcessor->processDetected(detectBorder(image, sharedFrame)))
 		{
 			const hyperion::BlackBorder border = _borderProcessor->getCurrentBorder();
 
-			// Clean up the old mapping
-			delete _imageToLeds;
-
 			if (border.unknown)
 			{
-				// Construct a new buffer and mapping
-				_imageToLeds = new hyperion::ImageToLedsMap(image.width(), image.height(), 0, 0, _ledString.leds());
+				// Take the mapping from the cache or construct a new one
+				changeMapping(_mapCache.get(image.width(), image.height(), 0, 0, _ledString.leds()));
 			}
 			else
 			{
-				// Construct a new buffer and mapping
-				_imageToLeds = new hyperion::ImageToLedsMap(image.width(), image.height(), border.horizontalSize, border.verticalSize, _ledString.leds());
+				// Take the mapping from the cache or construct a new one
+				changeMapping(_mapCache.get(image.width(), image.height(), border.horizontalSize, border.verticalSize, _ledString.leds()));
 			}
 
 			//Debug(Logger::getInstance("BLACKBORDER"),  "CURRENT BORDER TYPE: unknown=%d hor.size=%d vert.size=%d",
@@ -214,6 +322,30 @@ private:
 		}
 	}
 
+	///
+	/// Switches to the mapping of a new border. When the grabbers convert only the pixels of the
+	/// current mapping, the image being processed lacks the pixels of the new one. It is applied
+	/// to the next image then, which is converted for the new mapping.
+	///
+	/// @param[in] imageToLeds  The new mapping
+	///
+	void changeMapping(std::shared_ptr<const hyperion::ImageToLedsMap> imageToLeds);
+
+	///
+	/// Makes a mapping deferred by changeMapping() the current one, once an image converted for
+	/// it arrives. Images converted earlier (queued or decoded in parallel) keep the current one.
+	///
+	/// @param[in] sampleGeneration  The sample mask generation of the image, see Image::sampleGeneration()
+	///
+	void applyNextMapping(uint64_t sampleGeneration);
+
+	///
+	/// Publishes the pixels read by the mapping and the black border detection to the grabbers,
+	/// if the mapping, its type or the detection changed since the last call. Unicolor and
+	/// summed-area table mappings read the whole image.
+	///
+	void updateSampleDemand();
+
 private slots:
 	void handleSettingsUpdate(settings::type type, const QJsonDocument& config);
 
@@ -226,7 +358,19 @@ private:
 	hyperion::BlackBorderProcessor * _borderProcessor;
 
 	/// The mapping of image-pixels to LEDs
-	hyperion::ImageToLedsMap* _imageToLeds;
+	std::shared_ptr<const hyperion::ImageToLedsMap> _imageToLeds;
+
+	/// The mapping which becomes current with the next image, see changeMapping()
+	std::shared_ptr<const hyperion::ImageToLedsMap> _nextImageToLeds;
+
+	/// Recently used mappings by geometry and border
+	hyperion::ImageToLedsMapCache _mapCache;
+
+	/// The summed-area table of the current image (multicolor_mean_integral mapping)
+	hyperion::IntegralImage _integralImage;
+
+	/// The summed-area table of the current image, if shared with other instances
+	std::shared_ptr<const hyperion::IntegralImage> _sharedIntegralImage;
 
 	/// Type of image 2 led mapping
 	int _mappingType;
@@ -237,4 +381,12 @@ private:
 
 	/// Hyperion instance pointer
 	Hyperion* _hyperion;
+
+	/// The state the published sample demand was created from
+	std::shared_ptr<const hyperion::ImageToLedsMap> _demandMapping;
+	int _demandMappingType;
+	bool _demandBorderDetection;
+	bool _demandOutdated;
+	/// The generation of the sample demand including the published state, see SampleDemand::generation()
+	uint64_t _demandGeneration;
 };
@@ -4,6 +4,8 @@
 // STL includes
 #include <cassert>
 #include <sstream>
+#include <cstdint>
+#include <vector>
 
 // hyperion-utils includes
 #include <utils/Image.h>
@@ -11,12 +13,81 @@
 
 // hyperion includes
 #include <hyperion/LedString.h>
+#include <hyperion/IntegralImage.h>
 
 namespace hyperion
 {
+	///
+	/// Horizontal run of pixels [xBegin, xEnd) in row 'row' of an image
+	///
+	struct LedSpan
+	{
+		unsigned row;
+		unsigned xBegin;
+		unsigned xEnd;
+	};
+
+	///
+	/// The image area of a single led, given as a range in the span table of the map
+	///
+	struct LedArea
+	{
+		/// Index of the first span of the led
+		unsigned firstSpan;
+		/// Number of spans (rows) of the led
+		unsigned spanCount;
+		/// Number of pixels covered by all spans of the led
+		unsigned pixelCount;
+	};
+
+	///
+	/// Sum per color-channel over a number of pixels
+	///
+	struct ColorSum
+	{
+		uint64_t red;
+		uint64_t green;
+		uint64_t blue;
+	};
+
+	///
+	/// Adds the channels of all pixels covered by the given spans of an RGB image to the sum.
+	/// The summation kernel (AVX2, SSE2, NEON or scalar) is selected once at runtime based on
+	/// the CPU features.
+	///
+	/// @param[in] image     Pointer to the first pixel of the image
+	/// @param[in] stride    The distance between the rows of the image in bytes
+	/// @param[in] spans     The spans to sum up
+	/// @param[in] spanCount Number of spans
+	/// @param[in,out] sum   The sum to add the channels to
+	///
+	void accumulateColors(const ColorRgb* image, size_t stride, const LedSpan* spans, size_t spanCount, ColorSum& sum);
 
 	///
-	/// The ImageToLedsMap holds a mapping of indices into an image to leds. It can be used to
+	/// Adds the channels of all pixels covered by the given spans to the sum (generic pixel types)
+	///
+	template <typename Pixel_T>
+	inline void accumulateColors(const Pixel_T* image, size_t stride, const LedSpan* spans, size_t spanCount, ColorSum& sum)
+	{
+		for (const LedSpan* end = spans + spanCount; spans != end; ++spans)
+		{
+			const Pixel_T* pixel = reinterpret_cast<const Pixel_T*>(reinterpret_cast<const uint8_t*>(image) + spans->row * stride) + spans->xBegin;
+			for (const Pixel_T* rowEnd = pixel + (spans->xEnd - spans->xBegin); pixel != rowEnd; ++pixel)
+			{
+				sum.red   += pixel->red;
+				sum.green += pixel->green;
+				sum.blue  += pixel->blue;
+			}
+		}
+	}
+
+	///
+	/// @return The name of the summation kernel selected for this CPU
+	///
+	const char* accumulateColorsKernelName();
+
+	///
+	/// The ImageToLedsMap holds a mapping of row spans of an image to leds. It can be used to
 	/// calculate the average (or mean) color per led for a specific region.
 	///
 	class ImageToLedsMap
@@ -24,9 +95,9 @@ namespace hyperion
 	public:
 
 		///
-		/// Constructs an mapping from the absolute indices in an image to each led based on the border
-		/// definition given in the list of leds. The map holds absolute indices to any given image,
-		/// provided that it is row-oriented.
+		/// Constructs an mapping from the rows of an image to each led based on the border
+		/// definition given in the list of leds. The map holds row spans (row, xBegin, xEnd) per led,
+		/// valid for any given image of the same size, provided that it is row-oriented.
 		/// The mapping is created purely on size (width and height). The given borders are excluded
 		/// from indexing.
 		///
@@ -60,6 +131,53 @@ namespace hyperion
 		unsigned horizontalBorder() const { return _horizontalBorder; }
 		unsigned verticalBorder() const { return _verticalBorder; }
 
+		///
+		/// Returns the number of pixels covered by all leds, overlapping areas are counted per led
+		///
+		/// @return The total mapped area [pixels]
+		///
+		uint64_t mappedPixelCount() const { return _mappedPixelCount; }
+
+		///
+		/// Estimates if the mean colors are cheaper taken from a summed-area table than summed up
+		/// from the spans, see INTEGRAL_COST_PER_PIXEL
+		///
+		/// @return True if building the table costs less than summing the mapped pixels
+		///
+		bool preferIntegralImage() const
+		{
+			return _mappedPixelCount > INTEGRAL_COST_PER_PIXEL * uint64_t(_width) * _height;
+		}
+
+		///
+		/// Returns the pixel runs of all leds, in image coordinates (border included)
+		///
+		const std::vector<LedSpan>& spans() const { return _spans; }
+
+		///
+		/// Determines the mean color for each led from the summed-area table of an image with the
+		/// size given at construction. Each led costs four lookups, independent of its area.
+		///
+		/// @param[in] integral  The summed-area table of the image
+		///
+		/// @return ledColors  The vector containing the output
+		///
+		std::vector<ColorRgb> getIntegralLedColor(const IntegralImage & integral) const
+		{
+			std::vector<ColorRgb> colors(_ledAreas.size(), ColorRgb{0,0,0});
+			getIntegralLedColor(integral, colors);
+			return colors;
+		}
+
+		///
+		/// Determines the mean color for each led from the summed-area table of an image with the
+		/// size given at construction. Each led costs four lookups, independent of its area.
+		///
+		/// @param[in] integral  The summed-area table of the image
+		/// @param[out] ledColors  The vector containing the output
+		///
+		void getIntegralLedColor(const IntegralImage & integral, std::vector<ColorRgb> & ledColors) const;
+
 		///
 		/// Determines the mean color for each led using the mapping the image given
 		/// at construction.
@@ -71,7 +189,7 @@ namespace hyperion
 		template <typename Pixel_T>
 		std::vector<ColorRgb> getMeanLedColor(const Image<Pixel_T> & image) const
 		{
-			std::vector<ColorRgb> colors(_colorsMap.size(), ColorRgb{0,0,0});
+			std::vector<ColorRgb> colors(_ledAreas.size(), ColorRgb{0,0,0});
 			getMeanLedColor(image, colors);
 			return colors;
 		}
@@ -87,18 +205,18 @@ namespace hyperion
 		void getMeanLedColor(const Image<Pixel_T> & image, std::vector<ColorRgb> & ledColors) const
 		{
 			// Sanity check for the number of leds
-			//assert(_colorsMap.size() == ledColors.size());
-			if(_colorsMap.size() != ledColors.size())
+			//assert(_ledAreas.size() == ledColors.size());
+			if(_ledAreas.size() != ledColors.size())
 			{
-				Debug(Logger::getInstance("HYPERION"), "ImageToLedsMap: colorsMap.size != ledColors.size -> %d != %d", _colorsMap.size(), ledColors.size());
+				Debug(Logger::getInstance("HYPERION"), "ImageToLedsMap: colorsMap.size != ledColors.size -> %d != %d", _ledAreas.size(), ledColors.size());
 				return;
 			}
 
 			// Iterate each led and compute the mean
 			auto led = ledColors.begin();
-			for (auto colors = _colorsMap.begin(); colors != _colorsMap.end(); ++colors, ++led)
+			for (auto area = _ledAreas.begin(); area != _ledAreas.end(); ++area, ++led)
 			{
-				const ColorRgb color = calcMeanColor(image, *colors);
+				const ColorRgb color = calcMeanColor(image, *area);
 				*led = color;
 			}
 		}
@@ -114,7 +232,7 @@ namespace hyperion
 		template <typename Pixel_T>
 		std::vector<ColorRgb> getUniLedColor(const Image<Pixel_T> & image) const
 		{
-			std::vector<ColorRgb> colors(_colorsMap.size(), ColorRgb{0,0,0});
+			std::vector<ColorRgb> colors(_ledAreas.size(), ColorRgb{0,0,0});
 			getUniLedColor(image, colors);
 			return colors;
 		}
@@ -130,10 +248,10 @@ namespace hyperion
 		void getUniLedColor(const Image<Pixel_T> & image, std::vector<ColorRgb> & ledColors) const
 		{
 			// Sanity check for the number of leds
-			// assert(_colorsMap.size() == ledColors.size());
-			if(_colorsMap.size() != ledColors.size())
+			// assert(_ledAreas.size() == ledColors.size());
+			if(_ledAreas.size() != ledColors.size())
 			{
-				Debug(Logger::getInstance("HYPERION"), "ImageToLedsMap: colorsMap.size != ledColors.size -> %d != %d", _colorsMap.size(), ledColors.size());
+				Debug(Logger::getInstance("HYPERION"), "ImageToLedsMap: colorsMap.size != ledColors.size -> %d != %d", _ledAreas.size(), ledColors.size());
 				return;
 			}
 
@@ -153,46 +271,56 @@ namespace hyperion
 
 		const unsigned _verticalBorder;
 
-		/// The absolute indices into the image for each led
-		std::vector<std::vector<unsigned>> _colorsMap;
+		/// Minimum span width [pixels] for the vectorized summation
+		static const unsigned MIN_VECTOR_SPAN = 16;
+
+		/// Cost of building the summed-area table per image pixel in units of the vectorized span
+		/// summation per mapped pixel. Measured by hyperion-bench as the ratio of
+		/// "integral/build" to "image2leds/mean-overlapping" (about 3 ns to 0.8 ns at 1080p).
+		static const unsigned INTEGRAL_COST_PER_PIXEL = 4;
+
+		/// The row spans of all leds
+		std::vector<LedSpan> _spans;
+
+		/// The range of spans for each led
+		std::vector<LedArea> _ledAreas;
+
+		/// The sum of the pixel counts of all leds
+		uint64_t _mappedPixelCount;
 
 		///
-		/// Calculates the 'mean color' of the given list. This is the mean over each color-channel
+		/// Calculates the 'mean color' of the given led area. This is the mean over each color-channel
 		/// (red, green, blue)
 		///
 		/// @param[in] image The image a section from which an average color must be computed
-		/// @param[in] colors  The list with colors
+		/// @param[in] area  The spans of the led
 		///
 		/// @return The mean of the given list of colors (or black when empty)
 		///
 		template <typename Pixel_T>
-		ColorRgb calcMeanColor(const Image<Pixel_T> & image, const std::vector<unsigned> & colors) const
+		ColorRgb calcMeanColor(const Image<Pixel_T> & image, const LedArea & area) const
 		{
-			const auto colorVecSize = colors.size();
-
-			if (colorVecSize == 0)
+			if (area.pixelCount == 0)
 			{
 				return ColorRgb::BLACK;
 			}
 
-			// Accumulate the sum of each separate color channel
-			uint_fast32_t cummRed   = 0;
-			uint_fast32_t cummGreen = 0;
-			uint_fast32_t cummBlue  = 0;
-			const auto& imgData = image.memptr();
-
-			for (const unsigned colorOffset : colors)
+			// Accumulate the sum of each separate color channel. Leds narrower than a vector
+			// register are summed inline, as the kernel setup would outweigh the gain.
+			ColorSum sum {0, 0, 0};
+			if (area.pixelCount < area.spanCount * MIN_VECTOR_SPAN)
+			{
+				accumulateColors<Pixel_T>(image.memptr(), image.stride(), _spans.data() + area.firstSpan, area.spanCount, sum);
+			}
+			else
 			{
-				const auto& pixel = imgData[colorOffset];
-				cummRed   += pixel.red;
-				cummGreen += pixel.green;
-				cummBlue  += pixel.blue;
+				accumulateColors(image.memptr(), image.stride(), _spans.data() + area.firstSpan, area.spanCount, sum);
 			}
 
 			// Compute the average of each color channel
-			const uint8_t avgRed   = uint8_t(cummRed/colorVecSize);
-			const uint8_t avgGreen = uint8_t(cummGreen/colorVecSize);
-			const uint8_t avgBlue  = uint8_t(cummBlue/colorVecSize);
+			const uint8_t avgRed   = uint8_t(sum.red/area.pixelCount);
+			const uint8_t avgGreen = uint8_t(sum.green/area.pixelCount);
+			const uint8_t avgBlue  = uint8_t(sum.blue/area.pixelCount);
 
 			// Return the computed color
 			return {avgRed, avgGreen, avgBlue};
@@ -210,25 +338,27 @@ namespace hyperion
 		ColorRgb calcMeanColor(const Image<Pixel_T> & image) const
 		{
 			// Accumulate the sum of each separate color channel
-			uint_fast32_t cummRed   = 0;
-			uint_fast32_t cummGreen = 0;
-			uint_fast32_t cummBlue  = 0;
+			// The whole image is a single span of a row-oriented image, unless the rows are padded
+			ColorSum sum {0, 0, 0};
 			const unsigned imageSize = image.width() * image.height();
-
-			const auto& imgData = image.memptr();
-
-			for (unsigned idx=0; idx<imageSize; idx++)
+			if (image.stride() == image.width() * sizeof(Pixel_T))
+			{
+				const LedSpan span {0, 0, imageSize};
+				accumulateColors(image.memptr(), 0, &span, 1, sum);
+			}
+			else
 			{
-				const auto& pixel = imgData[idx];
-				cummRed   += pixel.red;
-				cummGreen += pixel.green;
-				cummBlue  += pixel.blue;
+				for (unsigned y = 0; y < image.height(); ++y)
+				{
+					const LedSpan span {y, 0, image.width()};
+					accumulateColors(image.memptr(), image.stride(), &span, 1, sum);
+				}
 			}
 
 			// Compute the average of each color channel
-			const uint8_t avgRed   = uint8_t(cummRed/imageSize);
-			const uint8_t avgGreen = uint8_t(cummGreen/imageSize);
-			const uint8_t avgBlue  = uint8_t(cummBlue/imageSize);
+			const uint8_t avgRed   = uint8_t(sum.red/imageSize);
+			const uint8_t avgGreen = uint8_t(sum.green/imageSize);
+			const uint8_t avgBlue  = uint8_t(sum.blue/imageSize);
 
 			// Return the computed color
 			return {avgRed, avgGreen, avgBlue};
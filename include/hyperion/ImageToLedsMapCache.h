@@ -0,0 +1,98 @@
+#pragma once
+
+// STL includes
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+// hyperion includes
+#include <hyperion/ImageToLedsMap.h>
+#include <hyperion/LedString.h>
+
+namespace hyperion
+{
+
+	///
+	/// Least recently used cache of immutable ImageToLedsMap instances. A map is identified by the
+	/// image size, the black border and a hash of the led layout, so switching back to a recently
+	/// used geometry (e.g. letterbox detection flipping or grabbers of different size) does not
+	/// rebuild the map.
+	///
+	class ImageToLedsMapCache
+	{
+	public:
+		///
+		/// @param[in] capacity  Maximum number of maps held by the cache
+		///
+		explicit ImageToLedsMapCache(size_t capacity = 8);
+
+		///
+		/// Get the map for the given geometry, it is created and added to the cache if not found
+		///
+		/// @param[in] width            The width of the indexed image
+		/// @param[in] height           The height of the indexed image
+		/// @param[in] horizontalBorder The size of the horizontal border (0=no border)
+		/// @param[in] verticalBorder   The size of the vertical border (0=no border)
+		/// @param[in] leds             The list with led specifications
+		///
+		/// @return The (shared) map
+		///
+		std::shared_ptr<const ImageToLedsMap> get(
+				unsigned width,
+				unsigned height,
+				unsigned horizontalBorder,
+				unsigned verticalBorder,
+				const std::vector<Led> & leds);
+
+		///
+		/// Remove all maps from the cache, the counters are kept
+		///
+		void clear();
+
+		/// @return Number of requests answered from the cache
+		uint64_t hits() const { return _hits; }
+
+		/// @return Number of requests which created a new map
+		uint64_t misses() const { return _misses; }
+
+		/// @return Number of maps currently held
+		size_t size() const { return _size; }
+
+		/// @return Maximum number of maps held
+		size_t capacity() const { return _capacity; }
+
+		///
+		/// Calculates a hash over the scan areas of the given leds
+		///
+		/// @param[in] leds  The list with led specifications
+		///
+		/// @return The hash of the layout
+		///
+		static uint64_t layoutHash(const std::vector<Led> & leds);
+
+	private:
+		struct Entry
+		{
+			unsigned width;
+			unsigned height;
+			unsigned horizontalBorder;
+			unsigned verticalBorder;
+			uint64_t layoutHash;
+			std::shared_ptr<const ImageToLedsMap> map;
+		};
+
+		/// Maximum number of maps
+		const size_t _capacity;
+
+		/// Cached maps, most recently used first
+		std::list<Entry> _entries;
+
+		/// Statistics, may be read from other threads
+		std::atomic<uint64_t> _hits;
+		std::atomic<uint64_t> _misses;
+		std::atomic<size_t> _size;
+	};
+
+} // end namespace hyperion
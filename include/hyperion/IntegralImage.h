@@ -0,0 +1,130 @@
+#pragma once
+
+// STL includes
+#include <cstdint>
+#include <vector>
+
+// hyperion-utils includes
+#include <utils/Image.h>
+
+namespace hyperion
+{
+
+	///
+	/// The IntegralImage (summed-area table) holds for each position the per channel sum of all
+	/// pixels above and left of it. The sum over any rectangle of the source image is then
+	/// available with four lookups, independent of the size of the rectangle.
+	///
+	/// The sums are held in 32 bit per channel, which limits the source image to 16843009 pixels
+	/// (255 * pixels must fit into 32 bit). Larger images leave the table invalid.
+	///
+	class IntegralImage
+	{
+	public:
+		/// Per channel sums of a table entry
+		struct Entry
+		{
+			uint32_t red;
+			uint32_t green;
+			uint32_t blue;
+		};
+
+		/// Maximum number of pixels an image may have to be summed up without overflow
+		static const uint64_t MAX_PIXELS = UINT32_MAX / 255;
+
+		IntegralImage()
+			: _width(0)
+			, _height(0)
+			, _valid(false)
+		{
+		}
+
+		///
+		/// Rebuilds the table from the given image. The buffer is only reallocated on size changes.
+		///
+		/// @param[in] image  The image to build the table from
+		///
+		template <typename Pixel_T>
+		void update(const Image<Pixel_T> & image)
+		{
+			const unsigned width  = image.width();
+			const unsigned height = image.height();
+
+			_valid = (uint64_t(width) * height <= MAX_PIXELS);
+			if (!_valid)
+			{
+				return;
+			}
+
+			if (width != _width || height != _height)
+			{
+				_width  = width;
+				_height = height;
+				// the first row and column stay zero, so lookups need no bounds checks
+				_table.assign(size_t(_width + 1) * (_height + 1), Entry{0, 0, 0});
+			}
+
+			const size_t stride = _width + 1;
+			for (unsigned y = 0; y < _height; ++y)
+			{
+				const Pixel_T* pixel = image.row(y);
+				const Entry* above = _table.data() + size_t(y) * stride + 1;
+				Entry* current = _table.data() + size_t(y + 1) * stride + 1;
+
+				uint32_t red = 0, green = 0, blue = 0;
+				for (unsigned x = 0; x < _width; ++x, ++pixel)
+				{
+					red   += pixel->red;
+					green += pixel->green;
+					blue  += pixel->blue;
+
+					current[x].red   = above[x].red   + red;
+					current[x].green = above[x].green + green;
+					current[x].blue  = above[x].blue  + blue;
+				}
+			}
+		}
+
+		///
+		/// Get the sum of all pixels of the rectangle [x0, x1) x [y0, y1) of the last image
+		///
+		/// @param[in] x0  First column
+		/// @param[in] y0  First row
+		/// @param[in] x1  Column after the last column
+		/// @param[in] y1  Row after the last row
+		///
+		/// @return The sum per channel
+		///
+		Entry sum(unsigned x0, unsigned y0, unsigned x1, unsigned y1) const
+		{
+			const size_t stride = _width + 1;
+			const Entry& a = _table[size_t(y0) * stride + x0];
+			const Entry& b = _table[size_t(y0) * stride + x1];
+			const Entry& c = _table[size_t(y1) * stride + x0];
+			const Entry& d = _table[size_t(y1) * stride + x1];
+
+			// unsigned wrap around cancels out, the result is always in range
+			return { d.red - b.red - c.red + a.red, d.green - b.green - c.green + a.green, d.blue - b.blue - c.blue + a.blue };
+		}
+
+		/// @return true if the table holds the sums of the last image
+		bool valid() const { return _valid; }
+
+		/// @return The width of the last image
+		unsigned width() const { return _width; }
+
+		/// @return The height of the last image
+		unsigned height() const { return _height; }
+
+	private:
+		/// The width of the summed image
+		unsigned _width;
+		/// The height of the summed image
+		unsigned _height;
+		/// True if the last image could be summed up
+		bool _valid;
+		/// (width+1) * (height+1) entries, the first row and column are zero
+		std::vector<Entry> _table;
+	};
+
+} // end namespace hyperion
@@ -2,6 +2,7 @@
 #pragma once
 
 // STL includes
+#include <cstdint>
 #include <ctime>
 #include <vector>
 
@@ -101,6 +102,23 @@ struct Led
 	ColorOrder colorOrder;
 };
 
+///
+/// A run of consecutive leds sharing the same color order. Output byte i of a led is taken
+/// from the input channel channel[i] (0=red, 1=green, 2=blue).
+///
+struct ColorOrderRun
+{
+	/// Index of the first led
+	size_t begin;
+	/// Index after the last led
+	size_t end;
+	/// Source channel per output byte
+	uint8_t channel[3];
+
+	/// @return True if the run keeps the rgb order
+	bool isIdentity() const { return channel[0] == 0 && channel[1] == 1 && channel[2] == 2; }
+};
+
 ///
 /// The LedString contains the image integration information of the leds
 ///
@@ -121,6 +139,13 @@ public:
 	///
 	const std::vector<Led>& leds() const;
 
+	///
+	/// Returns the color orders of the leds, combined to runs of leds with the same order
+	///
+	/// @return The runs covering all leds in index order
+	///
+	std::vector<ColorOrderRun> colorOrderRuns() const;
+
 private:
 	/// The list with led specifications
 	std::vector<Led> mLeds;
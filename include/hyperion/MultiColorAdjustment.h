@@ -8,6 +8,7 @@
 // Hyperion includes
 #include <utils/ColorRgb.h>
 #include <hyperion/ColorAdjustment.h>
+#include <hyperion/LedString.h>
 
 ///
 /// The LedColorTransform is responsible for performing color transformation from 'raw' colors
@@ -32,6 +33,12 @@ public:
 
 	void setBacklightEnabled(bool enable);
 
+	///
+	/// Prepares the lookup tables of all ColorAdjustment, must be called after an adjustment was
+	/// changed. Added adjustments are prepared by addAdjustment().
+	///
+	void updateAdjustments();
+
 	///
 	/// Returns the identifier of all the unique ColorAdjustment
 	///
@@ -54,7 +61,31 @@ public:
 	///
 	void applyAdjustment(std::vector<ColorRgb>& ledColors);
 
+	///
+	/// Performs the color adjustment from raw-color to led-color and corrects the color byte
+	/// order in the same pass
+	///
+	/// @param ledColors The list with raw colors
+	/// @param colorOrderRuns The color order of the leds, see LedString::colorOrderRuns()
+	///
+	void applyAdjustment(std::vector<ColorRgb>& ledColors, const std::vector<ColorOrderRun>& colorOrderRuns);
+
 private:
+	///
+	/// Fills the channel table of the adjustment from its channel adjustments and brightness
+	///
+	/// @param adjustment The ColorAdjustment to prepare
+	///
+	static void updateChannelTable(ColorAdjustment * adjustment);
+
+	///
+	/// Adjusts a single color
+	///
+	/// @param adjustment The ColorAdjustment of the led
+	/// @param color The color, updated in place
+	///
+	static void adjustColor(ColorAdjustment * adjustment, ColorRgb & color);
+
 	/// List with transform ids
 	QStringList _adjustmentIds;
 
@@ -3,6 +3,8 @@
 // STL includes
 #include <vector>
 #include <cstdint>
+#include <memory>
+#include <utility>
 
 // QT includes
 #include <QMap>
@@ -52,8 +54,63 @@ public:
 		unsigned smooth_cfg;
 		/// specific owner description
 		QString owner;
+		/// The capture time of the image or the arrival of the led colors, see LatencyTracker::now()
+		int64_t captureTime;
 	};
 
+	///
+	/// Immutable state of all priority channels, published by the muxer after each change.
+	/// Readers of any thread get the latest snapshot with getSnapshot() and may keep it as long as they need,
+	/// unchanged channels are shared between the snapshots.
+	///
+	class Snapshot
+	{
+	public:
+		/// The visible priority
+		int currentPriority;
+		/// The previous visible priority
+		int previousPriority;
+		/// The state of source auto selection
+		bool sourceAutoSelectEnabled;
+
+		///
+		/// @brief Check if a priority channel exists (the lowest priority always exists)
+		/// @param priority  The priority channel
+		/// @return True if the priority channel exists else false
+		///
+		bool hasPriority(int priority) const;
+
+		///
+		/// @brief Get all priorities in ascending order
+		/// @return The list with active priorities
+		///
+		QList<int> getPriorities() const;
+
+		///
+		/// @brief Get the information of a priority channel, the lowest priority channel if it is not available
+		/// @param priority  The priority channel
+		/// @return The information, valid as long as the snapshot
+		///
+		const InputInfo& getInputInfo(int priority) const;
+
+		///
+		/// @brief Get all channels in ascending order of their priority
+		/// @return The channels, valid as long as the snapshot
+		///
+		const std::vector<std::shared_ptr<InputInfo>>& getInputs() const { return _inputs; }
+
+	private:
+		friend class PriorityMuxer;
+
+		/// The channels by ascending priority, owned by the muxer until the snapshot is published
+		std::vector<std::shared_ptr<InputInfo>> _inputs;
+
+		/// The information of the lowest priority channel as fallback
+		std::shared_ptr<InputInfo> _lowestPriorityInfo;
+	};
+
+	using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
 	/// The lowest possible priority, which is used when no priority channels are active
 	const static int LOWEST_PRIORITY;
 
@@ -71,7 +128,7 @@ public:
 	~PriorityMuxer() override;
 
 	///
-	/// @brief Start/Stop the PriorityMuxer update timer; On disabled no priority and timeout updates will be performend
+	/// @brief Start/Stop the PriorityMuxer timeout timers; On disabled no timeout updates will be performed
 	/// @param  enable  The new state
 	///
 	void setEnable(bool enable);
@@ -140,6 +197,12 @@ public:
 	///
 	InputInfo getInputInfo(int priority) const;
 
+	///
+	/// @brief Get the latest state of all priority channels, can be called from any thread
+	/// @return The snapshot
+	///
+	SnapshotPtr getSnapshot() const { return std::atomic_load(&_snapshot); }
+
 	///
 	/// @brief  Register a new input by priority, the priority is not active (timeout -100 isn't muxer recognized) until you start to update the data with setInput()
 	/// 		A repeated call to update the base data of a known priority won't overwrite their current timeout
@@ -218,14 +281,9 @@ signals:
 	///
 	void prioritiesChanged();
 
-	///
-	/// internal used signal to resolve treading issues with timer
-	///
-	void signalTimeTrigger();
-
 private slots:
 	///
-	/// Slot which is called to adapt to 1s interval for signal timeRunner() / prioritiesChanged()
+	/// Slot which is called in 1s interval for signal timeRunner() / prioritiesChanged()
 	///
 	void timeTrigger();
 
@@ -235,7 +293,49 @@ private slots:
 	///
 	void setCurrentTime();
 
+	///
+	/// Slot which is called at the next timeout, clears the timed out channels and arms the timer for the following one
+	///
+	void handleTimeouts();
+
 private:
+	///
+	/// @brief Add the timeout of a channel to the deadlines and arm the timer if it is the next one
+	/// @param priority    The priority of the channel
+	/// @param timeout_ms  The absolute timeout, no deadline is added for timeouts <= 0
+	///
+	void scheduleTimeout(int priority, int64_t timeout_ms);
+
+	///
+	/// @brief Drop the outdated deadlines and arm the timer for the next valid one (or stop it)
+	///
+	void armTimeoutTimer();
+
+	///
+	/// @brief Start the 1s interval of timeRunner() for an effect or color with a timeout
+	/// @param input  The updated channel
+	///
+	void startTimeRunner(const InputInfo& input);
+
+	///
+	/// @brief Check if a channel is a running effect or color with a timeout (reported by timeRunner())
+	/// @param input  The channel
+	/// @return True if the channel is reported
+	///
+	static bool isTimedInput(const InputInfo& input);
+
+	///
+	/// @brief Mark a channel as changed for the next snapshot
+	/// @param priority  The priority of the channel
+	///
+	void inputChanged(int priority);
+
+	///
+	/// @brief Publish a new snapshot if anything changed since the last one. Has to be called before
+	///        the signals are emitted, receivers read the snapshot.
+	///
+	void publishSnapshot();
+
 	///
 	/// @brief Get the component of the given priority
 	/// @return The component
@@ -266,9 +366,35 @@ private:
 	// Reflect the state of auto select
 	bool _sourceAutoSelectEnabled;
 
-	// Timer to update Muxer times independent
-	QTimer* _updateTimer;
+	// Reflect the state of the timeout handling, see setEnable()
+	bool _enabled;
+
+	/// The absolute timeouts with their priority as min-heap. A deadline is outdated when its channel was
+	/// cleared or got another timeout meanwhile, those are dropped when reaching the top.
+	std::vector<std::pair<int64_t, int>> _deadlines;
+
+	/// Single shot timer for the next deadline
+	QTimer* _timeoutTimer;
+
+	/// The deadline _timeoutTimer is armed for
+	int64_t _armedDeadline;
 
+	/// Timer of the 1s interval of timeRunner()
 	QTimer* _timer;
-	QTimer* _blockTimer;
+
+	/// The published snapshot, accessed atomically
+	SnapshotPtr _snapshot;
+
+	/// The published snapshot and its predecessor, the latter is reused once no reader holds it anymore
+	std::shared_ptr<Snapshot> _currentSnapshot;
+	std::shared_ptr<Snapshot> _spareSnapshot;
+
+	/// Channels of the reused snapshot, reused as well if not shared with the current one
+	std::vector<std::shared_ptr<InputInfo>> _spareInputs;
+
+	/// The priorities of the channels changed since the last snapshot
+	std::vector<int> _changedInputs;
+
+	/// Any change since the last snapshot, including removed channels and the visible priority
+	bool _snapshotOutdated;
 };
@@ -0,0 +1,103 @@
+#pragma once
+
+// STL includes
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// QT includes
+#include <QMutex>
+#include <QString>
+
+// hyperion includes
+#include <utils/Image.h>
+#include <utils/ColorRgb.h>
+#include <blackborder/BlackBorderDetector.h>
+#include <hyperion/IntegralImage.h>
+
+namespace hyperion
+{
+
+	///
+	/// Per frame analysis shared by all instances showing the same captured image.
+	///
+	/// The system and USB grabbers broadcast each frame to every instance. The instances receive
+	/// copies of the same image (sharing the pixel buffer), so the black border detection (per
+	/// detection settings) and the summed-area table only have to be computed by the first
+	/// instance processing the frame. The others take the immutable, shared result.
+	///
+	/// A frame is identified by its pixel buffer. The stage keeps a reference to the recently
+	/// analysed images, so their buffers can neither be freed and reused for another frame nor be
+	/// written (copy on write) while an entry exists.
+	///
+	class SharedFrameStage
+	{
+	public:
+		static SharedFrameStage* getInstance()
+		{
+			static SharedFrameStage instance;
+			return & instance;
+		}
+
+		SharedFrameStage(SharedFrameStage const&)  = delete;
+		void operator=(SharedFrameStage const&) = delete;
+
+		///
+		/// @brief Get the black border of a frame, it is detected by the first caller
+		/// @param image         The frame
+		/// @param detectionKey  Identifies the detection settings (mode and threshold)
+		/// @param detect        Detects the border, called at most once per frame and key
+		/// @return The detected border
+		///
+		BlackBorder blackBorder(const Image<ColorRgb>& image, const QString& detectionKey, const std::function<BlackBorder()>& detect);
+
+		///
+		/// @brief Get the summed-area table of a frame, it is built by the first caller
+		/// @param image  The frame
+		/// @return The table, nullptr if the image is too large for a table
+		///
+		std::shared_ptr<const IntegralImage> integralImage(const Image<ColorRgb>& image);
+
+		/// @return Number of requests answered with the result of another instance
+		uint64_t hits() const { return _hits; }
+
+		/// @return Number of requests which computed the result
+		uint64_t misses() const { return _misses; }
+
+		/// Number of frames kept for the instances lagging behind
+		static constexpr size_t CAPACITY = 4;
+
+	private:
+		SharedFrameStage() = default;
+
+		struct Frame
+		{
+			/// Keeps the pixel buffer and with it the identity of the frame
+			Image<ColorRgb> image;
+			/// Serializes the computation of the results of this frame
+			QMutex mutex;
+			/// Border per detection key
+			std::vector<std::pair<QString, BlackBorder>> borders;
+			/// The summed-area table, if requested
+			std::shared_ptr<IntegralImage> integral;
+		};
+
+		/// Find or add the entry of a frame
+		std::shared_ptr<Frame> frame(const Image<ColorRgb>& image);
+
+		QMutex _mutex;
+
+		/// Recently analysed frames, most recent first
+		std::vector<std::shared_ptr<Frame>> _frames;
+
+		/// Tables of evicted frames, rebuilt for new frames to avoid reallocations
+		std::vector<std::shared_ptr<IntegralImage>> _spareIntegrals;
+
+		/// Statistics, may be read from other threads
+		std::atomic<uint64_t> _hits{0};
+		std::atomic<uint64_t> _misses{0};
+	};
+
+} // end namespace hyperion
@@ -20,6 +20,7 @@
 #include <utils/ColorRgbw.h>
 #include <utils/RgbToRgbw.h>
 #include <utils/Logger.h>
+#include <utils/LatencyTracker.h>
 #include <functional>
 #include <utils/Components.h>
 
@@ -83,6 +84,23 @@ public:
 	///
 	void setRewriteTime(int rewriteTime_ms);
 
+	///
+	/// @brief Set a device's keep-alive time.
+	///
+	/// Keep-alive time is the time frame a device keeps its state without being written.
+	/// While the LED colors do not change, refreshes are done at the longer of keep-alive and rewrite time.
+	///
+	/// @param[in] keepAliveTime_ms Keep-alive time in milliseconds, 0 = rewrite time
+	///
+	void setKeepAliveTime(int keepAliveTime_ms);
+
+	///
+	/// @brief Set the latency tracker of the instance, the device records the frames handed over when writing them.
+	///
+	/// @param[in] latency The latency tracker, has to outlive the device
+	///
+	void setLatencyTracker(LatencyTracker* latency) { _latency = latency; }
+
 	///
 	/// @brief Discover devices of this type available (for configuration).
 	/// @note Mainly used for network devices. Allows to find devices, e.g. via ssdp, mDNS or cloud ways.
@@ -190,6 +208,13 @@ public slots:
 	///
 	int getRewriteTime() const { return _refreshTimerInterval_ms; }
 
+	///
+	/// @brief Get the time the device was idle, i.e. only refreshed unchanged colors.
+	///
+	/// @return Idle time since start in milliseconds
+	///
+	qint64 getIdleTime() const;
+
 	///
 	/// @brief Get the number of LEDs supported by the device.
 	///
@@ -263,6 +288,13 @@ signals:
 	///
 	void enableStateChanged(bool newState);
 
+	///
+	/// @brief Emits whenever the latch time of the LED-Device is updated.
+	///
+	/// @param[in] latchTime_ms The latch time in milliseconds
+	///
+	void latchTimeChanged(int latchTime_ms);
+
 protected:
 
 	///
@@ -381,9 +413,15 @@ protected:
 	/// Refresh interval in milliseconds
 	int _refreshTimerInterval_ms;
 
+	/// Refresh interval while the colors do not change in milliseconds, 0 = refresh interval
+	int _keepAliveInterval_ms;
+
 	/// Time a device requires mandatorily between two writes (in milliseconds)
 	int _latchTime_ms;
 
+	/// Latency tracker of the instance, nullptr if the frames are not traced
+	LatencyTracker* _latency;
+
 	/// Number of hardware LEDs supported by device.
 	uint _ledCount;
 	uint _ledRGBCount;
@@ -441,6 +479,13 @@ private:
 	/// @brief Stop refresh cycle
 	void stopRefreshTimer();
 
+	///
+	/// @brief Switch between refreshing at the rewrite and the keep-alive interval
+	///
+	/// @param[in] idle True, if the colors did not change for a refresh interval
+	///
+	void setIdle(bool idle);
+
 	/// Is last write refreshing enabled?
 	bool	_isRefreshEnabled;
 
@@ -450,6 +495,13 @@ private:
 
 	/// Last LED values written
 	std::vector<ColorRgb> _lastLedValues;
+
+	/// Is the device refreshed at the keep-alive interval?
+	bool _isIdle;
+
+	/// Start of the current idle period and the duration of the finished ones (in milliseconds)
+	qint64 _idleSince;
+	qint64 _idleTime_ms;
 };
 
 #endif // LEDEVICE_H
@@ -5,6 +5,7 @@
 #include <utils/Logger.h>
 #include <utils/ColorRgb.h>
 #include <utils/Components.h>
+#include <utils/SingleSlotBuffer.h>
 
 #include <QMutex>
 
@@ -52,6 +53,12 @@ public:
 	///
 	int getLatchTime() const;
 
+	///
+	/// @brief Get the time the ledDevice only refreshed unchanged colors
+	/// @ return idle time in ms
+	///
+	qint64 getIdleTime() const;
+
 	///
 	/// @brief Get the current active ledDevice type
 	///
@@ -72,6 +79,15 @@ public:
 	///
 	unsigned int getLedCount() const;
 
+	///
+	/// @brief Hands the led colors to the device thread without queuing an event with a copy of them.
+	/// 	   Colors not written by the device yet are replaced by newer ones. Thread safe, but only one
+	/// 	   thread may publish at a time.
+	///
+	/// @param[in] ledValues  The RGB-color per led
+	///
+	void publishLeds(const std::vector<ColorRgb>& ledValues);
+
 public slots:
 	///
 	/// @brief Handle new component state request
@@ -112,6 +128,18 @@ signals:
 
 	void stopLedDevice();
 
+	///
+	/// @brief Emits whenever the latch time of the LedDevice changes
+	///
+	/// @param[in] latchTime_ms The latch time in milliseconds
+	///
+	void latchTimeChanged(int latchTime_ms);
+
+	///
+	/// @brief Emits when published led colors are waiting to be taken by the device thread
+	///
+	void ledsPublished();
+
 private slots:
 	///
 	/// @brief Is called whenever the led device switches between on/off. The led device can disable it's component state
@@ -139,6 +167,8 @@ private:
 	LedDevice* _ledDevice;
 	// the enable state
 	bool _enabled;
+	// the latest published led colors
+	SingleSlotBuffer<std::vector<ColorRgb>> _publishedLeds;
 };
 
 #endif // LEDEVICEWRAPPER_H
@@ -0,0 +1,45 @@
+#pragma once
+
+///
+/// Runtime detection of the vector instruction sets used by the optimized image kernels.
+///
+/// Kernels for a specific instruction set are compiled with the HYPERION_TARGET_* attributes,
+/// so the rest of the build does not need any architecture flags. Callers check the matching
+/// CpuFeatures function once and keep a pointer to the selected kernel.
+///
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define HYPERION_SIMD_X86
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#define HYPERION_TARGET_SSE2
+		#define HYPERION_TARGET_SSSE3
+		#define HYPERION_TARGET_AVX2
+	#else
+		#define HYPERION_TARGET_SSE2  __attribute__((target("sse2")))
+		#define HYPERION_TARGET_SSSE3 __attribute__((target("ssse3")))
+		#define HYPERION_TARGET_AVX2  __attribute__((target("avx2")))
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define HYPERION_SIMD_NEON
+#endif
+
+namespace CpuFeatures {
+
+	/// @return true when the CPU supports SSE2
+	bool hasSSE2();
+
+	/// @return true when the CPU supports SSSE3
+	bool hasSSSE3();
+
+	/// @return true when the CPU and the OS support AVX2
+	bool hasAVX2();
+
+	/// @return true when NEON is available (compile time on ARM)
+	bool hasNEON();
+
+	///
+	/// @brief Get a readable list of the detected features, e.g. for log output
+	/// @return Space separated feature names or "none"
+	///
+	const char* featureString();
+}
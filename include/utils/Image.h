@@ -33,12 +33,33 @@ public:
 	{
 	}
 
+	///
+	/// Constructor for a read-only view of pixels owned by someone else, e.g. a capture buffer
+	/// of a grabber or the payload of a received message. No pixels are copied.
+	///
+	/// The view never outlives this image object: copying the image (e.g. to keep it as muxer
+	/// input or to pass it through a queued connection) or any write access first copies the
+	/// pixels into an own buffer. The memory has to stay valid as long as this object (or the
+	/// one it is moved to) exists.
+	///
+	/// @param pixels The first pixel
+	/// @param width The width of the image
+	/// @param height The height of the image
+	/// @param stride The distance between the rows in bytes (0 for width * sizeof(Pixel_T))
+	///
+	Image(const Pixel_T* pixels, unsigned width, unsigned height, size_t stride = 0) :
+		_d_ptr(new ImageData<Pixel_T>(pixels, width, height, stride != 0 ? stride : static_cast<size_t>(width) * sizeof(Pixel_T)))
+	{
+	}
+
 	///
 	/// Copy constructor for an image
 	/// @param other The image which will be copied
 	///
 	Image(const Image & other)
 	{
+		// a borrowed view is copied once, the copies share the own buffer
+		other.materialize();
 		_d_ptr = other._d_ptr;
 	}
 
@@ -152,7 +173,8 @@ public:
 	}
 
 	///
-	/// Returns a const memory pointer to the first pixel in the image
+	/// Returns a const memory pointer to the first pixel in the image. The rows are only packed,
+	/// if the image is not a borrowed view with a stride, see stride().
 	/// @return The const memory pointer to the first pixel
 	///
 	const Pixel_T* memptr() const
@@ -160,6 +182,81 @@ public:
 		return _d_ptr->memptr();
 	}
 
+	///
+	/// Returns a const memory pointer to the first pixel of a row
+	/// @param y The row
+	/// @return The const memory pointer to the first pixel of the row
+	///
+	const Pixel_T* row(unsigned y) const
+	{
+		return _d_ptr->row(y);
+	}
+
+	///
+	/// Returns the distance between the rows in bytes
+	///
+	size_t stride() const
+	{
+		return _d_ptr->stride();
+	}
+
+	///
+	/// Returns true, if the image is a view of memory owned by someone else
+	///
+	bool isBorrowed() const
+	{
+		return _d_ptr->isBorrowed();
+	}
+
+	///
+	/// Returns the monotonic time the frame was captured in microseconds, 0 if unknown. It is kept
+	/// by copies and conversions, see LatencyTracker.
+	///
+	int64_t captureTime() const
+	{
+		return _d_ptr->captureTime();
+	}
+
+	///
+	/// Sets the time the frame was captured, see LatencyTracker::now(). Like any write access it
+	/// detaches an image shared with copies.
+	/// @param captureTime The monotonic capture time in microseconds
+	///
+	void setCaptureTime(int64_t captureTime)
+	{
+		_d_ptr->setCaptureTime(captureTime);
+	}
+
+	///
+	/// Returns the generation of the SampleDemand mask the image was converted with, 0 if all
+	/// pixels are valid. Pixels outside the mask keep the content of a recycled buffer.
+	///
+	uint64_t sampleGeneration() const
+	{
+		return _d_ptr->sampleGeneration();
+	}
+
+	///
+	/// Sets the generation of the SampleDemand mask the image was converted with
+	/// @param sampleGeneration The generation, 0 if all pixels were converted
+	///
+	void setSampleGeneration(uint64_t sampleGeneration)
+	{
+		_d_ptr->setSampleGeneration(sampleGeneration);
+	}
+
+	///
+	/// Copies the pixels of a borrowed view into an own buffer, nothing happens for other images
+	///
+	void materialize() const
+	{
+		if (_d_ptr.constData() != nullptr && _d_ptr->isBorrowed())
+		{
+			// a borrowed view is never shared, see the copy constructor
+			const_cast<ImageData<Pixel_T>*>(_d_ptr.constData())->materialize();
+		}
+	}
+
 	///
 	/// Convert image of any color order to a RGB image.
 	///
@@ -171,7 +268,7 @@ public:
 	}
 
 	///
-	/// Get size of buffer
+	/// Get size of the pixels without row padding, a view may span more memory (see stride())
 	///
 	ssize_t size() const
 	{
@@ -0,0 +1,111 @@
+#pragma once
+
+// STL includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// QT includes
+#include <QMutex>
+
+///
+/// Recycles the pixel buffers of ImageData.
+///
+/// Every grabbed, streamed or rendered frame creates a new image of the same size. Instead of
+/// returning the multi-megabyte buffers to the system and faulting in fresh pages for the next
+/// frame, freed buffers are kept in size classes and handed out again. The retained memory is
+/// bounded, the least recently freed buffers are given back to the system first. Buffers below
+/// the pooling threshold (e.g. 1x1 placeholder images) are plain heap allocations.
+///
+class ImageBufferPool
+{
+public:
+	/// Counters of the pool
+	struct Statistics
+	{
+		/// Buffers allocated from the system
+		uint64_t allocations;
+		/// Buffers handed out again from the pool
+		uint64_t reuses;
+		/// Buffers returned to the system, because the pool was full
+		uint64_t evictions;
+		/// Number of buffers currently held by the pool
+		uint64_t retainedBuffers;
+		/// Bytes currently held by the pool
+		uint64_t retainedBytes;
+	};
+
+	static ImageBufferPool* getInstance()
+	{
+		// never destroyed, images with static storage duration may be released after main()
+		static ImageBufferPool* instance = new ImageBufferPool();
+		return instance;
+	}
+
+	ImageBufferPool(ImageBufferPool const&)  = delete;
+	void operator=(ImageBufferPool const&) = delete;
+
+	///
+	/// @brief Get a buffer of at least the given size, the content is undefined
+	/// @param[in]  bytes     The required size
+	/// @param[out] capacity  The real size of the buffer, has to be passed to release()
+	/// @return The buffer
+	///
+	void* acquire(size_t bytes, size_t& capacity);
+
+	///
+	/// @brief Give a buffer back to the pool
+	/// @param buffer    The buffer returned by acquire() (nullptr is ignored)
+	/// @param capacity  The capacity returned by acquire()
+	///
+	void release(void* buffer, size_t capacity);
+
+	///
+	/// @brief Limit the memory held by the pool, buffers exceeding the limit are freed
+	/// @param bytes  The maximum number of retained bytes (0 disables recycling)
+	///
+	void setMaxRetainedBytes(size_t bytes);
+
+	/// @return The current counters
+	Statistics statistics() const;
+
+	///
+	/// @brief The size class of a request, i.e. the capacity of the buffer handed out
+	/// @param bytes  The required size
+	/// @return The capacity
+	///
+	static size_t sizeClass(size_t bytes);
+
+	/// Requests below this size are not pooled
+	static constexpr size_t MIN_POOLED_BYTES = 64 * 1024;
+
+private:
+	ImageBufferPool() = default;
+
+	/// Frees the least recently released buffers until the limit is met, mutex has to be locked
+	void trim();
+
+	struct Buffer
+	{
+		void* data;
+		size_t capacity;
+	};
+
+	mutable QMutex _mutex;
+
+	/// Retained buffers, least recently released first
+	std::vector<Buffer> _free;
+
+	/// Maximum number of retained bytes
+	size_t _maxRetainedBytes = 64 * 1024 * 1024;
+	/// Maximum number of retained buffers
+	size_t _maxRetainedBuffers = 32;
+	/// Bytes currently retained
+	size_t _retainedBytes = 0;
+
+	/// Counters, may be read without the mutex
+	std::atomic<uint64_t> _allocations{0};
+	std::atomic<uint64_t> _reuses{0};
+	std::atomic<uint64_t> _evictions{0};
+};
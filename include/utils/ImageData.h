@@ -8,6 +8,7 @@
 #include <cassert>
 #include <type_traits>
 #include <utils/ColorRgb.h>
+#include <utils/ImageBufferPool.h>
 
 // QT includes
 #include <QSharedData>
@@ -21,24 +22,53 @@ typedef SSIZE_T ssize_t;
 template <typename Pixel_T>
 class ImageData : public QSharedData
 {
+	// the pixels live in recycled raw buffers of the ImageBufferPool
+	static_assert(std::is_trivially_copyable<Pixel_T>::value, "ImageData requires trivially copyable pixels");
+
 public:
 	typedef Pixel_T pixel_type;
 
 	ImageData(unsigned width, unsigned height, const Pixel_T background) :
 		_width(width),
 		_height(height),
-		_pixels(new Pixel_T[width * height + 1])
+		_stride(static_cast<size_t>(width) * sizeof(Pixel_T)),
+		_borrowed(false),
+		_capacity(0),
+		_pixels(allocate(width, height, _capacity)),
+		_captureTime(0),
+		_sampleGeneration(0)
 	{
 		std::fill(_pixels, _pixels + width * height, background);
 	}
 
+	///
+	/// Read-only view of pixels owned by someone else (e.g. a capture or receive buffer). The
+	/// pixels are copied into an own buffer before the first write access, see materialize().
+	///
+	ImageData(const Pixel_T* pixels, unsigned width, unsigned height, size_t stride) :
+		_width(width),
+		_height(height),
+		_stride(stride),
+		_borrowed(true),
+		_capacity(0),
+		_pixels(const_cast<Pixel_T*>(pixels)),
+		_captureTime(0),
+		_sampleGeneration(0)
+	{
+	}
+
 	ImageData(const ImageData & other) :
 		QSharedData(other),
 		_width(other._width),
 		_height(other._height),
-		_pixels(new Pixel_T[other._width * other._height + 1])
+		_stride(static_cast<size_t>(other._width) * sizeof(Pixel_T)),
+		_borrowed(false),
+		_capacity(0),
+		_pixels(allocate(other._width, other._height, _capacity)),
+		_captureTime(other._captureTime),
+		_sampleGeneration(other._sampleGeneration)
 	{
-		memcpy(_pixels, other._pixels, static_cast<ulong>(other._width) * static_cast<ulong>(other._height) * sizeof(Pixel_T));
+		other.copyTo(_pixels);
 	}
 
 	ImageData& operator=(ImageData rhs)
@@ -52,13 +82,23 @@ public:
 		using std::swap;
 		swap(this->_width, s._width);
 		swap(this->_height, s._height);
+		swap(this->_stride, s._stride);
+		swap(this->_borrowed, s._borrowed);
 		swap(this->_pixels, s._pixels);
+		swap(this->_capacity, s._capacity);
+		swap(this->_captureTime, s._captureTime);
+		swap(this->_sampleGeneration, s._sampleGeneration);
 	}
 
 	ImageData(ImageData&& src) noexcept
 		: _width(0)
 		, _height(0)
+		, _stride(0)
+		, _borrowed(false)
+		, _capacity(0)
 		, _pixels(NULL)
+		, _captureTime(0)
+		, _sampleGeneration(0)
 	{
 		src.swap(*this);
 	}
@@ -71,7 +111,10 @@ public:
 
 	~ImageData()
 	{
-		delete[] _pixels;
+		if (!_borrowed)
+		{
+			ImageBufferPool::getInstance()->release(_pixels, _capacity);
+		}
 	}
 
 	inline unsigned width() const
@@ -86,26 +129,27 @@ public:
 
 	uint8_t red(unsigned pixel) const
 	{
-		return (_pixels + pixel)->red;
+		return at(pixel).red;
 	}
 
 	uint8_t green(unsigned pixel) const
 	{
-		return (_pixels + pixel)->green;
+		return at(pixel).green;
 	}
 
 	uint8_t blue(unsigned pixel) const
 	{
-		return (_pixels + pixel)->blue;
+		return at(pixel).blue;
 	}
 
 	const Pixel_T& operator()(unsigned x, unsigned y) const
 	{
-		return _pixels[toIndex(x,y)];
+		return row(y)[x];
 	}
 
 	Pixel_T& operator()(unsigned x, unsigned y)
 	{
+		materialize();
 		return _pixels[toIndex(x,y)];
 	}
 
@@ -114,18 +158,24 @@ public:
 		if (width == _width && height == _height)
 			return;
 
-		if ((width * height) > unsigned((_width * _height)))
+		if (_borrowed || (static_cast<size_t>(width) * height + 1) * sizeof(Pixel_T) > _capacity)
 		{
-			delete[] _pixels;
-			_pixels = new Pixel_T[width*height + 1];
+			if (!_borrowed)
+			{
+				ImageBufferPool::getInstance()->release(_pixels, _capacity);
+			}
+			_pixels = allocate(width, height, _capacity);
+			_borrowed = false;
 		}
 
 		_width = width;
 		_height = height;
+		_stride = static_cast<size_t>(width) * sizeof(Pixel_T);
 	}
 
 	Pixel_T* memptr()
 	{
+		materialize();
 		return _pixels;
 	}
 
@@ -134,20 +184,98 @@ public:
 		return _pixels;
 	}
 
+	///
+	/// @return The first pixel of a row, rows are stride() bytes apart
+	///
+	const Pixel_T* row(unsigned y) const
+	{
+		return reinterpret_cast<const Pixel_T*>(reinterpret_cast<const uint8_t*>(_pixels) + y * _stride);
+	}
+
+	///
+	/// @return The distance between the rows in bytes
+	///
+	size_t stride() const
+	{
+		return _stride;
+	}
+
+	///
+	/// @return True, if the pixels are a view of memory owned by someone else
+	///
+	bool isBorrowed() const
+	{
+		return _borrowed;
+	}
+
+	///
+	/// @return The monotonic capture time of the pixels in microseconds, 0 if unknown
+	///
+	int64_t captureTime() const
+	{
+		return _captureTime;
+	}
+
+	void setCaptureTime(int64_t captureTime)
+	{
+		_captureTime = captureTime;
+	}
+
+	///
+	/// @return The generation of the SampleDemand mask the pixels were converted with, 0 if all
+	/// 		pixels are valid
+	///
+	uint64_t sampleGeneration() const
+	{
+		return _sampleGeneration;
+	}
+
+	void setSampleGeneration(uint64_t sampleGeneration)
+	{
+		_sampleGeneration = sampleGeneration;
+	}
+
+	///
+	/// Copies the pixels of a borrowed view into an own (packed) buffer. Afterwards the image no
+	/// longer refers to the borrowed memory.
+	///
+	void materialize()
+	{
+		if (!_borrowed)
+			return;
+
+		size_t capacity = 0;
+		Pixel_T* pixels = allocate(_width, _height, capacity);
+		copyTo(pixels);
+
+		_pixels = pixels;
+		_capacity = capacity;
+		_stride = static_cast<size_t>(_width) * sizeof(Pixel_T);
+		_borrowed = false;
+	}
+
 	void toRgb(ImageData<ColorRgb>& image) const
 	{
 		if (image.width() != _width || image.height() != _height)
 			image.resize(_width, _height);
+		image.setCaptureTime(_captureTime);
+		image.setSampleGeneration(_sampleGeneration);
 
-		const unsigned imageSize = _width * _height;
-
-		for (unsigned idx = 0; idx < imageSize; idx++)
+		ColorRgb* output = image.memptr();
+		for (unsigned y = 0; y < _height; y++)
 		{
-			const Pixel_T & color = _pixels[idx];
-			image.memptr()[idx] = ColorRgb{color.red, color.green, color.blue};
+			const Pixel_T* input = row(y);
+			for (unsigned x = 0; x < _width; x++)
+			{
+				const Pixel_T & color = input[x];
+				*output++ = ColorRgb{color.red, color.green, color.blue};
+			}
 		}
 	}
 
+	///
+	/// @return The size of the pixels without row padding, i.e. of a packed copy
+	///
 	ssize_t size() const
 	{
 		return  static_cast<ssize_t>(_width) * static_cast<ssize_t>(_height) * sizeof(Pixel_T);
@@ -159,24 +287,71 @@ public:
 		{
 			_width = 1;
 			_height = 1;
-			delete[] _pixels;
-			_pixels = new Pixel_T[2];
+			if (!_borrowed)
+			{
+				ImageBufferPool::getInstance()->release(_pixels, _capacity);
+			}
+			_pixels = allocate(1, 1, _capacity);
+			_stride = sizeof(Pixel_T);
+			_borrowed = false;
 		}
 
+		materialize();
+
 		memset(_pixels, 0, static_cast<unsigned long>(_width) * static_cast<unsigned long>(_height) * sizeof(Pixel_T));
 	}
 
 private:
+	/// Index into the pixels, only valid for packed rows (see materialize())
 	inline unsigned toIndex(unsigned x, unsigned y) const
 	{
+		assert(_stride == static_cast<size_t>(_width) * sizeof(Pixel_T));
 		return y * _width + x;
 	}
 
+	/// The pixel with the given row-major index, honours the stride of a view
+	const Pixel_T& at(unsigned pixel) const
+	{
+		return row(pixel / _width)[pixel % _width];
+	}
+
+	/// Copies the pixels packed (without row padding) to the given buffer
+	void copyTo(Pixel_T* pixels) const
+	{
+		const size_t rowSize = static_cast<size_t>(_width) * sizeof(Pixel_T);
+		if (_stride == rowSize)
+		{
+			memcpy(pixels, _pixels, rowSize * _height);
+			return;
+		}
+
+		for (unsigned y = 0; y < _height; y++)
+		{
+			memcpy(pixels + static_cast<size_t>(y) * _width, row(y), rowSize);
+		}
+	}
+
+	/// Gets a buffer for width*height+1 pixels from the pool
+	static Pixel_T* allocate(unsigned width, unsigned height, size_t& capacity)
+	{
+		return static_cast<Pixel_T*>(ImageBufferPool::getInstance()->acquire((static_cast<size_t>(width) * height + 1) * sizeof(Pixel_T), capacity));
+	}
+
 private:
 	/// The width of the image
 	unsigned _width;
 	/// The height of the image
 	unsigned _height;
+	/// The distance between the rows in bytes
+	size_t _stride;
+	/// True, if the pixels are borrowed and must not be written or freed
+	bool _borrowed;
+	/// The size of the pixel buffer in bytes
+	size_t _capacity;
 	/// The pixels of the image
 	Pixel_T* _pixels;
+	/// The capture time, see LatencyTracker::now()
+	int64_t _captureTime;
+	/// The generation of the sample mask, see SampleDemand::Mask
+	uint64_t _sampleGeneration;
 };
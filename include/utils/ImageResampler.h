@@ -5,6 +5,15 @@
 #include <utils/Image.h>
 #include <utils/ColorRgb.h>
 
+///
+/// The matrix of YUV input, BT.601 for SD and BT.709 for HD sources
+///
+enum class YuvMatrix
+{
+	BT601,
+	BT709
+};
+
 class ImageResampler
 {
 public:
@@ -15,6 +24,16 @@ public:
 	void setVerticalPixelDecimation(int decimator);
 	void setCropping(int cropLeft, int cropRight, int cropTop, int cropBottom);
 	void setVideoMode(VideoMode mode);
+	void setYuvMatrix(YuvMatrix matrix);
+
+	///
+	/// Converts the (cropped and decimated) raw image into outputImage. When all consumers of
+	/// the image published their demand via SampleDemand only those pixels are converted, the
+	/// other pixels keep their previous content.
+	///
+	/// For the planar formats NV12 and I420 lineLength is the line length of the luma plane, the
+	/// chroma planes follow it.
+	///
 	void processImage(const uint8_t * data, int width, int height, int lineLength, PixelFormat pixelFormat, Image<ColorRgb> & outputImage) const;
 
 private:
@@ -25,5 +44,6 @@ private:
 	int _cropTop;
 	int _cropBottom;
 	VideoMode _videoMode;
+	YuvMatrix _yuvMatrix;
 };
 
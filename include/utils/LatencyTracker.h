@@ -0,0 +1,123 @@
+#pragma once
+
+// STL includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+///
+/// End-to-end latency of the frames of an instance, from their capture to each stage of the LED update.
+///
+/// Frames carry the monotonic time of their capture (see now(), Image::captureTime()). Each stage records
+/// the time elapsed since then, so the histogram of a stage holds the latency up to this stage and the
+/// difference of two stages the time spent in between. A frame is recorded once per stage.
+///
+/// Stages running in another thread get the frame handed over: handOver() marks the latest frame for
+/// the stage and takeOver() claims it once, frames superseded before are not recorded.
+///
+/// All methods are lock-free and can be called from any thread.
+///
+class LatencyTracker
+{
+public:
+	enum Stage
+	{
+		/// The frame is picked up by the LED update of the instance
+		MUXER,
+		/// The image is mapped to LED colors
+		PROCESS,
+		/// The colors are adjusted
+		ADJUSTMENT,
+		/// The colors leave the smoothing (including its output delay)
+		SMOOTHING,
+		/// The colors are written by the LED device
+		DEVICE,
+		STAGE_COUNT
+	};
+
+	///
+	/// Latency percentiles of a stage in microseconds, bucketed with a relative error below 4%
+	///
+	struct Summary
+	{
+		uint64_t count;
+		int64_t p50;
+		int64_t p95;
+		int64_t p99;
+		int64_t max;
+	};
+
+	LatencyTracker();
+	LatencyTracker(const LatencyTracker&) = delete;
+	LatencyTracker& operator=(const LatencyTracker&) = delete;
+
+	///
+	/// @brief The monotonic clock of the capture times in microseconds (CLOCK_MONOTONIC on Linux, like V4L2 buffers)
+	///
+	static int64_t now();
+
+	///
+	/// @brief The id of a stage, e.g. for the JSON API
+	///
+	static const char* stageName(Stage stage);
+
+	///
+	/// @brief Record the latency of a frame at a stage
+	/// @param stage        The stage
+	/// @param captureTime  The capture time of the frame, nothing is recorded for 0 (unknown)
+	///
+	void record(Stage stage, int64_t captureTime);
+
+	///
+	/// @brief Mark a frame to be recorded by a stage running in another thread
+	/// @param stage        The stage
+	/// @param captureTime  The capture time of the frame
+	///
+	void handOver(Stage stage, int64_t captureTime);
+
+	///
+	/// @brief Claim the frame handed over to a stage
+	/// @param stage  The stage
+	/// @return The capture time of the frame, 0 if none was handed over since the last call
+	///
+	int64_t takeOver(Stage stage);
+
+	///
+	/// @brief Get the percentiles of a stage since the last reset
+	///
+	Summary summary(Stage stage) const;
+
+	///
+	/// @brief Clear all histograms
+	///
+	void reset();
+
+	///
+	/// @brief The time of the last reset in the clock of now()
+	///
+	int64_t since() const { return _since.load(std::memory_order_relaxed); }
+
+	/// Number of buckets of a histogram
+	static constexpr size_t BUCKETS = 32 + 16 * 22;
+
+	///
+	/// @brief The histogram bucket of a latency: exact below 32 us, 16 buckets per power of two above
+	///
+	static size_t bucketOf(int64_t latency);
+
+	///
+	/// @brief The mid latency of a bucket
+	///
+	static int64_t latencyOf(size_t bucket);
+
+private:
+	struct Histogram
+	{
+		std::atomic<uint32_t> buckets[BUCKETS];
+		std::atomic<int64_t> max;
+	};
+
+	Histogram _histograms[STAGE_COUNT];
+	std::atomic<int64_t> _handOver[STAGE_COUNT];
+	std::atomic<int64_t> _since;
+};
@@ -12,6 +12,8 @@ enum class PixelFormat {
 	BGR24,
 	RGB32,
 	BGR32,
+	NV12,
+	I420,
 #ifdef HAVE_JPEG_DECODER
 	MJPEG,
 #endif
@@ -47,6 +49,14 @@ inline PixelFormat parsePixelFormat(const QString& pixelFormat)
 	{
 		return PixelFormat::BGR32;
 	}
+	else if (format.compare("nv12") )
+	{
+		return PixelFormat::NV12;
+	}
+	else if (format.compare("i420") )
+	{
+		return PixelFormat::I420;
+	}
 #ifdef HAVE_JPEG_DECODER
 	else if (format.compare("mjpeg") )
 	{
@@ -0,0 +1,129 @@
+#pragma once
+
+// STL includes
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// QT includes
+#include <QMutex>
+
+///
+/// Registry of the pixels the consumers of captured images really read.
+///
+/// Each consumer (e.g. the ImageProcessor of a Hyperion instance) publishes the pixels it needs
+/// from an image of a given size, or that it needs the whole image (preview, forwarding,
+/// unicolor mapping). The ImageResampler converts only the pixels of the merged mask while all
+/// consumers agree on the image size, otherwise it converts the whole image as before.
+/// Without any consumer (e.g. the standalone capture tools) the whole image is converted.
+///
+class SampleDemand
+{
+public:
+	/// A run of pixels [xBegin, xEnd) in a row of an image
+	struct Span
+	{
+		unsigned row;
+		unsigned xBegin;
+		unsigned xEnd;
+	};
+
+	///
+	/// The merged demand of all consumers for images of one size
+	///
+	struct Mask
+	{
+		unsigned width;
+		unsigned height;
+		/// Index of the first interval of each row into intervals, height+1 entries
+		std::vector<uint32_t> rowIntervals;
+		/// Sorted, non overlapping [xBegin, xEnd) ranges per row
+		std::vector<std::pair<unsigned, unsigned>> intervals;
+		/// Number of pixels covered by the mask
+		uint64_t pixelCount;
+		/// The generation of the demands the mask was merged from, see generation()
+		uint64_t generation;
+	};
+
+	static SampleDemand* getInstance()
+	{
+		static SampleDemand instance;
+		return & instance;
+	}
+
+	SampleDemand(SampleDemand const&)  = delete;
+	void operator=(SampleDemand const&) = delete;
+
+	///
+	/// @brief Publish the pixels a consumer reads from images of the given size
+	/// @param consumer  Identifies the consumer, e.g. its this pointer
+	/// @param width     The width of the images
+	/// @param height    The height of the images
+	/// @param spans     The pixels read, may overlap and be unsorted
+	///
+	void setDemand(const void* consumer, unsigned width, unsigned height, const std::vector<Span>& spans);
+
+	///
+	/// @brief Publish pixels a grabber reads itself (e.g. for signal detection). These are added
+	/// 	   to the mask, but do not allow a partial conversion without any other consumer.
+	/// @param consumer  Identifies the consumer, e.g. its this pointer
+	/// @param width     The width of the images
+	/// @param height    The height of the images
+	/// @param spans     The pixels read, may overlap and be unsorted
+	///
+	void setSupplementaryDemand(const void* consumer, unsigned width, unsigned height, const std::vector<Span>& spans);
+
+	///
+	/// @brief Publish that a consumer reads all pixels of the images
+	/// @param consumer  Identifies the consumer, e.g. its this pointer
+	///
+	void setFullDemand(const void* consumer);
+
+	///
+	/// @brief Remove the demand of a consumer (e.g. on destruction)
+	/// @param consumer  Identifies the consumer
+	///
+	void removeConsumer(const void* consumer);
+
+	///
+	/// @brief Get the pixels to convert for an image of the given size
+	/// @param width   The width of the image
+	/// @param height  The height of the image
+	/// @return The mask or nullptr, if the whole image has to be converted
+	///
+	std::shared_ptr<const Mask> getMask(unsigned width, unsigned height) const;
+
+	///
+	/// @brief Get the generation of the demands, counts up with every change. A mask of this or a
+	/// 	   later generation covers all demands published so far.
+	///
+	uint64_t generation() const;
+
+private:
+	SampleDemand() = default;
+
+	/// Merges the demands of all consumers, must be called with the mutex locked
+	void rebuild();
+
+	struct Demand
+	{
+		bool full;
+		bool supplementary;
+		unsigned width;
+		unsigned height;
+		std::vector<Span> spans;
+	};
+
+	mutable QMutex _mutex;
+
+	/// The published demand per consumer
+	std::map<const void*, Demand> _demands;
+
+	/// The merged mask, nullptr if the whole image is required
+	std::shared_ptr<const Mask> _mask;
+
+	/// The generation of the published demands
+	uint64_t _generation = 0;
+};
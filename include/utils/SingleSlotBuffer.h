@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+///
+/// Lock-free hand-over of the latest value from one producer to one consumer thread (triple buffer).
+///
+/// The producer fills back() and publishes it, the consumer takes the most recent published value.
+/// A value which was not taken before the next one is published is overwritten, so a slow consumer
+/// always gets the freshest value and the producer never waits. The buffers are reused, a value type
+/// like std::vector keeps its capacity and does not allocate once sized.
+///
+/// At any time only one thread may call back() and publish(), and one thread take().
+///
+template <typename T>
+class SingleSlotBuffer
+{
+public:
+	SingleSlotBuffer() = default;
+	SingleSlotBuffer(const SingleSlotBuffer&) = delete;
+	SingleSlotBuffer& operator=(const SingleSlotBuffer&) = delete;
+
+	///
+	/// @brief The buffer to be filled by the producer
+	///
+	T& back() { return _buffers[_back]; }
+
+	///
+	/// @brief Hands the filled back buffer to the consumer
+	/// @return True if the consumer took the previous value, it has to be notified about the new one then
+	///
+	bool publish()
+	{
+		const uint8_t previous = _middle.exchange(_back | FRESH, std::memory_order_acq_rel);
+		_back = previous & INDEX;
+		return (previous & FRESH) == 0;
+	}
+
+	///
+	/// @brief Takes the most recent value, it is valid until the next call
+	/// @return The value, nullptr if nothing was published since the last call
+	///
+	T* take()
+	{
+		if ((_middle.load(std::memory_order_acquire) & FRESH) == 0)
+		{
+			return nullptr;
+		}
+		const uint8_t previous = _middle.exchange(_front, std::memory_order_acq_rel);
+		_front = previous & INDEX;
+		return &_buffers[_front];
+	}
+
+private:
+	static constexpr uint8_t INDEX = 0x3;
+	static constexpr uint8_t FRESH = 0x4;
+
+	T _buffers[3];
+
+	/// Owned by the producer
+	uint8_t _back = 0;
+	/// Index of the exchanged buffer plus the FRESH flag if it holds a value not taken yet
+	std::atomic<uint8_t> _middle{1};
+	/// Owned by the consumer
+	uint8_t _front = 2;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+// STL includes
+#include <cstdint>
+
+// Qt includes
+#include <QJsonObject>
+
+#include <HyperionConfig.h>
+
+/*
+Tracing of the processing pipeline with scoped spans and counters, viewable in chrome://tracing or
+https://ui.perfetto.dev
+
+Compile with the cmake option -DENABLE_TRACING=ON, otherwise all trace macros compile to nothing and can stay in hot paths.
+
+A span covers the rest of the enclosing block:
+TRACE_SCOPE("smoothing.update");
+A counter samples a value:
+TRACE_COUNTER("device.leds", ledCount);
+
+Names must be string literals (or other strings living until the end of the process), they are kept as pointers.
+The events of the last seconds are dumped with the JSON-RPC command "tracing" (see Tracer::dumpChromeTrace()).
+*/
+
+#ifdef ENABLE_TRACING
+	#define TRACE_CONCAT_INNER(a, b) a ## b
+	#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+	#define TRACE_SCOPE(name) Tracer::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)
+	#define TRACE_COUNTER(name, value) Tracer::counter(name, static_cast<int64_t>(value))
+	#define TRACE_INSTANT(name) Tracer::instant(name)
+#else
+	#define TRACE_SCOPE(name)
+	#define TRACE_COUNTER(name, value)
+	#define TRACE_INSTANT(name)
+#endif
+
+///
+/// Records trace events into one lock-free ring buffer per thread.
+///
+/// A thread writes its events without locking or allocating (a clock read and a few stores per event),
+/// the buffer keeps the latest EVENTS_PER_THREAD events and overwrites older ones. The buffer of an
+/// ended thread stays readable until a new thread takes it over.
+///
+class Tracer
+{
+public:
+	/// Number of events kept per thread
+	static constexpr uint32_t EVENTS_PER_THREAD = 8192;
+
+	///
+	/// Records the duration of a block as one complete event when it goes out of scope
+	///
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name)
+			: _name(name)
+			, _start(now())
+		{
+		}
+
+		~Scope()
+		{
+			complete(_name, _start, now() - _start);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		const char* _name;
+		int64_t _start;
+	};
+
+	///
+	/// @brief The monotonic clock of the events in nanoseconds
+	///
+	static int64_t now();
+
+	///
+	/// @brief Record a span of the calling thread
+	/// @param name      The name of the span
+	/// @param start     The start time in the clock of now()
+	/// @param duration  The duration in nanoseconds
+	///
+	static void complete(const char* name, int64_t start, int64_t duration);
+
+	///
+	/// @brief Record the value of a counter
+	///
+	static void counter(const char* name, int64_t value);
+
+	///
+	/// @brief Record an event without duration on the calling thread
+	///
+	static void instant(const char* name);
+
+	///
+	/// @brief Get the recorded events of all threads in the Chrome trace event format
+	///
+	static QJsonObject dumpChromeTrace();
+
+	///
+	/// @brief Drop all recorded events
+	///
+	static void clear();
+
+private:
+	enum Type : uint8_t
+	{
+		COMPLETE,
+		COUNTER,
+		INSTANT
+	};
+
+	static void record(Type type, const char* name, int64_t timestamp, int64_t value);
+};
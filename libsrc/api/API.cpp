@@ -21,6 +21,7 @@
 #include <utils/SysInfo.h>
 #include <utils/ColorSys.h>
 #include <utils/Process.h>
+#include <utils/LatencyTracker.h>
 
 // bonjour wrapper
 #include <bonjour/bonjourbrowserwrapper.h>
@@ -178,6 +179,7 @@ bool API::setImage(ImageCmdData &data, hyperion::Components comp, QString &reply
     // copy image
     Image<ColorRgb> image(data.width, data.height);
     memcpy(image.memptr(), data.data.data(), data.data.size());
+    image.setCaptureTime(LatencyTracker::now());
 
     QMetaObject::invokeMethod(_hyperion, "registerInput", Qt::QueuedConnection, Q_ARG(int, data.priority), Q_ARG(hyperion::Components, comp), Q_ARG(QString, data.origin), Q_ARG(QString, data.imgName));
     QMetaObject::invokeMethod(_hyperion, "setInputImage", Qt::QueuedConnection, Q_ARG(int, data.priority), Q_ARG(Image<ColorRgb>, image), Q_ARG(int64_t, data.duration));
@@ -24,6 +24,8 @@
 #include <utils/ColorSys.h>
 #include <utils/Process.h>
 #include <utils/JsonUtils.h>
+#include <utils/ImageBufferPool.h>
+#include <utils/Tracer.h>
 
 // bonjour wrapper
 #ifdef ENABLE_AVAHI
@@ -32,6 +34,7 @@
 
 // ledmapping int <> string transform methods
 #include <hyperion/ImageProcessor.h>
+#include <hyperion/SharedFrameStage.h>
 
 // api includes
 #include <api/JsonCB.h>
@@ -174,6 +177,10 @@ proceed:
 		handleInstanceCommand(message, command, tan);
 	else if (command == "leddevice")
 		handleLedDeviceCommand(message, command, tan);
+	else if (command == "latency")
+		handleLatencyCommand(message, command, tan);
+	else if (command == "tracing")
+		handleTracingCommand(message, command, tan);
 
 	// BEGIN | The following commands are deprecated but used to ensure backward compatibility with hyperion Classic remote control
 	else if (command == "clearall")
@@ -311,13 +318,16 @@ void JsonAPI::handleServerInfoCommand(const QJsonObject &message, const QString
 	// collect priority information
 	QJsonArray priorities;
 	uint64_t now = QDateTime::currentMSecsSinceEpoch();
-	QList<int> activePriorities = _hyperion->getActivePriorities();
-	activePriorities.removeAll(255);
-	int currentPriority = _hyperion->getCurrentPriority();
+	const PriorityMuxer::SnapshotPtr prioritySnapshot = _hyperion->getPrioritySnapshot();
+	int currentPriority = prioritySnapshot->currentPriority;
 
-	for(int priority : activePriorities)
+	for(const auto& input : prioritySnapshot->getInputs())
 	{
-		const Hyperion::InputInfo &priorityInfo = _hyperion->getPriorityInfo(priority);
+		const Hyperion::InputInfo &priorityInfo = *input;
+		const int priority = priorityInfo.priority;
+		if (priority == PriorityMuxer::LOWEST_PRIORITY)
+			continue;
+
 		QJsonObject item;
 		item["priority"] = priority;
 		if (priorityInfo.timeoutTime_ms > 0)
@@ -367,7 +377,7 @@ void JsonAPI::handleServerInfoCommand(const QJsonObject &message, const QString
 	}
 
 	info["priorities"] = priorities;
-	info["priorities_autoselect"] = _hyperion->sourceAutoSelectEnabled();
+	info["priorities_autoselect"] = prioritySnapshot->sourceAutoSelectEnabled;
 
 	// collect adjustment information
 	QJsonArray adjustmentArray;
@@ -522,6 +532,7 @@ void JsonAPI::handleServerInfoCommand(const QJsonObject &message, const QString
 	}
 
 	grabbers["v4l2_properties"] = availableV4L2devices;
+	grabbers["v4l2_pipeline"] = GrabberWrapper::getInstance()->getV4L2pipelineStats();
 
 #endif
 
@@ -544,6 +555,43 @@ void JsonAPI::handleServerInfoCommand(const QJsonObject &message, const QString
 	info["components"] = component;
 	info["imageToLedMappingType"] = ImageProcessor::mappingTypeToStr(_hyperion->getLedMappingType());
 
+	// image to led mapping cache statistics
+	const hyperion::ImageToLedsMapCache& mapCache = _hyperion->getImageProcessor()->getMapCache();
+	QJsonObject mapCacheInfo;
+	mapCacheInfo["hits"] = static_cast<double>(mapCache.hits());
+	mapCacheInfo["misses"] = static_cast<double>(mapCache.misses());
+	mapCacheInfo["size"] = static_cast<int>(mapCache.size());
+	mapCacheInfo["capacity"] = static_cast<int>(mapCache.capacity());
+	info["imageToLedMappingCache"] = mapCacheInfo;
+
+	// input frames coalesced to the rate of the led device
+	QJsonObject updateInfo;
+	updateInfo["droppedFrames"] = static_cast<double>(_hyperion->getDroppedFrames());
+	updateInfo["minInterval"] = _hyperion->getUpdateInterval();
+	info["ledUpdates"] = updateInfo;
+
+	// output timing of the smoothing
+	info["smoothingOutput"] = _hyperion->getSmoothingStatistics();
+
+	// time the output was parked on settled colors
+	info["outputIdle"] = _hyperion->getIdleStatistics();
+
+	// image buffer pool statistics
+	const ImageBufferPool::Statistics poolStats = ImageBufferPool::getInstance()->statistics();
+	QJsonObject imageBufferPool;
+	imageBufferPool["allocations"] = static_cast<double>(poolStats.allocations);
+	imageBufferPool["reuses"] = static_cast<double>(poolStats.reuses);
+	imageBufferPool["evictions"] = static_cast<double>(poolStats.evictions);
+	imageBufferPool["retainedBuffers"] = static_cast<double>(poolStats.retainedBuffers);
+	imageBufferPool["retainedBytes"] = static_cast<double>(poolStats.retainedBytes);
+	info["imageBufferPool"] = imageBufferPool;
+
+	// analysis of captured frames shared between the instances
+	QJsonObject sharedFrameStage;
+	sharedFrameStage["hits"] = static_cast<double>(hyperion::SharedFrameStage::getInstance()->hits());
+	sharedFrameStage["misses"] = static_cast<double>(hyperion::SharedFrameStage::getInstance()->misses());
+	info["sharedFrameStage"] = sharedFrameStage;
+
 	// add sessions
 	QJsonArray sessions;
 #ifdef ENABLE_AVAHI
@@ -634,7 +682,7 @@ void JsonAPI::handleServerInfoCommand(const QJsonObject &message, const QString
 
 	// ACTIVE STATIC LED COLOR
 	QJsonArray activeLedColors;
-	const Hyperion::InputInfo &priorityInfo = _hyperion->getPriorityInfo(_hyperion->getCurrentPriority());
+	const Hyperion::InputInfo &priorityInfo = prioritySnapshot->getInputInfo(currentPriority);
 	if (priorityInfo.componentId == hyperion::COMP_COLOR && !priorityInfo.ledColors.empty())
 	{
 		QJsonObject LEDcolor;
@@ -1452,6 +1500,72 @@ void JsonAPI::handleLedDeviceCommand(const QJsonObject &message, const QString &
 	}
 }
 
+void JsonAPI::handleLatencyCommand(const QJsonObject &message, const QString &command, int tan)
+{
+	const QString &subc = message["subcommand"].toString().trimmed();
+	const QString full_command = command + "-" + subc;
+	LatencyTracker* latency = _hyperion->getLatencyTracker();
+
+	if (subc == "get")
+	{
+		const int64_t now = LatencyTracker::now();
+
+		// latency from the capture of a frame up to each stage, in ms
+		QJsonArray stages;
+		for (int stage = 0; stage < LatencyTracker::STAGE_COUNT; ++stage)
+		{
+			const LatencyTracker::Summary summary = latency->summary(static_cast<LatencyTracker::Stage>(stage));
+			QJsonObject item;
+			item["stage"] = LatencyTracker::stageName(static_cast<LatencyTracker::Stage>(stage));
+			item["count"] = static_cast<qint64>(summary.count);
+			item["p50"] = summary.p50 / 1000.0;
+			item["p95"] = summary.p95 / 1000.0;
+			item["p99"] = summary.p99 / 1000.0;
+			item["max"] = summary.max / 1000.0;
+			stages.append(item);
+		}
+
+		QJsonObject info;
+		info["instance"] = static_cast<int>(_hyperion->getInstanceIndex());
+		info["period"] = static_cast<qint64>((now - latency->since()) / 1000);
+		info["stages"] = stages;
+		sendSuccessDataReply(QJsonDocument(info), full_command, tan);
+	}
+	else if (subc == "reset")
+	{
+		latency->reset();
+		sendSuccessReply(full_command, tan);
+	}
+	else
+	{
+		sendErrorReply("Unknown or missing subcommand", full_command, tan);
+	}
+}
+
+void JsonAPI::handleTracingCommand(const QJsonObject &message, const QString &command, int tan)
+{
+	const QString &subc = message["subcommand"].toString().trimmed();
+	const QString full_command = command + "-" + subc;
+
+#ifdef ENABLE_TRACING
+	if (subc == "dump")
+	{
+		sendSuccessDataReply(QJsonDocument(Tracer::dumpChromeTrace()), full_command, tan);
+	}
+	else if (subc == "clear")
+	{
+		Tracer::clear();
+		sendSuccessReply(full_command, tan);
+	}
+	else
+	{
+		sendErrorReply("Unknown or missing subcommand", full_command, tan);
+	}
+#else
+	sendErrorReply("Tracing is not enabled in this build", full_command, tan);
+#endif
+}
+
 void JsonAPI::handleNotImplemented(const QString &command, int tan)
 {
 	sendErrorReply("Command not implemented", command, tan);
@@ -220,12 +220,15 @@ void JsonCB::handlePriorityUpdate()
 	QJsonObject data;
 	QJsonArray priorities;
 	uint64_t now = QDateTime::currentMSecsSinceEpoch();
-	QList<int> activePriorities = _prioMuxer->getPriorities();
-	activePriorities.removeAll(255);
-	int currentPriority = _prioMuxer->getCurrentPriority();
+	const PriorityMuxer::SnapshotPtr prioritySnapshot = _prioMuxer->getSnapshot();
+	int currentPriority = prioritySnapshot->currentPriority;
+
+	for (const auto& input : prioritySnapshot->getInputs()) {
+		const Hyperion::InputInfo& priorityInfo = *input;
+		const int priority = priorityInfo.priority;
+		if (priority == PriorityMuxer::LOWEST_PRIORITY)
+			continue;
 
-	for (int priority : activePriorities) {
-		const Hyperion::InputInfo priorityInfo = _prioMuxer->getInputInfo(priority);
 		QJsonObject item;
 		item["priority"] = priority;
 		if (priorityInfo.timeoutTime_ms > 0 )
@@ -272,7 +275,7 @@ void JsonCB::handlePriorityUpdate()
 	}
 
 	data["priorities"] = priorities;
-	data["priorities_autoselect"] = _hyperion->sourceAutoSelectEnabled();
+	data["priorities_autoselect"] = prioritySnapshot->sourceAutoSelectEnabled;
 
 	doCallback("priorities-update", QVariant(data));
 }
@@ -1,14 +1,269 @@
 #include <iostream>
 #include <utils/Logger.h>
+#include <utils/CpuFeatures.h>
 
 // BlackBorders includes
 #include <blackborder/BlackBorderDetector.h>
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+
+#if defined(HYPERION_SIMD_X86)
+	#include <emmintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+	#endif
+#elif defined(HYPERION_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
 
 using namespace hyperion;
 
+constexpr unsigned BlackBorderDetector::SCENE_GRID;
+
+namespace {
+
+/// A line belongs to the picture with one non-black color component per 16 pixels, noise and logos have less
+const unsigned PICTURE_LINE_FRACTION = 16;
+
+/// Mean difference per color component of the sampled pixels, which starts a new scan
+const unsigned SCENE_CHANGE_DIFFERENCE = 6;
+
+///
+/// Byte kernels of the line scan, a byte is above the threshold if it is greater or equal.
+/// A packed RGB pixel is not black if any of its bytes is above the threshold.
+///
+struct ScanKernels
+{
+	/// @return The number of bytes above the threshold
+	size_t (*countAbove)(const uint8_t* data, size_t count, uint8_t threshold);
+
+	/// @return The index of the first byte above the threshold, count if there is none
+	size_t (*findFirstAbove)(const uint8_t* data, size_t count, uint8_t threshold);
+
+	/// @return The index of the last byte above the threshold, count if there is none
+	size_t (*findLastAbove)(const uint8_t* data, size_t count, uint8_t threshold);
+
+	const char* name;
+};
+
+size_t countAboveScalar(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	size_t above = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		above += data[i] >= threshold ? 1 : 0;
+	}
+	return above;
+}
+
+size_t findFirstAboveScalar(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (data[i] >= threshold)
+		{
+			return i;
+		}
+	}
+	return count;
+}
+
+size_t findLastAboveScalar(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	for (size_t i = count; i > 0; --i)
+	{
+		if (data[i - 1] >= threshold)
+		{
+			return i - 1;
+		}
+	}
+	return count;
+}
+
+#if defined(HYPERION_SIMD_X86)
+
+inline unsigned lowestBit(unsigned mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+inline unsigned highestBit(unsigned mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return index;
+#else
+	return 31 - static_cast<unsigned>(__builtin_clz(mask));
+#endif
+}
+
+// v >= threshold <=> max(v, threshold) == v, -1 per byte above the threshold
+HYPERION_TARGET_SSE2 inline __m128i aboveSse2(const uint8_t* data, __m128i threshold)
+{
+	const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	return _mm_cmpeq_epi8(_mm_max_epu8(v, threshold), v);
+}
+
+// The byte counters take up to 255 vectors before they are summed up with psadbw
+HYPERION_TARGET_SSE2 size_t countAboveSse2(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+	const __m128i zero = _mm_setzero_si128();
+	__m128i total = zero;
+
+	size_t i = 0;
+	while (count - i >= 16)
+	{
+		const size_t end = i + 16 * std::min<size_t>(255, (count - i) / 16);
+		__m128i counters = zero;
+		for (; i < end; i += 16)
+		{
+			counters = _mm_sub_epi8(counters, aboveSse2(data + i, limit));
+		}
+		total = _mm_add_epi64(total, _mm_sad_epu8(counters, zero));
+	}
+
+	alignas(16) uint64_t lanes[2];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+	return static_cast<size_t>(lanes[0] + lanes[1]) + countAboveScalar(data + i, count - i, threshold);
+}
+
+HYPERION_TARGET_SSE2 size_t findFirstAboveSse2(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+
+	size_t i = 0;
+	for (; count - i >= 16; i += 16)
+	{
+		const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(aboveSse2(data + i, limit)));
+		if (mask != 0)
+		{
+			return i + lowestBit(mask);
+		}
+	}
+
+	const size_t index = findFirstAboveScalar(data + i, count - i, threshold);
+	return index == count - i ? count : i + index;
+}
+
+HYPERION_TARGET_SSE2 size_t findLastAboveSse2(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+
+	size_t i = count;
+	for (; i >= 16; i -= 16)
+	{
+		const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(aboveSse2(data + i - 16, limit)));
+		if (mask != 0)
+		{
+			return i - 16 + highestBit(mask);
+		}
+	}
+
+	const size_t index = findLastAboveScalar(data, i, threshold);
+	return index == i ? count : index;
+}
+
+#elif defined(HYPERION_SIMD_NEON)
+
+// The byte counters take up to 255 vectors before they are widened into 64 bit
+size_t countAboveNeon(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	const uint8x16_t limit = vdupq_n_u8(threshold);
+	uint64x2_t total = vdupq_n_u64(0);
+
+	size_t i = 0;
+	while (count - i >= 16)
+	{
+		const size_t end = i + 16 * std::min<size_t>(255, (count - i) / 16);
+		uint8x16_t counters = vdupq_n_u8(0);
+		for (; i < end; i += 16)
+		{
+			counters = vsubq_u8(counters, vcgeq_u8(vld1q_u8(data + i), limit));
+		}
+		total = vpadalq_u32(total, vpaddlq_u16(vpaddlq_u8(counters)));
+	}
+
+	return static_cast<size_t>(vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1)) + countAboveScalar(data + i, count - i, threshold);
+}
+
+inline bool anyAboveNeon(const uint8_t* data, uint8x16_t threshold)
+{
+	const uint64x2_t above = vreinterpretq_u64_u8(vcgeq_u8(vld1q_u8(data), threshold));
+	return (vgetq_lane_u64(above, 0) | vgetq_lane_u64(above, 1)) != 0;
+}
+
+// Vectors are tested as a whole, the byte is searched in the first one with a hit
+size_t findFirstAboveNeon(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	const uint8x16_t limit = vdupq_n_u8(threshold);
+
+	size_t i = 0;
+	for (; count - i >= 16; i += 16)
+	{
+		if (anyAboveNeon(data + i, limit))
+		{
+			return i + findFirstAboveScalar(data + i, 16, threshold);
+		}
+	}
+
+	const size_t index = findFirstAboveScalar(data + i, count - i, threshold);
+	return index == count - i ? count : i + index;
+}
+
+size_t findLastAboveNeon(const uint8_t* data, size_t count, uint8_t threshold)
+{
+	const uint8x16_t limit = vdupq_n_u8(threshold);
+
+	size_t i = count;
+	for (; i >= 16; i -= 16)
+	{
+		if (anyAboveNeon(data + i - 16, limit))
+		{
+			return i - 16 + findLastAboveScalar(data + i - 16, 16, threshold);
+		}
+	}
+
+	const size_t index = findLastAboveScalar(data, i, threshold);
+	return index == i ? count : index;
+}
+
+#endif
+
+const ScanKernels& scanKernels()
+{
+	static const ScanKernels kernels = []() -> ScanKernels
+	{
+#if defined(HYPERION_SIMD_X86)
+		if (CpuFeatures::hasSSE2())
+		{
+			return { countAboveSse2, findFirstAboveSse2, findLastAboveSse2, "sse2" };
+		}
+#elif defined(HYPERION_SIMD_NEON)
+		return { countAboveNeon, findFirstAboveNeon, findLastAboveNeon, "neon" };
+#endif
+		return { countAboveScalar, findFirstAboveScalar, findLastAboveScalar, "scalar" };
+	}();
+
+	return kernels;
+}
+
+} // namespace
+
 BlackBorderDetector::BlackBorderDetector(double threshold)
 	: _blackborderThreshold(calculateThreshold(threshold))
+	, _sceneWidth(0)
+	, _sceneHeight(0)
+	, _sceneStride(0)
+	, _sceneBorder({true, -1, -1})
 {
 	// empty
 }
@@ -27,3 +282,127 @@ uint8_t BlackBorderDetector::calculateThreshold(double threshold) const
 
 	return blackborderThreshold;
 }
+
+const char* BlackBorderDetector::scanKernelName()
+{
+	return scanKernels().name;
+}
+
+bool BlackBorderDetector::sceneChanged(const uint8_t* pixels, unsigned width, unsigned height, size_t stride)
+{
+	if (width == 0 || height == 0)
+	{
+		_sceneSamples.clear();
+		return true;
+	}
+
+	bool changed = width != _sceneWidth || height != _sceneHeight || stride != _sceneStride || _sceneSamples.empty();
+	if (changed)
+	{
+		_sampleOffsets.clear();
+		for (unsigned j = 0; j < SCENE_GRID; ++j)
+		{
+			for (unsigned i = 0; i < SCENE_GRID; ++i)
+			{
+				_sampleOffsets.push_back(scenePosition(j, height) * stride + 3 * static_cast<size_t>(scenePosition(i, width)));
+			}
+		}
+	}
+
+	_currentSamples.resize(3 * _sampleOffsets.size());
+	uint8_t* sample = _currentSamples.data();
+	for (const size_t offset : _sampleOffsets)
+	{
+		*sample++ = pixels[offset];
+		*sample++ = pixels[offset + 1];
+		*sample++ = pixels[offset + 2];
+	}
+
+	if (!changed)
+	{
+		unsigned difference = 0;
+		for (size_t i = 0; i < _currentSamples.size(); ++i)
+		{
+			difference += static_cast<unsigned>(std::abs(int(_currentSamples[i]) - int(_sceneSamples[i])));
+		}
+		changed = difference > SCENE_CHANGE_DIFFERENCE * _currentSamples.size();
+	}
+
+	if (changed)
+	{
+		_sceneSamples.swap(_currentSamples);
+		_sceneWidth = width;
+		_sceneHeight = height;
+		_sceneStride = stride;
+	}
+	return changed;
+}
+
+BlackBorder BlackBorderDetector::scan(const uint8_t* pixels, unsigned width, unsigned height, size_t stride)
+{
+	const ScanKernels& kernels = scanKernels();
+
+	const unsigned width33percent = width / 3;
+	const unsigned height33percent = height / 3;
+	const size_t rowBytes = 3 * static_cast<size_t>(width);
+
+	BlackBorder detectedBorder;
+	detectedBorder.unknown = true;
+	detectedBorder.horizontalSize = -1;
+	detectedBorder.verticalSize = -1;
+
+	// find the first picture row from the top and the bottom
+	const size_t minComponents = std::max<size_t>(1, width / PICTURE_LINE_FRACTION);
+	const auto isPictureRow = [&](unsigned y) {
+		return kernels.countAbove(pixels + y * stride, rowBytes, _blackborderThreshold) >= minComponents;
+	};
+
+	unsigned top = 0;
+	while (top < height33percent && !isPictureRow(top))
+	{
+		++top;
+	}
+	unsigned bottom = 0;
+	while (bottom < height33percent && !isPictureRow(height - 1 - bottom))
+	{
+		++bottom;
+	}
+
+	if (top == height33percent && bottom == height33percent)
+	{
+		// no picture in the outer thirds (dark scene)
+		return detectedBorder;
+	}
+	const unsigned horizontalSize = std::min(top, bottom);
+
+	// find the first non-black pixel from the left and the right side in each picture row
+	const size_t sideBytes = 3 * static_cast<size_t>(width33percent);
+	_leftEdges.clear();
+	_rightEdges.clear();
+	for (unsigned y = horizontalSize; y < height - horizontalSize; ++y)
+	{
+		const uint8_t* row = pixels + y * stride;
+
+		_leftEdges.push_back(static_cast<unsigned>(kernels.findFirstAbove(row, sideBytes, _blackborderThreshold) / 3));
+
+		const size_t last = kernels.findLastAbove(row + rowBytes - sideBytes, sideBytes, _blackborderThreshold);
+		_rightEdges.push_back(last == sideBytes ? width33percent : width33percent - 1 - static_cast<unsigned>(last / 3));
+	}
+
+	// the side border ends at the first column reached by one per PICTURE_LINE_FRACTION rows
+	const size_t rank = std::max<size_t>(1, _leftEdges.size() / PICTURE_LINE_FRACTION) - 1;
+	std::nth_element(_leftEdges.begin(), _leftEdges.begin() + rank, _leftEdges.end());
+	std::nth_element(_rightEdges.begin(), _rightEdges.begin() + rank, _rightEdges.end());
+	const unsigned verticalSize = std::min(_leftEdges[rank], _rightEdges[rank]);
+
+	if (verticalSize >= width33percent)
+	{
+		// no picture in the side thirds
+		return detectedBorder;
+	}
+
+	detectedBorder.unknown = false;
+	detectedBorder.horizontalSize = static_cast<int>(horizontalSize);
+	detectedBorder.verticalSize = static_cast<int>(verticalSize);
+	return detectedBorder;
+}
@@ -62,6 +62,7 @@ void BlackBorderProcessor::handleSettingsUpdate(settings::type type, const QJson
 		}
 
 		Debug(Logger::getInstance("BLACKBORDER"), "Set mode to: %s", QSTRING_CSTR(_detectionMode));
+		DebugIf(_detectionMode == "scan", Logger::getInstance("BLACKBORDER"), "Line scan uses %s", BlackBorderDetector::scanKernelName());
 
 		// eval the comp state
 		handleCompStateChangeRequest(hyperion::COMP_BLACKBORDER, obj["enable"].toBool(true));
@@ -103,6 +104,123 @@ void BlackBorderProcessor::setHardDisable(bool disable)
 	_hardDisabled = disable;
 };
 
+void BlackBorderProcessor::getProbeSpans(unsigned width, unsigned height, std::vector<SampleDemand::Span> & spans) const
+{
+	if (width == 0 || height == 0)
+	{
+		return;
+	}
+
+	const auto addRow = [&spans](unsigned y, unsigned xBegin, unsigned xEnd) {
+		spans.push_back({y, xBegin, xEnd});
+	};
+	const auto addColumn = [&spans](unsigned x, unsigned yBegin, unsigned yEnd) {
+		for (unsigned y = yBegin; y < yEnd; ++y)
+		{
+			spans.push_back({y, x, x + 1});
+		}
+	};
+
+	// the positions follow the loops of the BlackBorderDetector
+	const unsigned width33percent = width / 3;
+	const unsigned height33percent = height / 3;
+
+	if (_detectionMode == "default")
+	{
+		addRow(height / 2, width - width33percent, width);
+		addRow(height33percent, 0, width33percent);
+		addRow(height33percent * 2, 0, width33percent);
+		addColumn(width / 2, height - height33percent, height);
+		addColumn(width33percent, 0, height33percent);
+		addColumn(width33percent * 2, 0, height33percent);
+	}
+	else if (_detectionMode == "classic")
+	{
+		// the diagonal search and the expansion stay within the top left third
+		for (unsigned y = 0; y <= height33percent && y < height; ++y)
+		{
+			addRow(y, 0, width33percent + 1);
+		}
+	}
+	else if (_detectionMode == "osd")
+	{
+		addRow(height / 2, width - width33percent, width);
+		addRow(height33percent, 0, width33percent);
+		addRow(height33percent * 2, 0, width33percent);
+
+		// the vertical search runs at the found column in all four corners
+		for (unsigned y = 0; y < height33percent; ++y)
+		{
+			addRow(y, 0, width33percent + 1);
+			addRow(y, width - width33percent - 1, width);
+			addRow(height - 1 - y, 0, width33percent + 1);
+			addRow(height - 1 - y, width - width33percent - 1, width);
+		}
+	}
+	else if (_detectionMode == "letterbox")
+	{
+		addColumn(width / 2, 0, height33percent);
+		addColumn(width / 4, 0, height33percent);
+		addColumn(width / 4 * 3, 0, height33percent);
+		addColumn(width / 4, height - height33percent, height);
+		addColumn(width / 4 * 3, height - height33percent, height);
+	}
+	else if (_detectionMode == "scan")
+	{
+		// whole rows of the top and bottom third, the side thirds of the rows between them
+		for (unsigned y = 0; y < height; ++y)
+		{
+			if (y < height33percent || y >= height - height33percent)
+			{
+				addRow(y, 0, width);
+			}
+			else
+			{
+				addRow(y, 0, width33percent);
+				addRow(y, width - width33percent, width);
+			}
+		}
+
+		// the grid of the scene change check
+		for (unsigned j = 0; j < BlackBorderDetector::SCENE_GRID; ++j)
+		{
+			const unsigned y = BlackBorderDetector::scenePosition(j, height);
+			for (unsigned i = 0; i < BlackBorderDetector::SCENE_GRID; ++i)
+			{
+				const unsigned x = BlackBorderDetector::scenePosition(i, width);
+				addRow(y, x, x + 1);
+			}
+		}
+	}
+}
+
+bool BlackBorderProcessor::processDetected(BlackBorder imageBorder)
+{
+	if (!enabled())
+	{
+		imageBorder = BlackBorder{true, 0, 0};
+		_currentBorder = imageBorder;
+		return true;
+	}
+
+	// add blur to the border
+	if (imageBorder.horizontalSize > 0)
+	{
+		imageBorder.horizontalSize += _blurRemoveCnt;
+	}
+	if (imageBorder.verticalSize > 0)
+	{
+		imageBorder.verticalSize += _blurRemoveCnt;
+	}
+
+	return updateBorder(imageBorder);
+}
+
+QString BlackBorderProcessor::detectionKey() const
+{
+	return _detectionMode + "/" + QString::number(_oldThreshold);
+}
+
 BlackBorder BlackBorderProcessor::getCurrentBorder() const
 {
 	return _currentBorder;
@@ -199,13 +199,14 @@ void BoblightClientConnection::handleMessage(const QString & message)
 				const int prio = static_cast<int>(parseUInt(messageParts[2], &rc));
 				if (rc && prio != _priority)
 				{
-					if (_priority != 0 && _hyperion->getPriorityInfo(_priority).componentId == hyperion::COMP_BOBLIGHTSERVER)
+					if (_priority != 0 && _hyperion->getPrioritySnapshot()->getInputInfo(_priority).componentId == hyperion::COMP_BOBLIGHTSERVER)
 						_hyperion->clear(_priority);
 
 					if (prio < 128 || prio >= 254)
 					{
 						_priority = 128;
-						while (_hyperion->getActivePriorities().contains(_priority))
+						const PriorityMuxer::SnapshotPtr prioritySnapshot = _hyperion->getPrioritySnapshot();
+						while (prioritySnapshot->hasPriority(_priority))
 						{
 							_priority += 1;
 						}
@@ -6,6 +6,7 @@
 // hyperion
 #include <hyperion/Hyperion.h>
 #include <utils/Logger.h>
+#include <utils/LatencyTracker.h>
 
 // qt
 #include <QJsonArray>
@@ -218,6 +219,7 @@ PyObject* EffectModule::wrapSetImage(PyObject *self, PyObject *args)
 				Image<ColorRgb> image(width, height);
 				char * data = PyByteArray_AS_STRING(bytearray);
 				memcpy(image.memptr(), data, length);
+				image.setCaptureTime(LatencyTracker::now());
 				emit getEffect()->setInputImage(getEffect()->_priority, image, timeout, false);
 				Py_RETURN_NONE;
 			}
@@ -375,6 +377,7 @@ PyObject* EffectModule::wrapImageShow(PyObject *self, PyObject *args)
 	}
 
 	memcpy(image.memptr(), binaryImage.data(), binaryImage.size());
+	image.setCaptureTime(LatencyTracker::now());
 	emit getEffect()->setInputImage(getEffect()->_priority, image, timeout, false);
 
 	return Py_BuildValue("");
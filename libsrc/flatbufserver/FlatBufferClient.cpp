@@ -6,6 +6,9 @@
 #include <QTimer>
 #include <QRgb>
 
+// utils
+#include <utils/LatencyTracker.h>
+
 FlatBufferClient::FlatBufferClient(QTcpSocket* socket, int timeout, QObject *parent)
 	: QObject(parent)
 	, _log(Logger::getInstance("FLATBUFSERVER"))
@@ -158,9 +161,10 @@ void FlatBufferClient::handleImageCommand(const hyperionnet::Image *image)
 			return;
 		}
 
-		Image<ColorRgb> imageDest(width, height);
-		memmove(imageDest.memptr(), imageData->data(), imageData->size());
-		emit setGlobalInputImage(_priority, imageDest, duration);
+		// view of the receive buffer, copied only if it is kept (e.g. as input of an instance)
+		Image<ColorRgb> imageView(reinterpret_cast<const ColorRgb*>(imageData->data()), width, height);
+		imageView.setCaptureTime(LatencyTracker::now());
+		emit setGlobalInputImage(_priority, imageView, duration);
 	}
 
 	// send reply
@@ -126,7 +126,14 @@ void FlatBufferConnection::setColor(const ColorRgb & color, int priority, int du
 
 void FlatBufferConnection::setImage(const Image<ColorRgb> &image)
 {
-	auto imgData = _builder.CreateVector(reinterpret_cast<const uint8_t*>(image.memptr()), image.size());
+	// copy the rows directly into the message, the image may be a view with padded rows
+	uint8_t* buffer = nullptr;
+	auto imgData = _builder.CreateUninitializedVector(image.size(), &buffer);
+	const size_t rowSize = image.width() * sizeof(ColorRgb);
+	for (unsigned y = 0; y < image.height(); ++y)
+	{
+		memcpy(buffer + y * rowSize, image.row(y), rowSize);
+	}
 	auto rawImg = hyperionnet::CreateRawImage(_builder, imgData, image.width(), image.height());
 	auto imageReq = hyperionnet::CreateImage(_builder, hyperionnet::ImageType_RawImage, rawImg.Union(), -1);
 	auto req = hyperionnet::CreateRequest(_builder,hyperionnet::Command_Image,imageReq.Union());
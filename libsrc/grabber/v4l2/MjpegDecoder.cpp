@@ -0,0 +1,180 @@
+#include "MjpegDecoder.h"
+
+#ifdef HAVE_JPEG_DECODER
+
+// stl includes
+#include <algorithm>
+
+MjpegDecoder::~MjpegDecoder()
+{
+#ifdef HAVE_JPEG
+	if (_decompress != nullptr)
+	{
+		jpeg_destroy_decompress(_decompress);
+		delete _decompress;
+		delete _error;
+	}
+#endif
+#ifdef HAVE_TURBO_JPEG
+	if (_decompress != nullptr)
+	{
+		tjDestroy(_decompress);
+	}
+#endif
+}
+
+bool MjpegDecoder::decode(const uint8_t * data, int size, int decimation, int cropLeft, int cropRight, int cropTop, int cropBottom, Image<ColorRgb> & image)
+{
+	// the decoder scales by 1/2, 1/4 or 1/8 at almost no cost, the remaining decimation is subsampled
+	decimation = std::max(1, decimation);
+	int scale = 8;
+	while (decimation % scale != 0)
+	{
+		scale /= 2;
+	}
+	const int subsampling = decimation / scale;
+
+	// the cropped part of the scaled frame: first pixel, row distance and size
+	const uint8_t* pixels = nullptr;
+	size_t stride = 0;
+	int width = 0;
+	int height = 0;
+
+#ifdef HAVE_JPEG
+	if (_decompress == nullptr)
+	{
+		_decompress = new jpeg_decompress_struct;
+		_error = new errorManager;
+
+		_decompress->err = jpeg_std_error(&_error->pub);
+		_error->pub.error_exit = &errorHandler;
+		_error->pub.output_message = &outputHandler;
+
+		jpeg_create_decompress(_decompress);
+	}
+
+	if (setjmp(_error->setjmp_buffer))
+	{
+		// the context is kept for the next frame
+		jpeg_abort_decompress(_decompress);
+		return false;
+	}
+
+	jpeg_mem_src(_decompress, const_cast<uint8_t*>(data), size);
+
+	if (jpeg_read_header(_decompress, (bool) TRUE) != JPEG_HEADER_OK)
+	{
+		jpeg_abort_decompress(_decompress);
+		return false;
+	}
+
+	_decompress->scale_num = 1;
+	_decompress->scale_denom = scale;
+	_decompress->out_color_space = JCS_RGB;
+	_decompress->dct_method = JDCT_IFAST;
+	_decompress->do_fancy_upsampling = FALSE;
+	_error->pub.num_warnings = 0;
+
+	if (!jpeg_start_decompress(_decompress) || _decompress->out_color_components != 3)
+	{
+		jpeg_abort_decompress(_decompress);
+		return false;
+	}
+
+	const int scaledCropLeft = cropLeft / scale;
+	const int scaledCropTop = cropTop / scale;
+	width = static_cast<int>(_decompress->output_width) - scaledCropLeft - cropRight / scale;
+	height = static_cast<int>(_decompress->output_height) - scaledCropTop - cropBottom / scale;
+	if (width <= 0 || height <= 0)
+	{
+		jpeg_abort_decompress(_decompress);
+		return false;
+	}
+
+	JDIMENSION xOffset = 0;
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER)
+	// decode the cropped columns only, widened by the decoder to its block boundaries
+	JDIMENSION cropWidth = static_cast<JDIMENSION>(width);
+	xOffset = static_cast<JDIMENSION>(scaledCropLeft);
+	jpeg_crop_scanline(_decompress, &xOffset, &cropWidth);
+	jpeg_skip_scanlines(_decompress, static_cast<JDIMENSION>(scaledCropTop));
+#else
+	// skip the cropped rows
+	_decodedFrame.resize(static_cast<size_t>(_decompress->output_width) * 3);
+	for (int y = 0; y < scaledCropTop; ++y)
+	{
+		JSAMPROW row = _decodedFrame.data();
+		jpeg_read_scanlines(_decompress, &row, 1);
+	}
+#endif
+
+	stride = static_cast<size_t>(_decompress->output_width) * 3;
+	_decodedFrame.resize(stride * height);
+	for (int y = 0; y < height; ++y)
+	{
+		JSAMPROW row = _decodedFrame.data() + y * stride;
+		jpeg_read_scanlines(_decompress, &row, 1);
+	}
+
+	// the rows below the crop are not decoded
+	jpeg_abort_decompress(_decompress);
+
+	if (_error->pub.num_warnings > 0)
+		return false;
+
+	pixels = _decodedFrame.data() + (scaledCropLeft - static_cast<int>(xOffset)) * 3;
+#endif
+#ifdef HAVE_TURBO_JPEG
+	if (_decompress == nullptr && (_decompress = tjInitDecompress()) == nullptr)
+		return false;
+
+	int jpegWidth = 0;
+	int jpegHeight = 0;
+	if (tjDecompressHeader2(_decompress, const_cast<uint8_t*>(data), size, &jpegWidth, &jpegHeight, &_subsamp) != 0)
+		return false;
+
+	const tjscalingfactor scalingFactor = { 1, scale };
+	const int scaledWidth = TJSCALED(jpegWidth, scalingFactor);
+	const int scaledHeight = TJSCALED(jpegHeight, scalingFactor);
+	const int scaledCropLeft = cropLeft / scale;
+	const int scaledCropTop = cropTop / scale;
+	width = scaledWidth - scaledCropLeft - cropRight / scale;
+	height = scaledHeight - scaledCropTop - cropBottom / scale;
+	if (width <= 0 || height <= 0)
+		return false;
+
+	// TurboJPEG decodes whole frames, the crop is a view of the decoded frame
+	stride = static_cast<size_t>(scaledWidth) * 3;
+	_decodedFrame.resize(stride * scaledHeight);
+	if (tjDecompress2(_decompress, const_cast<uint8_t*>(data), size, _decodedFrame.data(), scaledWidth, static_cast<int>(stride), scaledHeight, TJPF_RGB, TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
+		return false;
+
+	pixels = _decodedFrame.data() + scaledCropTop * stride + scaledCropLeft * 3;
+#endif
+
+	if (subsampling == 1)
+	{
+		// no copy, the view is valid until the next frame
+		Image<ColorRgb> frame(reinterpret_cast<const ColorRgb*>(pixels), width, height, stride);
+		image.swap(frame);
+		return true;
+	}
+
+	const unsigned outputWidth = std::max(1, width / subsampling);
+	const unsigned outputHeight = std::max(1, height / subsampling);
+	image.resize(outputWidth, outputHeight);
+	// all pixels are decoded, see ImageResampler
+	image.setSampleGeneration(0);
+	ColorRgb* output = image.memptr();
+	for (unsigned y = 0; y < outputHeight; ++y)
+	{
+		const ColorRgb* row = reinterpret_cast<const ColorRgb*>(pixels + y * subsampling * stride);
+		for (unsigned x = 0; x < outputWidth; ++x)
+		{
+			*output++ = row[x * subsampling];
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+
+#ifdef HAVE_JPEG_DECODER
+
+// stl includes
+#include <cstdint>
+#include <vector>
+
+// util includes
+#include <utils/ColorRgb.h>
+#include <utils/Image.h>
+
+// System JPEG decoder
+#ifdef HAVE_JPEG
+	#include <cstdio>
+	#include <jpeglib.h>
+	#include <csetjmp>
+#endif
+
+// TurboJPEG decoder
+#ifdef HAVE_TURBO_JPEG
+	#include <turbojpeg.h>
+#endif
+
+///
+/// Decodes MJPEG frames of a V4L2 device, cropped and decimated.
+///
+/// The decoder context and the pixel buffer are created with the first frame and reused for the
+/// following ones. A decoder is used by one thread at a time, the capture pipeline owns one per
+/// decode worker.
+///
+class MjpegDecoder
+{
+public:
+	MjpegDecoder() = default;
+	~MjpegDecoder();
+
+	MjpegDecoder(const MjpegDecoder&) = delete;
+	MjpegDecoder& operator=(const MjpegDecoder&) = delete;
+
+	///
+	/// @brief Decode a frame. The frame is scaled down by the decoder (in the DCT domain) by the
+	/// largest power of two up to 8 dividing the pixel decimation, the rest of the decimation is
+	/// done by subsampling.
+	///
+	/// @param data        The compressed frame
+	/// @param size        The size of the compressed frame
+	/// @param decimation  The pixel decimation
+	/// @param cropLeft    The pixels to crop from the left of the full size frame
+	/// @param cropRight   The pixels to crop from the right of the full size frame
+	/// @param cropTop     The pixels to crop from the top of the full size frame
+	/// @param cropBottom  The pixels to crop from the bottom of the full size frame
+	/// @param image       The resulting image, a view of the decoder's buffer (valid until the next
+	///                    frame) if the decoder covers the decimation
+	///
+	/// @return True if the frame was decoded
+	///
+	bool decode(const uint8_t * data, int size, int decimation, int cropLeft, int cropRight, int cropTop, int cropBottom, Image<ColorRgb> & image);
+
+private:
+#ifdef HAVE_JPEG
+	struct errorManager
+	{
+		jpeg_error_mgr pub;
+		jmp_buf setjmp_buffer;
+	};
+
+	static void errorHandler(j_common_ptr cInfo)
+	{
+		errorManager* mgr = reinterpret_cast<errorManager*>(cInfo->err);
+		longjmp(mgr->setjmp_buffer, 1);
+	}
+
+	static void outputHandler(j_common_ptr cInfo)
+	{
+		// Suppress fprintf warnings.
+	}
+
+	jpeg_decompress_struct* _decompress = nullptr;
+	errorManager* _error = nullptr;
+#endif
+
+#ifdef HAVE_TURBO_JPEG
+	tjhandle _decompress = nullptr;
+	int _subsamp = 0;
+#endif
+
+	/// Pixels of the last decoded frame, reused by the next one
+	std::vector<uint8_t> _decodedFrame;
+};
+
+#endif
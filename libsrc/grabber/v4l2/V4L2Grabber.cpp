@@ -5,10 +5,13 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <sstream>
 
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
+#include <sys/eventfd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/time.h>
@@ -18,11 +21,15 @@
 
 #include <hyperion/Hyperion.h>
 #include <hyperion/HyperionIManager.h>
+#include <utils/SampleDemand.h>
+#include <utils/LatencyTracker.h>
+#include <utils/Tracer.h>
 
 #include <QDirIterator>
 #include <QFileInfo>
 
 #include "grabber/V4L2Grabber.h"
+#include "MjpegDecoder.h"
 
 #define CLEAR(x) memset(&(x), 0, sizeof(x))
 
@@ -30,6 +37,27 @@
 #define V4L2_CAP_META_CAPTURE 0x00800000 // Specified in kernel header v4.16. Required for backward compatibility.
 #endif
 
+namespace {
+
+/// Raw frames are converted in the driver buffer only while the driver has this many other buffers to fill
+const int MIN_QUEUED_BUFFERS = 2;
+
+/// Upper limit of the MJPEG decode workers, a frame takes a few milliseconds at most
+const unsigned MAX_DECODE_WORKERS = 3;
+
+/// Number of frame copies kept for reuse
+const size_t MAX_SPARE_FRAMES = 4;
+
+} // namespace
+
+struct V4L2Grabber::DecodeWorker
+{
+	std::thread thread;
+#ifdef HAVE_JPEG_DECODER
+	MjpegDecoder decoder;
+#endif
+};
+
 V4L2Grabber::V4L2Grabber(const QString & device
 		, unsigned width
 		, unsigned height
@@ -60,7 +88,18 @@ V4L2Grabber::V4L2Grabber(const QString & device
 	, _y_frac_min(0.25)
 	, _x_frac_max(0.75)
 	, _y_frac_max(0.75)
-	, _streamNotifier(nullptr)
+	, _signalDemandWidth(0)
+	, _signalDemandHeight(0)
+	, _decodeWorkers()
+	, _wakeupFd(-1)
+	, _pipelineQuit(true)
+	, _queuedBuffers(0)
+	, _frameSequence(0)
+	, _pendingFrames()
+	, _pendingCapacity(1)
+	, _handoffImage()
+	, _handoffPending(false)
+	, _handoffSequence(0)
 	, _initialized(false)
 	, _deviceAutoDiscoverEnabled(false)
 {
@@ -77,6 +116,7 @@ V4L2Grabber::V4L2Grabber(const QString & device
 V4L2Grabber::~V4L2Grabber()
 {
 	uninit();
+	SampleDemand::getInstance()->removeConsumer(this);
 }
 
 void V4L2Grabber::uninit()
@@ -293,6 +333,10 @@ void V4L2Grabber::setSignalDetectionOffset(double horizontalMin, double vertical
 	_x_frac_max = horizontalMax;
 	_y_frac_max = verticalMax;
 
+	// publish the new area with the next frame
+	_signalDemandWidth = 0;
+	_signalDemandHeight = 0;
+
 	Info(_log, "Signal detection area set to: %f,%f x %f,%f", _x_frac_min, _y_frac_min, _x_frac_max, _y_frac_max );
 }
 
@@ -300,10 +344,10 @@ bool V4L2Grabber::start()
 {
 	try
 	{
-		if (init() && _streamNotifier != nullptr && !_streamNotifier->isEnabled())
+		if (init() && !_dequeueThread.joinable())
 		{
-			_streamNotifier->setEnabled(true);
 			start_capturing();
+			startPipeline();
 			Info(_log, "Started");
 			return true;
 		}
@@ -318,10 +362,10 @@ bool V4L2Grabber::start()
 
 void V4L2Grabber::stop()
 {
-	if (_streamNotifier != nullptr && _streamNotifier->isEnabled())
+	if (_dequeueThread.joinable())
 	{
+		stopPipeline();
 		stop_capturing();
-		_streamNotifier->setEnabled(false);
 		uninit_device();
 		close_device();
 		_initialized = false;
@@ -354,10 +398,6 @@ bool V4L2Grabber::open_device()
 		return false;
 	}
 
-	// create the notifier for when a new frame is available
-	_streamNotifier = new QSocketNotifier(_fileDescriptor, QSocketNotifier::Read);
-	_streamNotifier->setEnabled(false);
-	connect(_streamNotifier, &QSocketNotifier::activated, this, &V4L2Grabber::read_frame);
 	return true;
 }
 
@@ -370,9 +410,6 @@ void V4L2Grabber::close_device()
 	}
 
 	_fileDescriptor = -1;
-
-	delete _streamNotifier;
-	_streamNotifier = nullptr;
 }
 
 void V4L2Grabber::init_read(unsigned int buffer_size)
@@ -659,6 +696,14 @@ void V4L2Grabber::init_device(VideoStandard videoStandard)
 			fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_RGB32;
 		break;
 
+		case PixelFormat::NV12:
+			fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_NV12;
+		break;
+
+		case PixelFormat::I420:
+			fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUV420;
+		break;
+
 #ifdef HAVE_JPEG_DECODER
 		case PixelFormat::MJPEG:
 		{
@@ -744,6 +789,22 @@ void V4L2Grabber::init_device(VideoStandard videoStandard)
 		}
 		break;
 
+		case V4L2_PIX_FMT_NV12:
+		{
+			_pixelFormat = PixelFormat::NV12;
+			_frameByteSize = (_width * _height * 3) / 2;
+			Debug(_log, "Pixel format=NV12");
+		}
+		break;
+
+		case V4L2_PIX_FMT_YUV420:
+		{
+			_pixelFormat = PixelFormat::I420;
+			_frameByteSize = (_width * _height * 3) / 2;
+			Debug(_log, "Pixel format=I420");
+		}
+		break;
+
 #ifdef HAVE_JPEG_DECODER
 		case V4L2_PIX_FMT_MJPEG:
 		{
@@ -755,13 +816,25 @@ void V4L2Grabber::init_device(VideoStandard videoStandard)
 
 		default:
 #ifdef HAVE_JPEG_DECODER
-			throw_exception("Only pixel formats UYVY, YUYV, RGB32 and MJPEG are supported");
+			throw_exception("Only pixel formats UYVY, YUYV, RGB32, NV12, I420 and MJPEG are supported");
 #else
-			throw_exception("Only pixel formats UYVY, YUYV, and RGB32 are supported");
+			throw_exception("Only pixel formats UYVY, YUYV, RGB32, NV12 and I420 are supported");
 #endif
 		return;
 	}
 
+	// HD sources encode YUV with the BT.709 matrix, the driver tells which one it uses
+	{
+		const unsigned encoding = (fmt.fmt.pix.priv == V4L2_PIX_FMT_PRIV_MAGIC)
+				? fmt.fmt.pix.ycbcr_enc
+				: V4L2_MAP_YCBCR_ENC_DEFAULT(fmt.fmt.pix.colorspace);
+		const YuvMatrix matrix = (encoding == V4L2_YCBCR_ENC_709) ? YuvMatrix::BT709 : YuvMatrix::BT601;
+
+		std::lock_guard<std::mutex> lock(_decodeSettingsMutex);
+		_imageResampler.setYuvMatrix(matrix);
+		Debug(_log, "YUV matrix=%s", matrix == YuvMatrix::BT709 ? "BT.709" : "BT.601");
+	}
+
 	switch (_ioMethod)
 	{
 		case IO_METHOD_READ:
@@ -890,285 +963,427 @@ void V4L2Grabber::stop_capturing()
 	}
 }
 
-int V4L2Grabber::read_frame()
+void V4L2Grabber::startPipeline()
 {
-	bool rc = false;
+	_wakeupFd = eventfd(0, EFD_CLOEXEC);
+	if (_wakeupFd == -1)
+	{
+		throw_errno_exception("eventfd");
+		return;
+	}
 
-	try
+	_queuedBuffers = (_ioMethod == IO_METHOD_READ) ? 0 : static_cast<int>(_buffers.size());
+	_frameSequence = 0;
+	_handoffSequence = 0;
+
+	// decoding MJPEG is the expensive stage and worth spreading over the cores, raw frames are converted by one worker
+	unsigned workers = 1;
+	if (_pixelFormat == PixelFormat::MJPEG)
 	{
-		struct v4l2_buffer buf;
+		const unsigned cores = std::thread::hardware_concurrency();
+		workers = std::max(1u, std::min(MAX_DECODE_WORKERS, cores > 1 ? cores - 1 : 1));
+	}
 
-		switch (_ioMethod)
-		{
-			case IO_METHOD_READ:
-			{
-				int size;
-				if ((size = read(_fileDescriptor, _buffers[0].start, _buffers[0].length)) == -1)
-				{
-					switch (errno)
-					{
-						case EAGAIN:
-							return 0;
+	{
+		std::lock_guard<std::mutex> lock(_pendingMutex);
+		_pendingCapacity = workers;
+		_pipelineQuit = false;
+	}
 
-						case EIO: /* Could ignore EIO, see spec. */
-						default:
-							throw_errno_exception("read");
-						return 0;
-					}
-				}
+	for (unsigned i = 0; i < workers; ++i)
+	{
+		_decodeWorkers.emplace_back(new DecodeWorker);
+		DecodeWorker* worker = _decodeWorkers.back().get();
+		worker->thread = std::thread(&V4L2Grabber::runDecodeWorker, this, worker);
+	}
+	_dequeueThread = std::thread(&V4L2Grabber::runDequeue, this);
 
-				rc = process_image(_buffers[0].start, size);
-			}
+	Debug(_log, "Capture pipeline started with %u decode worker(s)", workers);
+}
+
+void V4L2Grabber::stopPipeline()
+{
+	{
+		std::lock_guard<std::mutex> lock(_pendingMutex);
+		_pipelineQuit = true;
+	}
+	_pendingCondition.notify_all();
+
+	const uint64_t wakeup = 1;
+	if (_wakeupFd != -1 && write(_wakeupFd, &wakeup, sizeof(wakeup)) == -1)
+	{
+		throw_errno_exception("eventfd write");
+	}
+
+	if (_dequeueThread.joinable())
+	{
+		_dequeueThread.join();
+	}
+	for (const auto& worker : _decodeWorkers)
+	{
+		worker->thread.join();
+	}
+	_decodeWorkers.clear();
+
+	if (_wakeupFd != -1)
+	{
+		close(_wakeupFd);
+		_wakeupFd = -1;
+	}
+
+	// the driver reclaims the pinned buffers with the end of streaming
+	{
+		std::lock_guard<std::mutex> lock(_pendingMutex);
+		_pendingFrames.clear();
+		_spareFrameData.clear();
+	}
+	{
+		Image<ColorRgb> empty;
+		std::lock_guard<std::mutex> lock(_handoffMutex);
+		_handoffImage.swap(empty);
+		_handoffPending = false;
+	}
+}
+
+void V4L2Grabber::runDequeue()
+{
+	pollfd fds[2];
+	fds[0].fd = _fileDescriptor;
+	fds[0].events = POLLIN;
+	fds[1].fd = _wakeupFd;
+	fds[1].events = POLLIN;
+
+	while (!_pipelineQuit)
+	{
+		if (poll(fds, 2, -1) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			throw_errno_exception("poll");
+			// stop and rescan the devices as for a failed dequeue
+			QMetaObject::invokeMethod(this, "dequeueFailed", Qt::QueuedConnection);
 			break;
+		}
 
-			case IO_METHOD_MMAP:
-			{
-				CLEAR(buf);
+		if (fds[1].revents != 0)
+			break;
 
-				buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-				buf.memory = V4L2_MEMORY_MMAP;
+		if (fds[0].revents != 0 && !dequeueFrame())
+		{
+			// stopping joins this thread, the grabber's thread does it
+			QMetaObject::invokeMethod(this, "dequeueFailed", Qt::QueuedConnection);
+			break;
+		}
+	}
+}
 
-				if (-1 == xioctl(VIDIOC_DQBUF, &buf))
-				{
-					switch (errno)
-					{
-						case EAGAIN:
-							return 0;
-
-						case EIO: /* Could ignore EIO, see spec. */
-						default:
-						{
-							throw_errno_exception("VIDIOC_DQBUF");
-							stop();
-							getV4Ldevices();
-						}
-						return 0;
-					}
-				}
+bool V4L2Grabber::dequeueFrame()
+{
+	TRACE_SCOPE("v4l2.dequeue");
 
-				assert(buf.index < _buffers.size());
+	CapturedFrame frame;
+	{
+		std::lock_guard<std::mutex> lock(_pendingMutex);
+		if (!_spareFrameData.empty())
+		{
+			frame.data = std::move(_spareFrameData.back());
+			_spareFrameData.pop_back();
+		}
+	}
 
-				rc = process_image(_buffers[buf.index].start, buf.bytesused);
+	switch (_ioMethod)
+	{
+		case IO_METHOD_READ:
+		{
+			// read right into the copy, the read buffer of the driver is its own
+			frame.data.resize(_buffers[0].length);
+			const ssize_t size = read(_fileDescriptor, frame.data.data(), frame.data.size());
+			if (size == -1)
+			{
+				if (errno == EAGAIN)
+					return true;
 
-				if (-1 == xioctl(VIDIOC_QBUF, &buf))
-				{
-					throw_errno_exception("VIDIOC_QBUF");
-					return 0;
-				}
+				/* EIO could be ignored, see spec. */
+				throw_errno_exception("read");
+				return true;
 			}
-			break;
 
-			case IO_METHOD_USERPTR:
+			frame.captureTime = LatencyTracker::now();
+			frame.size = static_cast<int>(size);
+			++_pipelineStats.copied;
+		}
+		break;
+
+		case IO_METHOD_MMAP:
+		case IO_METHOD_USERPTR:
+		{
+			struct v4l2_buffer buf;
+			CLEAR(buf);
+
+			buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			buf.memory = (_ioMethod == IO_METHOD_MMAP) ? V4L2_MEMORY_MMAP : V4L2_MEMORY_USERPTR;
+
+			if (-1 == xioctl(VIDIOC_DQBUF, &buf))
 			{
-				CLEAR(buf);
+				if (errno == EAGAIN)
+					return true;
 
-				buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-				buf.memory = V4L2_MEMORY_USERPTR;
+				/* EIO could be ignored, see spec. */
+				throw_errno_exception("VIDIOC_DQBUF");
+				return false;
+			}
 
-				if (-1 == xioctl(VIDIOC_DQBUF, &buf))
-				{
-					switch (errno)
-					{
-						case EAGAIN:
-							return 0;
-
-						case EIO: /* Could ignore EIO, see spec. */
-						default:
-						{
-							throw_errno_exception("VIDIOC_DQBUF");
-							stop();
-							getV4Ldevices();
-						}
-						return 0;
-					}
-				}
+			const int queued = --_queuedBuffers;
 
+			int index = static_cast<int>(buf.index);
+			if (_ioMethod == IO_METHOD_USERPTR)
+			{
 				for (size_t i = 0; i < _buffers.size(); ++i)
 				{
 					if (buf.m.userptr == (unsigned long)_buffers[i].start && buf.length == _buffers[i].length)
 					{
+						index = static_cast<int>(i);
 						break;
 					}
 				}
+			}
 
-				rc = process_image((void *)buf.m.userptr, buf.bytesused);
+			assert(index >= 0 && static_cast<size_t>(index) < _buffers.size());
 
-				if (-1 == xioctl(VIDIOC_QBUF, &buf))
-				{
-					throw_errno_exception("VIDIOC_QBUF");
-					return 0;
-				}
+			frame.captureTime = captureTimeOf(buf);
+			frame.size = static_cast<int>(buf.bytesused);
+
+			// compressed frames are small and copied, raw frames are converted in place unless the driver runs short of buffers
+			if (_pixelFormat != PixelFormat::MJPEG && queued >= MIN_QUEUED_BUFFERS)
+			{
+				frame.pinnedBuffer = index;
+				++_pipelineStats.pinned;
+			}
+			else
+			{
+				const uint8_t* start = static_cast<const uint8_t*>(_buffers[index].start);
+				frame.data.assign(start, start + buf.bytesused);
+				++_pipelineStats.copied;
+
+				if (!requeueBuffer(index))
+					return false;
 			}
-			break;
 		}
+		break;
 	}
-	catch (std::exception& e)
+
+#ifdef HAVE_JPEG_DECODER
+	if (frame.size < _frameByteSize && _pixelFormat != PixelFormat::MJPEG)
+#else
+	if (frame.size < _frameByteSize)
+#endif
 	{
-		emit readError(e.what());
-		rc = false;
+		Error(_log, "Frame too small: %d != %d", frame.size, _frameByteSize);
+		return frame.pinnedBuffer < 0 || requeueBuffer(frame.pinnedBuffer);
 	}
 
-	return rc ? 1 : 0;
+	frame.sequence = ++_frameSequence;
+	++_pipelineStats.captured;
+
+	std::lock_guard<std::mutex> lock(_pendingMutex);
+	if (_pendingFrames.size() >= _pendingCapacity)
+	{
+		// the decode workers fall behind, the oldest frame is outdated anyway
+		CapturedFrame& oldest = _pendingFrames.front();
+		if (oldest.pinnedBuffer >= 0 && !requeueBuffer(oldest.pinnedBuffer))
+			return false;
+
+		if (_spareFrameData.size() < MAX_SPARE_FRAMES)
+			_spareFrameData.push_back(std::move(oldest.data));
+
+		_pendingFrames.pop_front();
+		++_pipelineStats.queueDropped;
+	}
+	_pendingFrames.push_back(std::move(frame));
+	TRACE_COUNTER("v4l2.pending", _pendingFrames.size());
+	_pendingCondition.notify_one();
+
+	return true;
 }
 
-bool V4L2Grabber::process_image(const void *p, int size)
+bool V4L2Grabber::requeueBuffer(int index)
 {
-	// We do want a new frame...
-#ifdef HAVE_JPEG_DECODER
-	if (size < _frameByteSize && _pixelFormat != PixelFormat::MJPEG)
-#else
-	if (size < _frameByteSize)
-#endif
+	struct v4l2_buffer buf;
+	CLEAR(buf);
+
+	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buf.index = static_cast<uint32_t>(index);
+	if (_ioMethod == IO_METHOD_MMAP)
 	{
-		Error(_log, "Frame too small: %d != %d", size, _frameByteSize);
+		buf.memory = V4L2_MEMORY_MMAP;
 	}
 	else
 	{
-		process_image(reinterpret_cast<const uint8_t *>(p), size);
-		return true;
+		buf.memory = V4L2_MEMORY_USERPTR;
+		buf.m.userptr = (unsigned long)_buffers[index].start;
+		buf.length = _buffers[index].length;
 	}
 
-	return false;
+	if (-1 == xioctl(VIDIOC_QBUF, &buf))
+	{
+		throw_errno_exception("VIDIOC_QBUF");
+		return false;
+	}
+
+	++_queuedBuffers;
+	return true;
 }
 
-void V4L2Grabber::process_image(const uint8_t * data, int size)
+void V4L2Grabber::dequeueFailed()
 {
-	if (_cecDetectionEnabled && _cecStandbyActivated)
-		return;
+	stop();
+	getV4Ldevices();
+}
 
-	Image<ColorRgb> image(_width, _height);
+int64_t V4L2Grabber::captureTimeOf(const struct v4l2_buffer& buf)
+{
+	// the driver stamps the buffer when its first byte was captured, on the clock of LatencyTracker
+	if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC && (buf.timestamp.tv_sec != 0 || buf.timestamp.tv_usec != 0))
+	{
+		return static_cast<int64_t>(buf.timestamp.tv_sec) * 1000000 + buf.timestamp.tv_usec;
+	}
+	return LatencyTracker::now();
+}
 
-/* ----------------------------------------------------------
- * ----------- BEGIN of JPEG decoder related code -----------
- * --------------------------------------------------------*/
+void V4L2Grabber::runDecodeWorker(DecodeWorker* worker)
+{
+	CapturedFrame frame;
 
-#ifdef HAVE_JPEG_DECODER
-	if (_pixelFormat == PixelFormat::MJPEG)
+	while (true)
 	{
-#endif
-#ifdef HAVE_JPEG
-		_decompress = new jpeg_decompress_struct;
-		_error = new errorManager;
-
-		_decompress->err = jpeg_std_error(&_error->pub);
-		_error->pub.error_exit = &errorHandler;
-		_error->pub.output_message = &outputHandler;
+		{
+			std::unique_lock<std::mutex> lock(_pendingMutex);
+			if (frame.data.capacity() != 0 && _spareFrameData.size() < MAX_SPARE_FRAMES)
+			{
+				_spareFrameData.push_back(std::move(frame.data));
+			}
 
-		jpeg_create_decompress(_decompress);
+			_pendingCondition.wait(lock, [this]() { return _pipelineQuit || !_pendingFrames.empty(); });
+			if (_pipelineQuit)
+				return;
 
-		if (setjmp(_error->setjmp_buffer))
-		{
-			jpeg_abort_decompress(_decompress);
-			jpeg_destroy_decompress(_decompress);
-			delete _decompress;
-			delete _error;
-			return;
+			frame = std::move(_pendingFrames.front());
+			_pendingFrames.pop_front();
 		}
 
-		jpeg_mem_src(_decompress, const_cast<uint8_t*>(data), size);
-
-		if (jpeg_read_header(_decompress, (bool) TRUE) != JPEG_HEADER_OK)
+		// nothing to do while the TV is off
+		if (_cecDetectionEnabled && _cecStandbyActivated)
 		{
-			jpeg_abort_decompress(_decompress);
-			jpeg_destroy_decompress(_decompress);
-			delete _decompress;
-			delete _error;
-			return;
+			if (frame.pinnedBuffer >= 0 && !requeueBuffer(frame.pinnedBuffer))
+				QMetaObject::invokeMethod(this, "dequeueFailed", Qt::QueuedConnection);
+			continue;
 		}
 
-		_decompress->scale_num = 1;
-		_decompress->scale_denom = 1;
-		_decompress->out_color_space = JCS_RGB;
-		_decompress->dct_method = JDCT_IFAST;
+		const uint8_t* data = (frame.pinnedBuffer >= 0)
+				? static_cast<const uint8_t*>(_buffers[frame.pinnedBuffer].start)
+				: frame.data.data();
+
+		// sized and written by the decoder or the resampler
+		Image<ColorRgb> image;
+		const bool decoded = decodeFrame(worker, data, frame.size, image);
 
-		if (!jpeg_start_decompress(_decompress))
+		if (frame.pinnedBuffer >= 0 && !requeueBuffer(frame.pinnedBuffer))
 		{
-			jpeg_abort_decompress(_decompress);
-			jpeg_destroy_decompress(_decompress);
-			delete _decompress;
-			delete _error;
-			return;
+			QMetaObject::invokeMethod(this, "dequeueFailed", Qt::QueuedConnection);
 		}
 
-		if (_decompress->out_color_components != 3)
+		if (decoded)
 		{
-			jpeg_abort_decompress(_decompress);
-			jpeg_destroy_decompress(_decompress);
-			delete _decompress;
-			delete _error;
-			return;
+			image.setCaptureTime(frame.captureTime);
+			handOff(frame.sequence, image);
 		}
-
-		QImage imageFrame = QImage(_decompress->output_width, _decompress->output_height, QImage::Format_RGB888);
-
-		int y = 0;
-		while (_decompress->output_scanline < _decompress->output_height)
+		else
 		{
-			uchar *row = imageFrame.scanLine(_decompress->output_scanline);
-			jpeg_read_scanlines(_decompress, &row, 1);
-			y++;
+			++_pipelineStats.decodeFailed;
 		}
+	}
+}
 
-		jpeg_finish_decompress(_decompress);
-		jpeg_destroy_decompress(_decompress);
-		delete _decompress;
-		delete _error;
+bool V4L2Grabber::decodeFrame(DecodeWorker* worker, const uint8_t * data, int size, Image<ColorRgb> & image)
+{
+	TRACE_SCOPE("v4l2.process");
 
-		if (imageFrame.isNull() || _error->pub.num_warnings > 0)
-			return;
+	// a snapshot of the settings, they may change while the frame is decoded
+	ImageResampler resampler;
+	int decimation, cropLeft, cropRight, cropTop, cropBottom;
+	{
+		std::lock_guard<std::mutex> lock(_decodeSettingsMutex);
+		resampler = _imageResampler;
+		decimation = _pixelDecimation;
+		cropLeft = _cropLeft;
+		cropRight = _cropRight;
+		cropTop = _cropTop;
+		cropBottom = _cropBottom;
+	}
+
+#ifdef HAVE_JPEG_DECODER
+	if (_pixelFormat == PixelFormat::MJPEG)
+	{
+		return worker->decoder.decode(data, size, decimation, cropLeft, cropRight, cropTop, cropBottom, image);
+	}
 #endif
-#ifdef HAVE_TURBO_JPEG
-		_decompress = tjInitDecompress();
-		if (_decompress == nullptr)
-			return;
 
-		if (tjDecompressHeader2(_decompress, const_cast<uint8_t*>(data), size, &_width, &_height, &_subsamp) != 0)
+	resampler.processImage(data, _width, _height, _lineLength, _pixelFormat, image);
+	return true;
+}
+
+void V4L2Grabber::handOff(uint64_t sequence, const Image<ColorRgb> & image)
+{
+	// an MJPEG frame is a view of the decoder's buffer, the copy owns its pixels
+	Image<ColorRgb> frame(image);
+
+	bool deliver = false;
+	{
+		std::lock_guard<std::mutex> lock(_handoffMutex);
+		if (sequence < _handoffSequence)
 		{
-			tjDestroy(_decompress);
+			// another worker was faster with a newer frame
+			++_pipelineStats.reorderDropped;
 			return;
 		}
 
-		QImage imageFrame = QImage(_width, _height, QImage::Format_RGB888);
-		if (tjDecompress2(_decompress, const_cast<uint8_t*>(data), size, imageFrame.bits(), _width, 0, _height, TJPF_RGB, TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
+		if (_handoffPending)
 		{
-			tjDestroy(_decompress);
-			return;
+			// the grabber's thread did not take the previous frame yet, it gets the newer one instead
+			++_pipelineStats.handoffDropped;
 		}
 
-		tjDestroy(_decompress);
+		_handoffSequence = sequence;
+		_handoffImage.swap(frame);
+		deliver = !_handoffPending;
+		_handoffPending = true;
+	}
 
-		if (imageFrame.isNull())
-			return;
-#endif
-#ifdef HAVE_JPEG_DECODER
-		QRect rect(_cropLeft, _cropTop, imageFrame.width() - _cropLeft - _cropRight, imageFrame.height() - _cropTop - _cropBottom);
-		imageFrame = imageFrame.copy(rect);
-		imageFrame = imageFrame.scaled(imageFrame.width() / _pixelDecimation, imageFrame.height() / _pixelDecimation,Qt::KeepAspectRatio);
+	if (deliver)
+	{
+		QMetaObject::invokeMethod(this, "deliverFrame", Qt::QueuedConnection);
+	}
+}
 
-		if ((image.width() != unsigned(imageFrame.width())) || (image.height() != unsigned(imageFrame.height())))
-			image.resize(imageFrame.width(), imageFrame.height());
+void V4L2Grabber::deliverFrame()
+{
+	Image<ColorRgb> image;
+	{
+		std::lock_guard<std::mutex> lock(_handoffMutex);
+		if (!_handoffPending)
+			return;
 
-		for (int y=0; y<imageFrame.height(); ++y)
-			for (int x=0; x<imageFrame.width(); ++x)
-			{
-				QColor inPixel(imageFrame.pixel(x,y));
-				ColorRgb & outPixel = image(x,y);
-				outPixel.red   = inPixel.red();
-				outPixel.green = inPixel.green();
-				outPixel.blue  = inPixel.blue();
-			}
+		image.swap(_handoffImage);
+		_handoffPending = false;
 	}
-	else
-#endif
 
-/* ----------------------------------------------------------
- * ------------ END of JPEG decoder related code ------------
- * --------------------------------------------------------*/
-
-	_imageResampler.processImage(data, _width, _height, _lineLength, _pixelFormat, image);
+	++_pipelineStats.delivered;
 
 	if (_signalDetectionEnabled)
 	{
+		updateSignalDetectionDemand(image.width(), image.height());
+
 		// check signal (only in center of the resulting image, because some grabbers have noise values along the borders)
 		bool noSignal = true;
 
@@ -1220,6 +1435,30 @@ void V4L2Grabber::process_image(const uint8_t * data, int size)
 	}
 }
 
+void V4L2Grabber::updateSignalDetectionDemand(unsigned width, unsigned height)
+{
+	if (width == _signalDemandWidth && height == _signalDemandHeight)
+	{
+		return;
+	}
+
+	_signalDemandWidth = width;
+	_signalDemandHeight = height;
+
+	// same area as checked in deliverFrame
+	const unsigned xOffset = width  * _x_frac_min;
+	const unsigned yOffset = height * _y_frac_min;
+	const unsigned xMax    = width  * _x_frac_max;
+	const unsigned yMax    = height * _y_frac_max;
+
+	std::vector<SampleDemand::Span> spans;
+	for (unsigned y = yOffset; y < yMax; ++y)
+	{
+		spans.push_back({y, xOffset, xMax});
+	}
+	SampleDemand::getInstance()->setSupplementaryDemand(this, width, height, spans);
+}
+
 int V4L2Grabber::xioctl(int request, void *arg)
 {
 	int r;
@@ -1292,6 +1531,12 @@ void V4L2Grabber::setSignalDetectionEnable(bool enable)
 	if (_signalDetectionEnabled != enable)
 	{
 		_signalDetectionEnabled = enable;
+		if (!enable)
+		{
+			SampleDemand::getInstance()->removeConsumer(this);
+			_signalDemandWidth = 0;
+			_signalDemandHeight = 0;
+		}
 		Info(_log, "Signal detection is now %s", enable ? "enabled" : "disabled");
 	}
 }
@@ -1309,12 +1554,25 @@ void V4L2Grabber::setPixelDecimation(int pixelDecimation)
 {
 	if (_pixelDecimation != pixelDecimation)
 	{
+		std::lock_guard<std::mutex> lock(_decodeSettingsMutex);
 		_pixelDecimation = pixelDecimation;
 		_imageResampler.setHorizontalPixelDecimation(pixelDecimation);
 		_imageResampler.setVerticalPixelDecimation(pixelDecimation);
 	}
 }
 
+void V4L2Grabber::setVideoMode(VideoMode mode)
+{
+	std::lock_guard<std::mutex> lock(_decodeSettingsMutex);
+	Grabber::setVideoMode(mode);
+}
+
+void V4L2Grabber::setCropping(unsigned cropLeft, unsigned cropRight, unsigned cropTop, unsigned cropBottom)
+{
+	std::lock_guard<std::mutex> lock(_decodeSettingsMutex);
+	Grabber::setCropping(cropLeft, cropRight, cropTop, cropBottom);
+}
+
 void V4L2Grabber::setDeviceVideoStandard(QString device, VideoStandard videoStandard)
 {
 	if (_deviceName != device || _videoStandard != videoStandard)
@@ -1398,6 +1656,41 @@ QStringList V4L2Grabber::getFramerates(const QString& devicePath) const
 	return _deviceProperties.value(devicePath).framerates;
 }
 
+QJsonObject V4L2Grabber::getV4L2pipelineStats() const
+{
+	QJsonObject dequeue;
+	dequeue["frames"] = static_cast<qint64>(_pipelineStats.captured);
+	dequeue["copied"] = static_cast<qint64>(_pipelineStats.copied);
+	dequeue["pinned"] = static_cast<qint64>(_pipelineStats.pinned);
+	dequeue["driverQueued"] = _queuedBuffers.load();
+
+	QJsonObject decode;
+	{
+		std::lock_guard<std::mutex> lock(_pendingMutex);
+		decode["workers"] = _pipelineQuit ? 0 : static_cast<int>(_pendingCapacity);
+		decode["queueDepth"] = static_cast<int>(_pendingFrames.size());
+		decode["queueCapacity"] = static_cast<int>(_pendingCapacity);
+	}
+	decode["dropped"] = static_cast<qint64>(_pipelineStats.queueDropped);
+	decode["failed"] = static_cast<qint64>(_pipelineStats.decodeFailed);
+
+	QJsonObject handoff;
+	{
+		std::lock_guard<std::mutex> lock(_handoffMutex);
+		handoff["queueDepth"] = _handoffPending ? 1 : 0;
+	}
+	handoff["dropped"] = static_cast<qint64>(_pipelineStats.handoffDropped);
+	handoff["reordered"] = static_cast<qint64>(_pipelineStats.reorderDropped);
+	handoff["delivered"] = static_cast<qint64>(_pipelineStats.delivered);
+
+	QJsonObject stats;
+	stats["running"] = !_pipelineQuit;
+	stats["dequeue"] = dequeue;
+	stats["decode"] = decode;
+	stats["handoff"] = handoff;
+	return stats;
+}
+
 void V4L2Grabber::handleCecEvent(CECEvent event)
 {
 	switch (event)
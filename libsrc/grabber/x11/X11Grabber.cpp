@@ -4,6 +4,10 @@
 #include <xcb/randr.h>
 #include <xcb/xcb_event.h>
 
+#ifdef HAVE_XDAMAGE
+#include <X11/extensions/Xdamage.h>
+#endif
+
 X11Grabber::X11Grabber(int cropLeft, int cropRight, int cropTop, int cropBottom, int pixelDecimation)
 	: Grabber("X11GRABBER", 0, 0, cropLeft, cropRight, cropTop, cropBottom)
 	, _x11Display(nullptr)
@@ -18,6 +22,8 @@ X11Grabber::X11Grabber(int cropLeft, int cropRight, int cropTop, int cropBottom,
 	, _src_x(cropLeft)
 	, _src_y(cropTop)
 	, _image(0,0)
+	, _damage(None)
+	, _XDamageEventBase(0)
 {
 	_useImageResampler = false;
 	_imageResampler.setCropping(0, 0, 0, 0); // cropping is performed by XRender, XShmGetImage or XGetImage
@@ -30,6 +36,12 @@ X11Grabber::~X11Grabber()
 	if (_x11Display != nullptr)
 	{
 		freeResources();
+#ifdef HAVE_XDAMAGE
+		if (_damage != None)
+		{
+			XDamageDestroy(_x11Display, _damage);
+		}
+#endif
 		XCloseDisplay(_x11Display);
 	}
 }
@@ -129,6 +141,18 @@ bool X11Grabber::Setup()
 	_XShmAvailable = XShmQueryExtension(_x11Display);
 	XShmQueryVersion(_x11Display, &dummy, &dummy, &pixmaps_supported);
 	_XShmPixmapAvailable = pixmaps_supported && XShmPixmapFormat(_x11Display) == ZPixmap;
+#ifdef HAVE_XDAMAGE
+	_XDamageAvailable = XDamageQueryExtension(_x11Display, &_XDamageEventBase, &dummy);
+
+	// the server reports the first change of the screen after each reset of the damage
+	if (_XDamageAvailable)
+	{
+		_damage = XDamageCreate(_x11Display, _window, XDamageReportNonEmpty);
+	}
+#else
+	_XDamageAvailable = false;
+#endif
+	Info(_log, "XDamage is %s, the screen is grabbed %s", _XDamageAvailable ? "available" : "unavailable", _XDamageAvailable ? "after changes" : "periodically");
 
 	bool result = (updateScreenDimensions(true) >=0);
 	ErrorIf(!result, _log, "X11 Grabber start failed");
@@ -143,6 +167,9 @@ int X11Grabber::grabFrame(Image<ColorRgb> & image, bool forceUpdate)
 	if (forceUpdate)
 		updateScreenDimensions(forceUpdate);
 
+	if (!takeDamage(forceUpdate))
+		return 1;
+
 	if (_XRenderAvailable)
 	{
 		double scale_x = static_cast<double>(_windowAttr.width / _pixelDecimation) / static_cast<double>(_windowAttr.width);
@@ -211,6 +238,33 @@ int X11Grabber::grabFrame(Image<ColorRgb> & image, bool forceUpdate)
 	return 0;
 }
 
+bool X11Grabber::takeDamage(bool force)
+{
+	if (!_XDamageAvailable)
+		return true;
+
+#ifdef HAVE_XDAMAGE
+	// the notifications arrive on the grabber's own connection
+	while (XPending(_x11Display) > 0)
+	{
+		XEvent event;
+		XNextEvent(_x11Display, &event);
+		if (event.type == _XDamageEventBase + XDamageNotify)
+		{
+			_screenChanged = true;
+		}
+	}
+
+	if (!screenGrabDue(force))
+		return false;
+
+	// reset before the grab, changes while grabbing are reported for the next frame
+	XDamageSubtract(_x11Display, _damage, None, None);
+	screenGrabbed();
+#endif
+	return true;
+}
+
 int X11Grabber::updateScreenDimensions(bool force)
 {
 	const Status status = XGetWindowAttributes(_x11Display, _window, &_windowAttr);
@@ -292,6 +346,9 @@ int X11Grabber::updateScreenDimensions(bool force)
 	_image.resize(_width, _height);
 	setupResources();
 
+	// the new dimensions need a new frame
+	_screenChanged = true;
+
 	return 1;
 }
 
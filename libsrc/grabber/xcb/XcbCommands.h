@@ -1,5 +1,8 @@
 #pragma once
 
+#ifdef HAVE_XCB_DAMAGE
+#include <xcb/damage.h>
+#endif
 #include <xcb/randr.h>
 #include <xcb/shm.h>
 #include <xcb/xcb.h>
@@ -133,3 +136,28 @@ struct FreePixmap
 	static constexpr auto ReplyFunction = xcb_request_check;
 };
 
+#ifdef HAVE_XCB_DAMAGE
+struct DamageQueryVersion
+{
+	typedef xcb_damage_query_version_reply_t ResponseType;
+
+	static constexpr auto RequestFunction = xcb_damage_query_version;
+	static constexpr auto ReplyFunction = xcb_damage_query_version_reply;
+};
+
+struct DamageCreate
+{
+	typedef xcb_void_cookie_t ResponseType;
+
+	static constexpr auto RequestFunction = xcb_damage_create_checked;
+	static constexpr auto ReplyFunction = xcb_request_check;
+};
+
+struct DamageDestroy
+{
+	typedef xcb_void_cookie_t ResponseType;
+
+	static constexpr auto RequestFunction = xcb_damage_destroy_checked;
+	static constexpr auto ReplyFunction = xcb_request_check;
+};
+#endif
@@ -1,4 +1,6 @@
 #include <utils/Logger.h>
+#include <utils/LatencyTracker.h>
+#include <utils/Tracer.h>
 #include <grabber/XcbGrabber.h>
 
 #include "XcbCommands.h"
@@ -26,7 +28,11 @@ XcbGrabber::XcbGrabber(int cropLeft, int cropRight, int cropTop, int cropBottom,
 	, _srcPicture{}
 	, _dstPicture{}
 	, _transform{}
-	, _shminfo{}
+	, _shmBuffers{}
+	, _pendingBuffer{-1}
+	, _pendingCookie{}
+	, _pendingRequestTime{}
+	, _frameCaptureTime{}
 	, _pixelDecimation(pixelDecimation)
 	, _screenWidth{}
 	, _screenHeight{}
@@ -36,9 +42,11 @@ XcbGrabber::XcbGrabber(int cropLeft, int cropRight, int cropTop, int cropBottom,
 	, _XcbRandRAvailable{}
 	, _XcbShmAvailable{}
 	, _XcbShmPixmapAvailable{}
+	, _XcbDamageAvailable{}
 	, _logger{}
-	, _shmData{}
 	, _XcbRandREventBase{-1}
+	, _damage{}
+	, _XcbDamageEventBase{-1}
 {
 	_logger = Logger::getInstance("XCB");
 
@@ -52,6 +60,10 @@ XcbGrabber::~XcbGrabber()
 	if (_connection != nullptr)
 	{
 		freeResources();
+#ifdef HAVE_XCB_DAMAGE
+		if (_XcbDamageAvailable)
+			query<DamageDestroy>(_connection, _damage);
+#endif
 		xcb_disconnect(_connection);
 	}
 }
@@ -65,10 +77,23 @@ void XcbGrabber::freeResources()
 
 	if(_XcbShmAvailable)
 	{
-		query<ShmDetach>(_connection, _shminfo);
-		shmdt(_shmData);
-		shmctl(_shminfo, IPC_RMID, 0);
+		// the reply of a grab in flight refers to the old buffers
+		if (_pendingBuffer >= 0)
+		{
+			xcb_discard_reply(_connection, _pendingCookie.sequence);
+			_pendingBuffer = -1;
+		}
+
+		for (ShmBuffer & buffer : _shmBuffers)
+		{
+			if (buffer.data == nullptr)
+				continue;
 
+			query<ShmDetach>(_connection, buffer.segment);
+			shmdt(buffer.data);
+			shmctl(buffer.id, IPC_RMID, 0);
+			buffer = {};
+		}
 	}
 
 	if (_XcbRenderAvailable)
@@ -88,10 +113,13 @@ void XcbGrabber::setupResources()
 
 	if(_XcbShmAvailable)
 	{
-		_shminfo = xcb_generate_id(_connection);
-		int id = shmget(IPC_PRIVATE, size_t(_width) * size_t(_height) * 4, IPC_CREAT | 0777);
-		_shmData = static_cast<uint8_t*>(shmat(id, nullptr, 0));
-		query<ShmAttach>(_connection, _shminfo, id, 0);
+		for (ShmBuffer & buffer : _shmBuffers)
+		{
+			buffer.segment = xcb_generate_id(_connection);
+			buffer.id = shmget(IPC_PRIVATE, size_t(_width) * size_t(_height) * 4, IPC_CREAT | 0777);
+			buffer.data = static_cast<uint8_t*>(shmat(buffer.id, nullptr, 0));
+			query<ShmAttach>(_connection, buffer.segment, buffer.id, 0);
+		}
 	}
 
 	if (_XcbRenderAvailable)
@@ -100,18 +128,10 @@ void XcbGrabber::setupResources()
 		_imageResampler.setHorizontalPixelDecimation(1);
 		_imageResampler.setVerticalPixelDecimation(1);
 
-		if(_XcbShmPixmapAvailable)
-		{
-			_pixmap = xcb_generate_id(_connection);
-			query<ShmCreatePixmap>(
-				_connection, _pixmap, _screen->root, _width,
-				_height, _screen->root_depth, _shminfo, 0);
-		}
-		else
-		{
-			_pixmap = xcb_generate_id(_connection);
-			query<CreatePixmap>(_connection, _screen->root_depth, _pixmap, _screen->root, _width, _height);
-		}
+		// a shared memory pixmap would alias one of the grab buffers, the next composite would
+		// overwrite the frame in conversion
+		_pixmap = xcb_generate_id(_connection);
+		query<CreatePixmap>(_connection, _screen->root_depth, _pixmap, _screen->root, _width, _height);
 
 		_srcFormat = findFormatForVisual(_screen->root_visual);
 		_dstFormat = findFormatForVisual(_screen->root_visual);
@@ -127,6 +147,18 @@ void XcbGrabber::setupResources()
 
 		const std::string filter = "fast";
 		query<RenderSetPictureFilter>(_connection, _srcPicture, filter.size(), filter.c_str(), 0, nullptr);
+
+		double scale_x = static_cast<double>(_screenWidth / _pixelDecimation) / static_cast<double>(_screenWidth);
+		double scale_y = static_cast<double>(_screenHeight / _pixelDecimation) / static_cast<double>(_screenHeight);
+		double scale = qMin(scale_y, scale_x);
+
+		_transform = {
+			DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0),
+			DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0),
+			DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(scale)
+		};
+
+		query<RenderSetPictureTransform>(_connection, _srcPicture, _transform);
 	}
 	else
 	{
@@ -181,6 +213,31 @@ void XcbGrabber::setupShm()
 	}
 }
 
+void XcbGrabber::setupDamage()
+{
+#ifdef HAVE_XCB_DAMAGE
+	auto damageQueryExtensionReply = xcb_get_extension_data(_connection, &xcb_damage_id);
+	_XcbDamageAvailable = damageQueryExtensionReply != nullptr && damageQueryExtensionReply->present;
+	_XcbDamageEventBase = _XcbDamageAvailable ? damageQueryExtensionReply->first_event : -1;
+
+	// the version is negotiated before any other damage request
+	if (_XcbDamageAvailable)
+	{
+		auto damageQueryVersionReply = query<DamageQueryVersion>(_connection, XCB_DAMAGE_MAJOR_VERSION, XCB_DAMAGE_MINOR_VERSION);
+		_XcbDamageAvailable = damageQueryVersionReply != nullptr;
+	}
+
+	// the server reports the first change of the screen after each reset of the damage
+	if (_XcbDamageAvailable)
+	{
+		_damage = xcb_generate_id(_connection);
+		query<DamageCreate>(_connection, _damage, _screen->root, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+	}
+#else
+	_XcbDamageAvailable = false;
+#endif
+}
+
 bool XcbGrabber::Setup()
 {
 	int screen_num;
@@ -212,12 +269,14 @@ bool XcbGrabber::Setup()
 	setupRandr();
 	setupRender();
 	setupShm();
+	setupDamage();
 
-	Info(_log, QString("XcbRandR=[%1] XcbRender=[%2] XcbShm=[%3] XcbPixmap=[%4]")
+	Info(_log, QString("XcbRandR=[%1] XcbRender=[%2] XcbShm=[%3] XcbPixmap=[%4] XcbDamage=[%5]")
 		.arg(_XcbRandRAvailable     ? "available" : "unavailable")
 		.arg(_XcbRenderAvailable    ? "available" : "unavailable")
 		.arg(_XcbShmAvailable       ? "available" : "unavailable")
 		.arg(_XcbShmPixmapAvailable ? "available" : "unavailable")
+		.arg(_XcbDamageAvailable    ? "available" : "unavailable")
 		.toStdString().c_str());
 
 	bool result = (updateScreenDimensions(true) >= 0);
@@ -234,76 +293,151 @@ int XcbGrabber::grabFrame(Image<ColorRgb> & image, bool forceUpdate)
 	if (forceUpdate)
 		updateScreenDimensions(forceUpdate);
 
-	if (_XcbRenderAvailable)
-	{
-		double scale_x = static_cast<double>(_screenWidth / _pixelDecimation) / static_cast<double>(_screenWidth);
-		double scale_y = static_cast<double>(_screenHeight / _pixelDecimation) / static_cast<double>(_screenHeight);
-		double scale = qMin(scale_y, scale_x);
+	const bool changed = screenChanged(forceUpdate);
 
-		_transform = {
-			DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0),
-			DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0),
-			DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(scale)
-		};
-
-		query<RenderSetPictureTransform>(_connection, _srcPicture, _transform);
-		query<RenderComposite>(_connection,
-			XCB_RENDER_PICT_OP_SRC, _srcPicture,
-			XCB_RENDER_PICTURE_NONE, _dstPicture,
-			(_src_x/_pixelDecimation),
-			(_src_y/_pixelDecimation),
-			0, 0, 0, 0, _width, _height);
+	if (!_XcbShmAvailable)
+	{
+		if (!changed)
+			return 1;
 
-		xcb_flush(_connection);
+		resetDamage();
+		_frameCaptureTime = LatencyTracker::now();
 
-		if (_XcbShmAvailable)
+		if (_XcbRenderAvailable)
 		{
-			query<ShmGetImage>(_connection,
-				_pixmap, 0, 0, _width, _height,
-				~0, XCB_IMAGE_FORMAT_Z_PIXMAP, _shminfo, 0);
-
-			_imageResampler.processImage(
-				reinterpret_cast<const uint8_t *>(_shmData),
-				_width, _height, _width * 4, PixelFormat::BGR32, image);
+			xcb_render_composite(_connection,
+				XCB_RENDER_PICT_OP_SRC, _srcPicture,
+				XCB_RENDER_PICTURE_NONE, _dstPicture,
+				(_src_x/_pixelDecimation),
+				(_src_y/_pixelDecimation),
+				0, 0, 0, 0, _width, _height);
 		}
-		else
-		{
-			auto result = query<GetImage>(_connection,
+
+		auto result = _XcbRenderAvailable
+			? query<GetImage>(_connection,
 				XCB_IMAGE_FORMAT_Z_PIXMAP, _pixmap,
-				0, 0, _width, _height, ~0);
+				0, 0, _width, _height, ~0)
+			: query<GetImage>(_connection,
+				XCB_IMAGE_FORMAT_Z_PIXMAP, _screen->root,
+				_src_x, _src_y, _width, _height, ~0);
 
-			auto buffer = xcb_get_image_data(result.get());
+		if (result == nullptr)
+			return -1;
 
-			_imageResampler.processImage(
-				reinterpret_cast<const uint8_t *>(buffer),
-				_width, _height, _width * 4, PixelFormat::BGR32, image);
+		auto buffer = xcb_get_image_data(result.get());
+
+		_imageResampler.processImage(
+			reinterpret_cast<const uint8_t *>(buffer),
+			_width, _height, _width * 4, PixelFormat::BGR32, image);
+
+		return 0;
+	}
+
+	// the first grab after a pause has nothing in flight yet
+	if (_pendingBuffer < 0)
+	{
+		if (!changed)
+			return 1;
+
+		requestFrame(0);
+	}
+
+	const int buffer = _pendingBuffer;
+	const int64_t requestTime = _pendingRequestTime;
+
+	if (!collectFrame())
+		return -1;
+
+	// the server grabs the next frame while this one is converted, the pipeline drains once the
+	// screen stops changing
+	if (changed)
+		requestFrame(1 - buffer);
+
+	_imageResampler.processImage(
+		_shmBuffers[buffer].data,
+		_width, _height, _width * 4, PixelFormat::BGR32, image);
+
+	_frameCaptureTime = requestTime;
+	TRACE_COUNTER("xcb.grabLatency", LatencyTracker::now() - requestTime);
+
+	return 0;
+}
+
+bool XcbGrabber::screenChanged(bool force)
+{
+	// the notifications and the errors of unchecked requests arrive on the grabber's own connection
+	xcb_generic_event_t * event;
+	while ((event = xcb_poll_for_event(_connection)) != nullptr)
+	{
+		if (event->response_type == 0)
+		{
+			check_error(reinterpret_cast<xcb_generic_error_t *>(event));
+			continue;
 		}
 
+#ifdef HAVE_XCB_DAMAGE
+		if (_XcbDamageAvailable && XCB_EVENT_RESPONSE_TYPE(event) == _XcbDamageEventBase + XCB_DAMAGE_NOTIFY)
+			_screenChanged = true;
+#endif
+		free(event);
 	}
-	else if (_XcbShmAvailable)
+
+	return !_XcbDamageAvailable || screenGrabDue(force);
+}
+
+void XcbGrabber::resetDamage()
+{
+	// reset before the grab, changes while grabbing are reported for the next frame
+#ifdef HAVE_XCB_DAMAGE
+	if (_XcbDamageAvailable)
+		xcb_damage_subtract(_connection, _damage, XCB_NONE, XCB_NONE);
+#endif
+
+	screenGrabbed();
+}
+
+void XcbGrabber::requestFrame(int buffer)
+{
+	resetDamage();
+
+	// the requests are processed in order, the grab copies the result of the composite
+	if (_XcbRenderAvailable)
 	{
-		query<ShmGetImage>(_connection,
-			_screen->root, _src_x, _src_y, _width, _height,
-			~0, XCB_IMAGE_FORMAT_Z_PIXMAP, _shminfo, 0);
+		xcb_render_composite(_connection,
+			XCB_RENDER_PICT_OP_SRC, _srcPicture,
+			XCB_RENDER_PICTURE_NONE, _dstPicture,
+			(_src_x/_pixelDecimation),
+			(_src_y/_pixelDecimation),
+			0, 0, 0, 0, _width, _height);
 
-		_imageResampler.processImage(
-			reinterpret_cast<const uint8_t *>(_shmData),
-			_width, _height, _width * 4, PixelFormat::BGR32, image);
+		_pendingCookie = xcb_shm_get_image(_connection,
+			_pixmap, 0, 0, _width, _height,
+			~0, XCB_IMAGE_FORMAT_Z_PIXMAP, _shmBuffers[buffer].segment, 0);
 	}
 	else
 	{
-		auto result = query<GetImage>(_connection,
-			XCB_IMAGE_FORMAT_Z_PIXMAP, _screen->root,
-			_src_x, _src_y, _width, _height, ~0);
+		_pendingCookie = xcb_shm_get_image(_connection,
+			_screen->root, _src_x, _src_y, _width, _height,
+			~0, XCB_IMAGE_FORMAT_Z_PIXMAP, _shmBuffers[buffer].segment, 0);
+	}
 
-		auto buffer = xcb_get_image_data(result.get());
+	xcb_flush(_connection);
 
-		_imageResampler.processImage(
-			reinterpret_cast<const uint8_t *>(buffer),
-			_width, _height, _width * 4, PixelFormat::BGR32, image);
-	}
+	_pendingBuffer = buffer;
+	_pendingRequestTime = LatencyTracker::now();
+}
 
-	return 0;
+bool XcbGrabber::collectFrame()
+{
+	TRACE_SCOPE("xcb.wait");
+
+	xcb_generic_error_t * error = nullptr;
+	std::unique_ptr<xcb_shm_get_image_reply_t, decltype(&free)> reply(
+		xcb_shm_get_image_reply(_connection, _pendingCookie, &error), free);
+	_pendingBuffer = -1;
+
+	check_error(error);
+	return reply != nullptr;
 }
 
 int XcbGrabber::updateScreenDimensions(bool force)
@@ -385,6 +519,9 @@ int XcbGrabber::updateScreenDimensions(bool force)
 
 	setupResources();
 
+	// the new dimensions need a new frame
+	_screenChanged = true;
+
 	return 1;
 }
 
@@ -1,4 +1,5 @@
 #include <hyperion/Grabber.h>
+#include <utils/LatencyTracker.h>
 
 Grabber::Grabber(const QString& grabberName, int width, int height, int cropLeft, int cropRight, int cropTop, int cropBottom)
 	: _imageResampler()
@@ -13,6 +14,8 @@ Grabber::Grabber(const QString& grabberName, int width, int height, int cropLeft
 	, _cropTop(0)
 	, _cropBottom(0)
 	, _enabled(true)
+	, _screenChanged(true)
+	, _lastScreenGrabTime(0)
 	, _log(Logger::getInstance(grabberName.toUpper()))
 {
 	Grabber::setVideoMode(VideoMode::VIDEO_2D);
@@ -25,6 +28,17 @@ void Grabber::setEnabled(bool enable)
 	_enabled = enable;
 }
 
+bool Grabber::screenGrabDue(bool force) const
+{
+	return force || _screenChanged || LatencyTracker::now() - _lastScreenGrabTime >= KEEP_ALIVE_INTERVAL_US;
+}
+
+void Grabber::screenGrabbed()
+{
+	_screenChanged = false;
+	_lastScreenGrabTime = LatencyTracker::now();
+}
+
 void Grabber::setVideoMode(VideoMode mode)
 {
 	Debug(_log,"Set videomode to %d", mode);
@@ -249,3 +249,11 @@ QStringList GrabberWrapper::getFramerates(const QString& devicePath) const
 
 	return QStringList();
 }
+
+QJsonObject GrabberWrapper::getV4L2pipelineStats() const
+{
+	if(_grabberName.startsWith("V4L"))
+		return _ggrabber->getV4L2pipelineStats();
+
+	return QJsonObject();
+}
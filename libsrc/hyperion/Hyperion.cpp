@@ -6,6 +6,8 @@
 #include <QString>
 #include <QStringList>
 #include <QThread>
+#include <QMetaMethod>
+#include <QTimer>
 
 // hyperion include
 #include <hyperion/Hyperion.h>
@@ -16,7 +18,9 @@
 // utils
 #include <utils/hyperion.h>
 #include <utils/GlobalSignals.h>
+#include <utils/SampleDemand.h>
 #include <utils/Logger.h>
+#include <utils/Tracer.h>
 
 // LedDevice includes
 #include <leddevice/LedDeviceWrapper.h>
@@ -60,6 +64,13 @@ Hyperion::Hyperion(quint8 instance, bool readonlyMode)
 	, _ledBuffer(_ledString.leds().size(), ColorRgb::BLACK)
 	, _boblightServer(nullptr)
 	, _readOnlyMode(readonlyMode)
+	, _fullImageDemand(false)
+	, _updateTimer(nullptr)
+	, _latchTime_ms(0)
+	, _updateInterval_ms(0)
+	, _droppedFrames(0)
+	, _latency()
+	, _tracedCaptureTime(0)
 {
 
 }
@@ -67,6 +78,7 @@ Hyperion::Hyperion(quint8 instance, bool readonlyMode)
 Hyperion::~Hyperion()
 {
 	freeObjects();
+	SampleDemand::getInstance()->removeConsumer(this);
 }
 
 void Hyperion::start()
@@ -85,11 +97,8 @@ void Hyperion::start()
 	// handle hwLedCount
 	_hwLedCount = qMax(getSetting(settings::DEVICE).object()["hardwareLedCount"].toInt(getLedCount()), getLedCount());
 
-	// Initialize colororder vector
-	for (const Led& led : _ledString.leds())
-	{
-		_ledStringColorOrder.push_back(led.colorOrder);
-	}
+	// Initialize colororder runs
+	_colorOrderRuns = _ledString.colorOrderRuns();
 
 	// connect Hyperion::update with Muxer visible priority changes as muxer updates independent
 	connect(&_muxer, &PriorityMuxer::visiblePriorityChanged, this, &Hyperion::update);
@@ -114,8 +123,15 @@ void Hyperion::start()
 	_ledDeviceWrapper = new LedDeviceWrapper(this);
 	connect(this, &Hyperion::compStateChangeRequest, _ledDeviceWrapper, &LedDeviceWrapper::handleComponentState);
 	connect(this, &Hyperion::ledDeviceData, _ledDeviceWrapper, &LedDeviceWrapper::updateLeds);
+	connect(_ledDeviceWrapper, &LedDeviceWrapper::latchTimeChanged, this, [=](int latchTime_ms) { _latchTime_ms = latchTime_ms; });
 	_ledDeviceWrapper->createLedDevice(ledDevice);
 
+	// coalesces input arriving faster than the device takes it
+	_updateTimer = new QTimer(this);
+	_updateTimer->setSingleShot(true);
+	_updateTimer->setTimerType(Qt::PreciseTimer);
+	connect(_updateTimer, &QTimer::timeout, this, &Hyperion::update);
+
 	// smoothing
 	_deviceSmooth = new LinearColorSmoothing(getSetting(settings::SMOOTHING), this);
 	connect(this, &Hyperion::settingsChanged, _deviceSmooth, &LinearColorSmoothing::handleSettingsUpdate);
@@ -174,6 +190,8 @@ void Hyperion::freeObjects()
 	delete _raw2ledAdjustment;
 	delete _messageForwarder;
 	delete _settingsManager;
+	// the smoothing output clock may still write to the device
+	delete _deviceSmooth;
 	delete _ledDeviceWrapper;
 }
 
@@ -210,11 +228,7 @@ void Hyperion::handleSettingsUpdate(settings::type type, const QJsonDocument& co
 		std::vector<ColorRgb> color(_ledString.leds().size(), ColorRgb{0,0,0});
 		_ledBuffer = color;
 
-		_ledStringColorOrder.clear();
-		for (const Led& led : _ledString.leds())
-		{
-			_ledStringColorOrder.push_back(led.colorOrder);
-		}
+		_colorOrderRuns = _ledString.colorOrderRuns();
 
 		// handle hwLedCount update
 		_hwLedCount = qMax(getSetting(settings::DEVICE).object()["hardwareLedCount"].toInt(getLedCount()), getLedCount());
@@ -239,11 +253,7 @@ void Hyperion::handleSettingsUpdate(settings::type type, const QJsonDocument& co
 			_ledString = hyperion::createLedString(getSetting(settings::LEDS).array(), hyperion::createColorOrder(dev));
 			_imageProcessor->setLedString(_ledString);
 
-			_ledStringColorOrder.clear();
-			for (const Led& led : _ledString.leds())
-			{
-				_ledStringColorOrder.push_back(led.colorOrder);
-			}
+			_colorOrderRuns = _ledString.colorOrderRuns();
 		}
 
 		// do always reinit until the led devices can handle dynamic changes
@@ -276,6 +286,23 @@ int Hyperion::getLatchTime() const
 	return _ledDeviceWrapper->getLatchTime();
 }
 
+void Hyperion::publishLedDeviceData(const std::vector<ColorRgb>& ledValues)
+{
+	_ledDeviceWrapper->publishLeds(ledValues);
+}
+
+QJsonObject Hyperion::getSmoothingStatistics() const
+{
+	return _deviceSmooth->getStatistics();
+}
+
+QJsonObject Hyperion::getIdleStatistics() const
+{
+	QJsonObject idle = _deviceSmooth->getIdleStatistics();
+	idle["deviceIdleTime"] = static_cast<double>(_ledDeviceWrapper->getIdleTime());
+	return idle;
+}
+
 unsigned Hyperion::addSmoothingConfig(int settlingTime_ms, double ledUpdateFrequency_hz, unsigned updateDelay)
 {
 	return _deviceSmooth->addConfig(settlingTime_ms, ledUpdateFrequency_hz, updateDelay);
@@ -336,10 +363,10 @@ bool Hyperion::setInput(int priority, const std::vector<ColorRgb>& ledColors, in
 			_effectEngine->channelCleared(priority);
 		}
 
-		// if this priority is visible, update immediately
+		// if this priority is visible, update as soon as the device takes new data
 		if(priority == _muxer.getCurrentPriority())
 		{
-			update();
+			scheduleUpdate();
 		}
 
 		return true;
@@ -363,10 +390,10 @@ bool Hyperion::setInputImage(int priority, const Image<ColorRgb>& image, int64_t
 			_effectEngine->channelCleared(priority);
 		}
 
-		// if this priority is visible, update immediately
+		// if this priority is visible, update as soon as the device takes new data
 		if(priority == _muxer.getCurrentPriority())
 		{
-			update();
+			scheduleUpdate();
 		}
 
 		return true;
@@ -403,7 +430,7 @@ void Hyperion::setColor(int priority, const std::vector<ColorRgb> &ledColors, in
 	}
 end:
 
-	if (getPriorityInfo(priority).componentId != hyperion::COMP_COLOR)
+	if (_muxer.getSnapshot()->getInputInfo(priority).componentId != hyperion::COMP_COLOR)
 	{
 		clear(priority);
 	}
@@ -427,6 +454,7 @@ ColorAdjustment * Hyperion::getAdjustment(const QString& id) const
 
 void Hyperion::adjustmentsUpdated()
 {
+	_raw2ledAdjustment->updateAdjustments();
 	emit adjustmentChanged();
 	update();
 }
@@ -468,12 +496,17 @@ bool Hyperion::isCurrentPriority(int priority) const
 
 QList<int> Hyperion::getActivePriorities() const
 {
-	return _muxer.getPriorities();
+	return _muxer.getSnapshot()->getPriorities();
 }
 
 Hyperion::InputInfo Hyperion::getPriorityInfo(int priority) const
 {
-	return _muxer.getInputInfo(priority);
+	return _muxer.getSnapshot()->getInputInfo(priority);
+}
+
+PriorityMuxer::SnapshotPtr Hyperion::getPrioritySnapshot() const
+{
+	return _muxer.getSnapshot();
 }
 
 QString Hyperion::saveEffect(const QJsonObject& obj)
@@ -572,59 +605,125 @@ void Hyperion::handlePriorityChangedLedDevice(const quint8& priority)
 	}
 }
 
-void Hyperion::update()
+void Hyperion::connectNotify(const QMetaMethod& signal)
 {
-	// Obtain the current priority channel
-	int priority = _muxer.getCurrentPriority();
-	const PriorityMuxer::InputInfo priorityInfo = _muxer.getInputInfo(priority);
+	if (signal == QMetaMethod::fromSignal(&Hyperion::currentImage)
+		|| signal == QMetaMethod::fromSignal(&Hyperion::forwardSystemProtoMessage)
+		|| signal == QMetaMethod::fromSignal(&Hyperion::forwardV4lProtoMessage))
+	{
+		updateImageDemand();
+	}
+}
 
-	// copy image & process OR copy ledColors from muxer
-	Image<ColorRgb> image = priorityInfo.image;
-	if(image.size() > 3)
+void Hyperion::disconnectNotify(const QMetaMethod& signal)
+{
+	// a disconnect of all signals passes an invalid method
+	if (!signal.isValid()
+		|| signal == QMetaMethod::fromSignal(&Hyperion::currentImage)
+		|| signal == QMetaMethod::fromSignal(&Hyperion::forwardSystemProtoMessage)
+		|| signal == QMetaMethod::fromSignal(&Hyperion::forwardV4lProtoMessage))
+	{
+		updateImageDemand();
+	}
+}
+
+bool Hyperion::updateImageDemand()
+{
+	const bool streamed = isSignalConnected(QMetaMethod::fromSignal(&Hyperion::currentImage));
+	const bool full = streamed
+			|| isSignalConnected(QMetaMethod::fromSignal(&Hyperion::forwardSystemProtoMessage))
+			|| isSignalConnected(QMetaMethod::fromSignal(&Hyperion::forwardV4lProtoMessage));
+
+	if (_fullImageDemand.exchange(full) != full)
+	{
+		if (full)
+		{
+			SampleDemand::getInstance()->setFullDemand(this);
+		}
+		else
+		{
+			SampleDemand::getInstance()->removeConsumer(this);
+		}
+	}
+	return streamed;
+}
+
+void Hyperion::scheduleUpdate()
+{
+	// the pending update will process the latest input of the muxer, the superseded one is never mapped
+	if (_updateTimer->isActive())
 	{
-		emit currentImage(image);
-		_ledBuffer = _imageProcessor->process(image);
+		++_droppedFrames;
+		return;
+	}
+
+	// writes within the latch time are skipped by the device, smoothing takes only the latest values per interval
+	int interval = _latchTime_ms;
+	if (_deviceSmooth->enabled())
+	{
+		interval = qMax(interval, _deviceSmooth->getUpdateInterval());
+	}
+	_updateInterval_ms = interval;
+
+	const qint64 elapsed = _lastUpdate.isValid() ? _lastUpdate.elapsed() : interval;
+	if (elapsed >= interval)
+	{
+		update();
 	}
 	else
 	{
-		_ledBuffer = priorityInfo.ledColors;
+		_updateTimer->start(static_cast<int>(interval - elapsed));
 	}
+}
 
-	// emit rawLedColors before transform
-	emit rawLedColors(_ledBuffer);
+void Hyperion::update()
+{
+	TRACE_SCOPE("hyperion.update");
+
+	// this update processes the latest input, a deferred one is obsolete
+	if (_updateTimer != nullptr)
+	{
+		_updateTimer->stop();
+	}
+	_lastUpdate.start();
 
-	_raw2ledAdjustment->applyAdjustment(_ledBuffer);
+	// Obtain the current priority channel, the snapshot keeps it valid without a copy
+	const PriorityMuxer::SnapshotPtr snapshot = _muxer.getSnapshot();
+	const PriorityMuxer::InputInfo& priorityInfo = snapshot->getInputInfo(snapshot->currentPriority);
+	TRACE_COUNTER("hyperion.priority", snapshot->currentPriority);
 
-	int i = 0;
-	for (ColorRgb& color : _ledBuffer)
+	// trace each input frame once, not again when it is updated for another reason (e.g. an adjustment change)
+	const int64_t captureTime = (priorityInfo.captureTime != _tracedCaptureTime) ? priorityInfo.captureTime : 0;
+	_tracedCaptureTime = priorityInfo.captureTime;
+	_latency.record(LatencyTracker::MUXER, captureTime);
+
+	// process image OR copy ledColors from muxer
+	const Image<ColorRgb>& image = priorityInfo.image;
+	if(image.size() > 3)
 	{
-		// correct the color byte order
-		switch (_ledStringColorOrder.at(i))
+		// the preview is only produced for subscribers of the image stream
+		if (updateImageDemand())
 		{
-		case ColorOrder::ORDER_RGB:
-			// leave as it is
-			break;
-		case ColorOrder::ORDER_BGR:
-			std::swap(color.red, color.blue);
-			break;
-		case ColorOrder::ORDER_RBG:
-			std::swap(color.green, color.blue);
-			break;
-		case ColorOrder::ORDER_GRB:
-			std::swap(color.red, color.green);
-			break;
-		case ColorOrder::ORDER_GBR:
-			std::swap(color.red, color.green);
-			std::swap(color.green, color.blue);
-			break;
-
-		case ColorOrder::ORDER_BRG:
-			std::swap(color.red, color.blue);
-			std::swap(color.green, color.blue);
-			break;
+			emit currentImage(image);
 		}
-		i++;
+		// map into the led buffer of the last frame, avoids an allocation per frame
+		_ledBuffer.resize(_ledString.leds().size());
+		// frames of the system and USB grabbers are broadcast to all instances, share their analysis
+		const bool sharedFrame = priorityInfo.componentId == hyperion::COMP_GRABBER || priorityInfo.componentId == hyperion::COMP_V4L;
+		_imageProcessor->process(image, _ledBuffer, sharedFrame);
+		_latency.record(LatencyTracker::PROCESS, captureTime);
 	}
+	else
+	{
+		_ledBuffer = priorityInfo.ledColors;
+	}
+
+	// emit rawLedColors before transform
+	emit rawLedColors(_ledBuffer);
+
+	// adjust the colors and correct the color byte order in one pass
+	_raw2ledAdjustment->applyAdjustment(_ledBuffer, _colorOrderRuns);
+	_latency.record(LatencyTracker::ADJUSTMENT, captureTime);
 
 	// fill additional hardware LEDs with black
 	if ( _hwLedCount > static_cast<int>(_ledBuffer.size()) )
@@ -639,6 +738,10 @@ void Hyperion::update()
 		if  (! _deviceSmooth->enabled())
 		{
 			//std::cout << "Hyperion::update()> Non-Smoothing - "; LedDevice::printLedValues ( _ledBuffer);
+			if (captureTime != 0)
+			{
+				_latency.handOver(LatencyTracker::DEVICE, captureTime);
+			}
 			emit ledDeviceData(_ledBuffer);
 		}
 		else
@@ -648,6 +751,10 @@ void Hyperion::update()
 			// feed smoothing in pause mode to maintain a smooth transition back to smooth mode
 			if (_deviceSmooth->enabled() || _deviceSmooth->pause())
 			{
+				if (captureTime != 0)
+				{
+					_latency.handOver(LatencyTracker::SMOOTHING, captureTime);
+				}
 				_deviceSmooth->updateLedValues(_ledBuffer);
 			}
 		}
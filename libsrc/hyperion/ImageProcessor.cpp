@@ -7,6 +7,9 @@
 // Blacborder includes
 #include <blackborder/BlackBorderProcessor.h>
 
+// Utils includes
+#include <utils/SampleDemand.h>
+
 using namespace hyperion;
 
 // global transform method
@@ -14,6 +17,8 @@ int ImageProcessor::mappingTypeToInt(const QString& mappingType)
 {
 	if (mappingType == "unicolor_mean" )
 		return 1;
+	if (mappingType == "multicolor_mean_integral" )
+		return 2;
 
 	return 0;
 }
@@ -22,6 +27,8 @@ QString ImageProcessor::mappingTypeToStr(int mappingType)
 {
 	if (mappingType == 1 )
 		return "unicolor_mean";
+	if (mappingType == 2 )
+		return "multicolor_mean_integral";
 
 	return "multicolor_mean";
 }
@@ -32,10 +39,18 @@ ImageProcessor::ImageProcessor(const LedString& ledString, Hyperion* hyperion)
 	, _ledString(ledString)
 	, _borderProcessor(new BlackBorderProcessor(hyperion, this))
 	, _imageToLeds(nullptr)
+	, _nextImageToLeds(nullptr)
+	, _mapCache()
+	, _integralImage()
 	, _mappingType(0)
 	, _userMappingType(0)
 	, _hardMappingType(0)
 	, _hyperion(hyperion)
+	, _demandMapping(nullptr)
+	, _demandMappingType(-1)
+	, _demandBorderDetection(false)
+	, _demandOutdated(true)
+	, _demandGeneration(0)
 {
 	// init
 	handleSettingsUpdate(settings::COLOR, _hyperion->getSetting(settings::COLOR));
@@ -45,7 +60,7 @@ ImageProcessor::ImageProcessor(const LedString& ledString, Hyperion* hyperion)
 
 ImageProcessor::~ImageProcessor()
 {
-	delete _imageToLeds;
+	SampleDemand::getInstance()->removeConsumer(this);
 }
 
 void ImageProcessor::handleSettingsUpdate(settings::type type, const QJsonDocument& config)
@@ -59,6 +74,11 @@ void ImageProcessor::handleSettingsUpdate(settings::type type, const QJsonDocume
 			setLedMappingType(newType);
 		}
 	}
+	else if(type == settings::BLACKBORDER)
+	{
+		// the detection mode may have changed
+		_demandOutdated = true;
+	}
 }
 
 void ImageProcessor::setSize(unsigned width, unsigned height)
@@ -69,11 +89,9 @@ void ImageProcessor::setSize(unsigned width, unsigned height)
 		return;
 	}
 
-	// Clean up the old buffer and mapping
-	delete _imageToLeds;
-
-	// Construct a new buffer and mapping
-	_imageToLeds = (width>0 && height>0) ? (new ImageToLedsMap(width, height, 0, 0, _ledString.leds())) : nullptr;
+	// Take the mapping from the cache or construct a new one
+	_imageToLeds = (width>0 && height>0) ? _mapCache.get(width, height, 0, 0, _ledString.leds()) : nullptr;
+	_nextImageToLeds.reset();
 }
 
 void ImageProcessor::setLedString(const LedString& ledString)
@@ -86,12 +104,91 @@ void ImageProcessor::setLedString(const LedString& ledString)
 		unsigned width = _imageToLeds->width();
 		unsigned height = _imageToLeds->height();
 
-		// Clean up the old buffer and mapping
-		delete _imageToLeds;
+		// Take the mapping from the cache or construct a new one
+		_imageToLeds = _mapCache.get(width, height, 0, 0, _ledString.leds());
+		_nextImageToLeds.reset();
+	}
+}
+
+void ImageProcessor::changeMapping(std::shared_ptr<const hyperion::ImageToLedsMap> imageToLeds)
+{
+	if (imageToLeds == _imageToLeds)
+	{
+		_nextImageToLeds.reset();
+		return;
+	}
+
+	if (SampleDemand::getInstance()->getMask(imageToLeds->width(), imageToLeds->height()) != nullptr)
+	{
+		_nextImageToLeds = std::move(imageToLeds);
+	}
+	else
+	{
+		_imageToLeds = std::move(imageToLeds);
+		_nextImageToLeds.reset();
+	}
+}
+
+void ImageProcessor::applyNextMapping(uint64_t sampleGeneration)
+{
+	// the image has to be converted with a mask including the demand of the new mapping
+	if (_nextImageToLeds && (sampleGeneration == 0 || sampleGeneration >= _demandGeneration))
+	{
+		_imageToLeds = std::move(_nextImageToLeds);
+		_nextImageToLeds.reset();
+	}
+}
+
+void ImageProcessor::updateSampleDemand()
+{
+	const std::shared_ptr<const ImageToLedsMap>& mapping = _nextImageToLeds ? _nextImageToLeds : _imageToLeds;
+	const bool borderDetection = _borderProcessor->enabled();
+
+	if (!_demandOutdated
+		&& _demandMapping == mapping
+		&& _demandMappingType == _mappingType
+		&& _demandBorderDetection == borderDetection)
+	{
+		return;
+	}
+
+	_demandMapping = mapping;
+	_demandMappingType = _mappingType;
+	_demandBorderDetection = borderDetection;
+	_demandOutdated = false;
+
+	if (mapping == nullptr)
+	{
+		SampleDemand::getInstance()->removeConsumer(this);
+		_demandGeneration = SampleDemand::getInstance()->generation();
+		return;
+	}
+
+	const unsigned width = mapping->width();
+	const unsigned height = mapping->height();
 
-		// Construct a new buffer and mapping
-		_imageToLeds = new ImageToLedsMap(width, height, 0, 0, _ledString.leds());
+	// unicolor and the summed-area table (requested or chosen as cheaper) read all pixels
+	if (_mappingType != 0 || mapping->preferIntegralImage())
+	{
+		SampleDemand::getInstance()->setFullDemand(this);
+		_demandGeneration = SampleDemand::getInstance()->generation();
+		return;
 	}
+
+	std::vector<SampleDemand::Span> spans;
+	spans.reserve(mapping->spans().size());
+	for (const LedSpan& span : mapping->spans())
+	{
+		spans.push_back({span.row, span.xBegin, span.xEnd});
+	}
+
+	if (borderDetection)
+	{
+		_borderProcessor->getProbeSpans(width, height, spans);
+	}
+
+	SampleDemand::getInstance()->setDemand(this, width, height, spans);
+	_demandGeneration = SampleDemand::getInstance()->generation();
 }
 
 void ImageProcessor::setBlackbarDetectDisable(bool enable)
@@ -1,7 +1,264 @@
 #include <hyperion/ImageToLedsMap.h>
 
+#include <utils/CpuFeatures.h>
+
+#if defined(HYPERION_SIMD_X86)
+	#include <emmintrin.h>
+	#include <immintrin.h>
+#elif defined(HYPERION_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
 using namespace hyperion;
 
+namespace {
+
+typedef void (*AccumulateFunc)(const ColorRgb* image, size_t stride, const LedSpan* spans, size_t spanCount, ColorSum& sum);
+
+inline void accumulateRun(const ColorRgb* pixel, const ColorRgb* end, uint64_t& red, uint64_t& green, uint64_t& blue)
+{
+	for (; pixel != end; ++pixel)
+	{
+		red   += pixel->red;
+		green += pixel->green;
+		blue  += pixel->blue;
+	}
+}
+
+void accumulateScalar(const ColorRgb* image, size_t stride, const LedSpan* spans, size_t spanCount, ColorSum& sum)
+{
+	uint64_t red = 0, green = 0, blue = 0;
+	for (const LedSpan* span = spans; span != spans + spanCount; ++span)
+	{
+		const ColorRgb* row = reinterpret_cast<const ColorRgb*>(reinterpret_cast<const uint8_t*>(image) + span->row * stride);
+		accumulateRun(row + span->xBegin, row + span->xEnd, red, green, blue);
+	}
+	sum.red   += red;
+	sum.green += green;
+	sum.blue  += blue;
+}
+
+#if defined(HYPERION_SIMD_X86)
+
+// Channel index of each byte of packed RGB data, the pattern repeats every 48 (SSE2) and 96 (AVX2) bytes
+alignas(32) const uint8_t CHANNEL_OF_BYTE[96] = {
+	0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,
+	2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,
+	1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2
+};
+
+// Sums 16 pixels (3 vectors) per iteration. Each byte is masked per channel and summed with
+// psadbw, which directly yields 64 bit partial sums, so the accumulators never overflow.
+HYPERION_TARGET_SSE2 void accumulateSse2(const ColorRgb* image, size_t stride, const LedSpan* spans, size_t spanCount, ColorSum& sum)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i mask[3][3];
+	for (int v = 0; v < 3; ++v)
+	{
+		const __m128i channels = _mm_load_si128(reinterpret_cast<const __m128i*>(CHANNEL_OF_BYTE + 16 * v));
+		for (int c = 0; c < 3; ++c)
+		{
+			mask[v][c] = _mm_cmpeq_epi8(channels, _mm_set1_epi8(static_cast<char>(c)));
+		}
+	}
+
+	__m128i acc[3] = { zero, zero, zero };
+	uint64_t red = 0, green = 0, blue = 0;
+	for (const LedSpan* span = spans; span != spans + spanCount; ++span)
+	{
+		const ColorRgb* pixel = reinterpret_cast<const ColorRgb*>(reinterpret_cast<const uint8_t*>(image) + span->row * stride) + span->xBegin;
+		const ColorRgb* end   = pixel + (span->xEnd - span->xBegin);
+
+		for (; end - pixel >= 16; pixel += 16)
+		{
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(pixel);
+			for (int v = 0; v < 3; ++v)
+			{
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * v));
+				for (int c = 0; c < 3; ++c)
+				{
+					acc[c] = _mm_add_epi64(acc[c], _mm_sad_epu8(_mm_and_si128(bytes, mask[v][c]), zero));
+				}
+			}
+		}
+		accumulateRun(pixel, end, red, green, blue);
+	}
+
+	alignas(16) uint64_t lanes[3][2];
+	for (int c = 0; c < 3; ++c)
+	{
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[c]), acc[c]);
+	}
+	sum.red   += red   + lanes[0][0] + lanes[0][1];
+	sum.green += green + lanes[1][0] + lanes[1][1];
+	sum.blue  += blue  + lanes[2][0] + lanes[2][1];
+}
+
+// Same scheme as the SSE2 kernel with 32 pixels (3 vectors of 32 bytes) per iteration and
+// a 16 pixel step for the remainder of each span
+HYPERION_TARGET_AVX2 void accumulateAvx2(const ColorRgb* image, size_t stride, const LedSpan* spans, size_t spanCount, ColorSum& sum)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i mask[3][3];
+	for (int v = 0; v < 3; ++v)
+	{
+		const __m256i channels = _mm256_load_si256(reinterpret_cast<const __m256i*>(CHANNEL_OF_BYTE + 32 * v));
+		for (int c = 0; c < 3; ++c)
+		{
+			mask[v][c] = _mm256_cmpeq_epi8(channels, _mm256_set1_epi8(static_cast<char>(c)));
+		}
+	}
+
+	// the first 48 bytes of the 96 byte pattern are the 16 pixel masks
+	__m128i mask16[3][3];
+	for (int v = 0; v < 3; ++v)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			mask16[v][c] = (v == 0) ? _mm256_castsi256_si128(mask[0][c])
+						 : (v == 1) ? _mm256_extracti128_si256(mask[0][c], 1)
+									: _mm256_castsi256_si128(mask[1][c]);
+		}
+	}
+
+	__m256i acc[3] = { zero, zero, zero };
+	__m128i acc16[3] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+	uint64_t red = 0, green = 0, blue = 0;
+	for (const LedSpan* span = spans; span != spans + spanCount; ++span)
+	{
+		const ColorRgb* pixel = reinterpret_cast<const ColorRgb*>(reinterpret_cast<const uint8_t*>(image) + span->row * stride) + span->xBegin;
+		const ColorRgb* end   = pixel + (span->xEnd - span->xBegin);
+
+		for (; end - pixel >= 32; pixel += 32)
+		{
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(pixel);
+			for (int v = 0; v < 3; ++v)
+			{
+				const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32 * v));
+				for (int c = 0; c < 3; ++c)
+				{
+					acc[c] = _mm256_add_epi64(acc[c], _mm256_sad_epu8(_mm256_and_si256(bytes, mask[v][c]), zero));
+				}
+			}
+		}
+
+		if (end - pixel >= 16)
+		{
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(pixel);
+			for (int v = 0; v < 3; ++v)
+			{
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * v));
+				for (int c = 0; c < 3; ++c)
+				{
+					acc16[c] = _mm_add_epi64(acc16[c], _mm_sad_epu8(_mm_and_si128(bytes, mask16[v][c]), _mm_setzero_si128()));
+				}
+			}
+			pixel += 16;
+		}
+		accumulateRun(pixel, end, red, green, blue);
+	}
+
+	alignas(32) uint64_t lanes[3][4];
+	alignas(16) uint64_t lanes16[3][2];
+	for (int c = 0; c < 3; ++c)
+	{
+		_mm256_store_si256(reinterpret_cast<__m256i*>(lanes[c]), acc[c]);
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes16[c]), acc16[c]);
+	}
+	sum.red   += red   + lanes[0][0] + lanes[0][1] + lanes[0][2] + lanes[0][3] + lanes16[0][0] + lanes16[0][1];
+	sum.green += green + lanes[1][0] + lanes[1][1] + lanes[1][2] + lanes[1][3] + lanes16[1][0] + lanes16[1][1];
+	sum.blue  += blue  + lanes[2][0] + lanes[2][1] + lanes[2][2] + lanes[2][3] + lanes16[2][0] + lanes16[2][1];
+}
+
+#elif defined(HYPERION_SIMD_NEON)
+
+// vld3 de-interleaves 16 pixels into one vector per channel. The 16 bit accumulators take at
+// most 128 iterations (2 * 255 per lane and iteration) before they are widened into 64 bit.
+void accumulateNeon(const ColorRgb* image, size_t stride, const LedSpan* spans, size_t spanCount, ColorSum& sum)
+{
+	uint64x2_t acc64[3] = { vdupq_n_u64(0), vdupq_n_u64(0), vdupq_n_u64(0) };
+	uint16x8_t acc16[3] = { vdupq_n_u16(0), vdupq_n_u16(0), vdupq_n_u16(0) };
+	unsigned pending = 0;
+	uint64_t red = 0, green = 0, blue = 0;
+
+	for (const LedSpan* span = spans; span != spans + spanCount; ++span)
+	{
+		const ColorRgb* pixel = reinterpret_cast<const ColorRgb*>(reinterpret_cast<const uint8_t*>(image) + span->row * stride) + span->xBegin;
+		const ColorRgb* end   = pixel + (span->xEnd - span->xBegin);
+
+		for (; end - pixel >= 16; pixel += 16)
+		{
+			const uint8x16x3_t rgb = vld3q_u8(reinterpret_cast<const uint8_t*>(pixel));
+			acc16[0] = vpadalq_u8(acc16[0], rgb.val[0]);
+			acc16[1] = vpadalq_u8(acc16[1], rgb.val[1]);
+			acc16[2] = vpadalq_u8(acc16[2], rgb.val[2]);
+
+			if (++pending == 128)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					acc64[c] = vpadalq_u32(acc64[c], vpaddlq_u16(acc16[c]));
+					acc16[c] = vdupq_n_u16(0);
+				}
+				pending = 0;
+			}
+		}
+		accumulateRun(pixel, end, red, green, blue);
+	}
+
+	for (int c = 0; c < 3; ++c)
+	{
+		acc64[c] = vpadalq_u32(acc64[c], vpaddlq_u16(acc16[c]));
+	}
+
+	sum.red   += red   + vgetq_lane_u64(acc64[0], 0) + vgetq_lane_u64(acc64[0], 1);
+	sum.green += green + vgetq_lane_u64(acc64[1], 0) + vgetq_lane_u64(acc64[1], 1);
+	sum.blue  += blue  + vgetq_lane_u64(acc64[2], 0) + vgetq_lane_u64(acc64[2], 1);
+}
+
+#endif
+
+struct AccumulateKernel
+{
+	AccumulateFunc func;
+	const char* name;
+};
+
+const AccumulateKernel& selectKernel()
+{
+	static const AccumulateKernel kernel = []() -> AccumulateKernel
+	{
+#if defined(HYPERION_SIMD_X86)
+		if (CpuFeatures::hasAVX2())
+		{
+			return { accumulateAvx2, "avx2" };
+		}
+		if (CpuFeatures::hasSSE2())
+		{
+			return { accumulateSse2, "sse2" };
+		}
+#elif defined(HYPERION_SIMD_NEON)
+		return { accumulateNeon, "neon" };
+#endif
+		return { accumulateScalar, "scalar" };
+	}();
+
+	return kernel;
+}
+
+} // namespace
+
+void hyperion::accumulateColors(const ColorRgb* image, size_t stride, const LedSpan* spans, size_t spanCount, ColorSum& sum)
+{
+	static const AccumulateFunc kernel = selectKernel().func;
+	kernel(image, stride, spans, spanCount, sum);
+}
+
+const char* hyperion::accumulateColorsKernelName()
+{
+	return selectKernel().name;
+}
+
 ImageToLedsMap::ImageToLedsMap(
 		unsigned width,
 		unsigned height,
@@ -12,7 +269,9 @@ ImageToLedsMap::ImageToLedsMap(
 	, _height(height)
 	, _horizontalBorder(horizontalBorder)
 	, _verticalBorder(verticalBorder)
-	, _colorsMap()
+	, _spans()
+	, _ledAreas()
+	, _mappedPixelCount(0)
 {
 	// Sanity check of the size of the borders (and width and height)
 	Q_ASSERT(_width  > 2*_verticalBorder);
@@ -21,7 +280,7 @@ ImageToLedsMap::ImageToLedsMap(
 	Q_ASSERT(_height < 10000);
 
 	// Reserve enough space in the map for the leds
-	_colorsMap.reserve(leds.size());
+	_ledAreas.reserve(leds.size());
 
 	const unsigned xOffset      = _verticalBorder;
 	const unsigned actualWidth  = _width  - 2 * _verticalBorder;
@@ -33,7 +292,7 @@ ImageToLedsMap::ImageToLedsMap(
 		// skip leds without area
 		if ((led.maxX_frac-led.minX_frac) < 1e-6 || (led.maxY_frac-led.minY_frac) < 1e-6)
 		{
-			_colorsMap.emplace_back();
+			_ledAreas.push_back({ static_cast<unsigned>(_spans.size()), 0, 0 });
 			continue;
 		}
 
@@ -55,23 +314,24 @@ ImageToLedsMap::ImageToLedsMap(
 			maxY_idx++;
 		}
 
-		// Add all the indices in the above defined rectangle to the indices for this led
+		// Add one span per row of the above defined rectangle to the spans for this led
 		const auto maxYLedCount = qMin(maxY_idx, yOffset+actualHeight);
 		const auto maxXLedCount = qMin(maxX_idx, xOffset+actualWidth);
 
-		std::vector<unsigned> ledColors;
-		ledColors.reserve((size_t) maxXLedCount*maxYLedCount);
-
-		for (unsigned y = minY_idx; y < maxYLedCount; ++y)
+		LedArea area { static_cast<unsigned>(_spans.size()), 0, 0 };
+		if (minX_idx < maxXLedCount)
 		{
-			for (unsigned x = minX_idx; x < maxXLedCount; ++x)
+			for (unsigned y = minY_idx; y < maxYLedCount; ++y)
 			{
-				ledColors.push_back(y*width + x);
+				_spans.push_back({ y, minX_idx, maxXLedCount });
+				++area.spanCount;
+				area.pixelCount += maxXLedCount - minX_idx;
 			}
 		}
 
-		// Add the constructed vector to the map
-		_colorsMap.push_back(ledColors);
+		// Add the constructed area to the map
+		_ledAreas.push_back(area);
+		_mappedPixelCount += area.pixelCount;
 	}
 }
 
@@ -84,3 +344,28 @@ unsigned ImageToLedsMap::height() const
 {
 	return _height;
 }
+
+void ImageToLedsMap::getIntegralLedColor(const IntegralImage & integral, std::vector<ColorRgb> & ledColors) const
+{
+	if(_ledAreas.size() != ledColors.size() || !integral.valid() || integral.width() != _width || integral.height() != _height)
+	{
+		Debug(Logger::getInstance("HYPERION"), "ImageToLedsMap: summed-area table does not match the map");
+		return;
+	}
+
+	auto led = ledColors.begin();
+	for (const LedArea& area : _ledAreas)
+	{
+		if (area.pixelCount == 0)
+		{
+			*led++ = ColorRgb::BLACK;
+			continue;
+		}
+
+		// the spans of a led are consecutive rows of equal width
+		const LedSpan& first = _spans[area.firstSpan];
+		const IntegralImage::Entry sum = integral.sum(first.xBegin, first.row, first.xEnd, first.row + area.spanCount);
+
+		*led++ = ColorRgb{uint8_t(sum.red/area.pixelCount), uint8_t(sum.green/area.pixelCount), uint8_t(sum.blue/area.pixelCount)};
+	}
+}
@@ -0,0 +1,82 @@
+#include <hyperion/ImageToLedsMapCache.h>
+
+#include <cstring>
+
+using namespace hyperion;
+
+ImageToLedsMapCache::ImageToLedsMapCache(size_t capacity)
+	: _capacity(capacity > 0 ? capacity : 1)
+	, _entries()
+	, _hits(0)
+	, _misses(0)
+	, _size(0)
+{
+}
+
+std::shared_ptr<const ImageToLedsMap> ImageToLedsMapCache::get(
+		unsigned width,
+		unsigned height,
+		unsigned horizontalBorder,
+		unsigned verticalBorder,
+		const std::vector<Led> & leds)
+{
+	const uint64_t hash = layoutHash(leds);
+
+	for (auto it = _entries.begin(); it != _entries.end(); ++it)
+	{
+		if (it->width == width && it->height == height
+				&& it->horizontalBorder == horizontalBorder && it->verticalBorder == verticalBorder
+				&& it->layoutHash == hash)
+		{
+			// move to front (most recently used)
+			_entries.splice(_entries.begin(), _entries, it);
+			++_hits;
+			return _entries.front().map;
+		}
+	}
+
+	++_misses;
+	std::shared_ptr<const ImageToLedsMap> map = std::make_shared<ImageToLedsMap>(width, height, horizontalBorder, verticalBorder, leds);
+	_entries.push_front({width, height, horizontalBorder, verticalBorder, hash, map});
+
+	if (_entries.size() > _capacity)
+	{
+		_entries.pop_back();
+	}
+	_size = _entries.size();
+
+	return map;
+}
+
+void ImageToLedsMapCache::clear()
+{
+	_entries.clear();
+	_size = 0;
+}
+
+uint64_t ImageToLedsMapCache::layoutHash(const std::vector<Led> & leds)
+{
+	// FNV-1a over the scan area of all leds
+	uint64_t hash = 14695981039346656037ULL;
+	const auto add = [&hash](double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		for (int i = 0; i < 8; ++i)
+		{
+			hash ^= (bits >> (i * 8)) & 0xff;
+			hash *= 1099511628211ULL;
+		}
+	};
+
+	for (const Led& led : leds)
+	{
+		add(led.minX_frac);
+		add(led.maxX_frac);
+		add(led.minY_frac);
+		add(led.maxY_frac);
+	}
+	add(static_cast<double>(leds.size()));
+
+	return hash;
+}
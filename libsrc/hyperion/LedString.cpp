@@ -14,3 +14,42 @@ const std::vector<Led>& LedString::leds() const
 {
 	return mLeds;
 }
+
+std::vector<ColorOrderRun> LedString::colorOrderRuns() const
+{
+	std::vector<ColorOrderRun> runs;
+	for (size_t i = 0; i < mLeds.size(); ++i)
+	{
+		ColorOrderRun run { i, i + 1, {0, 1, 2} };
+		switch (mLeds[i].colorOrder)
+		{
+		case ColorOrder::ORDER_RGB:
+			break;
+		case ColorOrder::ORDER_BGR:
+			run.channel[0] = 2; run.channel[1] = 1; run.channel[2] = 0;
+			break;
+		case ColorOrder::ORDER_RBG:
+			run.channel[0] = 0; run.channel[1] = 2; run.channel[2] = 1;
+			break;
+		case ColorOrder::ORDER_GRB:
+			run.channel[0] = 1; run.channel[1] = 0; run.channel[2] = 2;
+			break;
+		case ColorOrder::ORDER_GBR:
+			run.channel[0] = 1; run.channel[1] = 2; run.channel[2] = 0;
+			break;
+		case ColorOrder::ORDER_BRG:
+			run.channel[0] = 2; run.channel[1] = 0; run.channel[2] = 1;
+			break;
+		}
+
+		if (!runs.empty() && std::memcmp(runs.back().channel, run.channel, sizeof(run.channel)) == 0)
+		{
+			runs.back().end = run.end;
+		}
+		else
+		{
+			runs.push_back(run);
+		}
+	}
+	return runs;
+}
@@ -1,14 +1,24 @@
 // Qt includes
 #include <QDateTime>
 #include <QTimer>
+#include <QMutexLocker>
 
 #include "LinearColorSmoothing.h"
+#include "SmoothingKernels.h"
 #include <hyperion/Hyperion.h>
+#include <utils/Tracer.h>
 
 #include <cmath>
 #include <chrono>
 #include <thread>
 
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <time.h>
+#endif
+
 /// The number of microseconds per millisecond = 1000.
 const int64_t MS_PER_MICRO = 1000;
 
@@ -20,11 +30,6 @@ const int64_t MS_PER_MICRO = 1000;
 #define ALWAYS_INLINE inline
 #endif
 
-/// Clamps the rounded values to the byte-interval of [0, 255].
-ALWAYS_INLINE long clampRounded(const floatT x) {
-	return std::min(255L, std::max(0L, std::lroundf(x)));
-}
-
 /// The number of bits that are used for shifting the fixed point values
 const int FPShift = (sizeof(uint64_t)*8 - (12 + 9));
 
@@ -34,6 +39,9 @@ const int SmallShiftBis = sizeof(uint8_t)*8;
 /// The number of bits that are used for shifting the fixed point values plus SmallShiftBis
 const int FPShiftSmall = (sizeof(uint64_t)*8 - (12 + 9 + SmallShiftBis));
 
+/// The scale of the Q16 fixed point mean values and residual errors
+const float Q16 = 65536.0F;
+
 const char* SETTINGS_KEY_SMOOTHING_TYPE = "type";
 const char* SETTINGS_KEY_INTERPOLATION_RATE = "interpolationRate";
 const char* SETTINGS_KEY_OUTPUT_RATE = "outputRate";
@@ -48,6 +56,12 @@ const int DEFAUL_UPDATEFREQUENCY = 25;													// updatefrequncy in hz
 constexpr std::chrono::milliseconds DEFAUL_UPDATEINTERVALL{1000/ DEFAUL_UPDATEFREQUENCY};
 const unsigned DEFAUL_OUTPUTDEPLAY = 0;														// outputdelay in ms
 
+/// The period of the output statistics
+const int64_t STATISTICS_PERIOD_MICROS = 30 * 1000000;
+
+/// The SCHED_FIFO priority of the output clock thread, above the default threads but below the kernel's
+const int OUTPUT_CLOCK_REALTIME_PRIORITY = 10;
+
 LinearColorSmoothing::LinearColorSmoothing(const QJsonDocument &config, Hyperion *hyperion)
 	: QObject(hyperion)
 	, _log(Logger::getInstance("SMOOTHING"))
@@ -55,14 +69,26 @@ LinearColorSmoothing::LinearColorSmoothing(const QJsonDocument &config, Hyperion
 	, _updateInterval(DEFAUL_UPDATEINTERVALL.count())
 	, _settlingTime(DEFAUL_SETTLINGTIME)
 	, _timer(new QTimer(this))
+	, _stateMutex(QMutex::Recursive)
+	, _clockActive(false)
+	, _clockQuit(false)
+	, _realtimeOutput(false)
 	, _outputDelay(DEFAUL_OUTPUTDEPLAY)
 	, _smoothingType(SmoothingType::Linear)
+	, _linearWeighting(true)
 	, _writeToLedsEnable(false)
 	, _continuousOutput(false)
 	, _pause(false)
 	, _currentConfigId(0)
 	, _enabled(false)
 	, tempValues(std::vector<uint64_t>(0, 0L))
+	, _kernels(&hyperion::smoothingKernels())
+	, _jitterSum(0)
+	, _jitterMax(0)
+	, _deadlineMisses(0)
+	, _settledUpdates(0)
+	, _idleSince(0)
+	, _idleTime(0)
 {
 	// init cfg 0 (default)
 	addConfig(DEFAUL_SETTLINGTIME, DEFAUL_UPDATEFREQUENCY, DEFAUL_OUTPUTDEPLAY);
@@ -81,12 +107,27 @@ LinearColorSmoothing::LinearColorSmoothing(const QJsonDocument &config, Hyperion
 	//Debug(_log, "LinearColorSmoothing sizeof floatT == %d", (sizeof(floatT)));
 }
 
+LinearColorSmoothing::~LinearColorSmoothing()
+{
+	if (_clockThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(_clockMutex);
+			_clockActive = false;
+			_clockQuit = true;
+		}
+		_clockCondition.notify_one();
+		_clockThread.join();
+	}
+}
+
 void LinearColorSmoothing::handleSettingsUpdate(settings::type type, const QJsonDocument &config)
 {
 	if (type == settings::SMOOTHING)
 	{
 		//	std::cout << "LinearColorSmoothing::handleSettingsUpdate" << std::endl;
 		//	std::cout << config.toJson().toStdString() << std::endl;
+		QMutexLocker lock(&_stateMutex);
 
 		QJsonObject obj = config.object();
 		if (enabled() != obj["enable"].toBool(true))
@@ -95,6 +136,7 @@ void LinearColorSmoothing::handleSettingsUpdate(settings::type type, const QJson
 		}
 
 		_continuousOutput = obj["continuousOutput"].toBool(true);
+		_realtimeOutput = obj["realtimeOutput"].toBool(false);
 
 		SMOOTHING_CFG cfg = {SmoothingType::Linear,true, 0, 0, 0, 0, 0, false, 1};
 
@@ -133,8 +175,16 @@ void LinearColorSmoothing::handleSettingsUpdate(settings::type type, const QJson
 
 int LinearColorSmoothing::write(const std::vector<ColorRgb> &ledValues)
 {
-	_targetTime = micros() + (MS_PER_MICRO * _settlingTime);
+	// an unchanged target neither restarts the settling time nor wakes parked updates
+	if (!_previousValues.empty() && ledValues == _targetValues)
+	{
+		return 0;
+	}
+
+	const int64_t now = micros();
+	_targetTime = now + (MS_PER_MICRO * _settlingTime);
 	_targetValues = ledValues;
+	_settledUpdates = 0;
 
 	rememberFrame(ledValues);
 
@@ -147,7 +197,11 @@ int LinearColorSmoothing::write(const std::vector<ColorRgb> &ledValues)
 		_previousInterpolationTime = micros();
 
 		//Debug( _log, "Start Smoothing timer: settlingTime: %d ms, interval: %d ms (%u Hz), updateDelay: %u frames", _settlingTime, _updateInterval, unsigned(1000.0/_updateInterval), _outputDelay );
-		QMetaObject::invokeMethod(_timer, "start", Qt::QueuedConnection, Q_ARG(int, _updateInterval));
+		startUpdates();
+	}
+	else if (_idleSince != 0)
+	{
+		wakeUpdates(now);
 	}
 
 	return 0;
@@ -155,6 +209,8 @@ int LinearColorSmoothing::write(const std::vector<ColorRgb> &ledValues)
 
 int LinearColorSmoothing::updateLedValues(const std::vector<ColorRgb> &ledValues)
 {
+	QMutexLocker lock(&_stateMutex);
+
 	int retval = 0;
 	if (!_enabled)
 	{
@@ -176,8 +232,8 @@ void LinearColorSmoothing::intitializeComponentVectors(const size_t ledCount)
 
 		const size_t len = 3 * ledCount;
 
-		meanValues = std::vector<floatT>(len, 0.0F);
-		residualErrors = std::vector<floatT>(len, 0.0F);
+		meanValues = std::vector<int32_t>(len, 0);
+		residualErrors = std::vector<int32_t>(len, 0);
 		tempValues = std::vector<uint64_t>(len, 0L);
 	}
 
@@ -207,7 +263,8 @@ void LinearColorSmoothing::writeFrame()
 
 ALWAYS_INLINE int64_t LinearColorSmoothing::micros() const
 {
-	const auto now = std::chrono::high_resolution_clock::now();
+	// monotonic, the output clock thread sleeps until deadlines on the same clock
+	const auto now = std::chrono::steady_clock::now();
 	return (std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch())).count();
 }
 
@@ -218,32 +275,11 @@ void LinearColorSmoothing::assembleAndDitherFrame()
 		return;
 	}
 
-	// The number of leds present in each frame
-	const size_t N = _targetValues.size();
-
-	for (size_t i = 0; i < N; ++i)
-	{
-		// Add residuals for error diffusion (temporal dithering)
-		const floatT fr = meanValues[3 * i + 0] + residualErrors[3 * i + 0];
-		const floatT fg = meanValues[3 * i + 1] + residualErrors[3 * i + 1];
-		const floatT fb = meanValues[3 * i + 2] + residualErrors[3 * i + 2];
+	// The number of components present in each frame
+	const size_t count = 3 * std::min(_previousValues.size(), meanValues.size() / 3);
 
-		// Convert to to 8-bit value
-		const long ir = clampRounded(fr);
-		const long ig = clampRounded(fg);
-		const long ib = clampRounded(fb);
-
-		// Update the colors
-		ColorRgb &prev = _previousValues[i];
-		prev.red = static_cast<uint8_t>(ir);
-		prev.green = static_cast<uint8_t>(ig);
-		prev.blue = static_cast<uint8_t>(ib);
-
-		// Determine the component errors
-		residualErrors[3 * i + 0] = fr - ir;
-		residualErrors[3 * i + 1] = fg - ig;
-		residualErrors[3 * i + 2] = fb - ib;
-	}
+	// Round the mean plus the residuals and keep the new rounding errors for the next frame (temporal dithering)
+	_kernels->dither(meanValues.data(), residualErrors.data(), reinterpret_cast<uint8_t*>(_previousValues.data()), count);
 }
 
 void LinearColorSmoothing::assembleFrame()
@@ -253,22 +289,10 @@ void LinearColorSmoothing::assembleFrame()
 		return;
 	}
 
-	// The number of leds present in each frame
-	const size_t N = _targetValues.size();
+	// The number of components present in each frame
+	const size_t count = 3 * std::min(_previousValues.size(), meanValues.size() / 3);
 
-	for (size_t i = 0; i < N; ++i)
-	{
-		// Convert to to 8-bit value
-		const long ir = clampRounded(meanValues[3 * i + 0]);
-		const long ig = clampRounded(meanValues[3 * i + 1]);
-		const long ib = clampRounded(meanValues[3 * i + 2]);
-
-		// Update the colors
-		ColorRgb &prev = _previousValues[i];
-		prev.red = static_cast<uint8_t>(ir);
-		prev.green = static_cast<uint8_t>(ig);
-		prev.blue = static_cast<uint8_t>(ib);
-	}
+	_kernels->round(meanValues.data(), reinterpret_cast<uint8_t*>(_previousValues.data()), count);
 }
 
 ALWAYS_INLINE void LinearColorSmoothing::aggregateComponents(const std::vector<ColorRgb>& colors, std::vector<uint64_t>& weighted, const floatT weight) {
@@ -293,6 +317,21 @@ ALWAYS_INLINE void LinearColorSmoothing::aggregateComponents(const std::vector<C
 	}
 }
 
+ALWAYS_INLINE void LinearColorSmoothing::accumulateComponents(const std::vector<ColorRgb>& colors, std::vector<uint64_t>& sum, const int64_t duration) {
+	const uint64_t scale = static_cast<uint64_t>(duration);
+
+	const size_t N = colors.size();
+
+	for (size_t i = 0; i < N; ++i)
+	{
+		const ColorRgb &color = colors[i];
+
+		sum[3 * i + 0] += scale * color.red;
+		sum[3 * i + 1] += scale * color.green;
+		sum[3 * i + 2] += scale * color.blue;
+	}
+}
+
 void LinearColorSmoothing::interpolateFrame()
 {
 	const int64_t now = micros();
@@ -302,15 +341,60 @@ void LinearColorSmoothing::interpolateFrame()
 
 	intitializeComponentVectors(N);
 
+	/// Time where the current window has started
+	const int64_t windowStart = now - (MS_PER_MICRO * _settlingTime);
+
+	expireFrames(windowStart);
+
+	if (_linearWeighting)
+	{
+		// The weight of a frame is the time it was shown inside the window, so the window sum of the completely shown
+		// frames only has to be corrected by the clipped part of the oldest and the elapsed part of the current frame
+		if (!_frameQueue.empty() && _frameQueue.back().colors.size() == N)
+		{
+			const REMEMBERED_FRAME &oldest = _frameQueue.front();
+			const REMEMBERED_FRAME &current = _frameQueue.back();
+
+			if (_frameQueue.size() > 1)
+			{
+				tempValues = _windowSum;
+				if (oldest.time < windowStart)
+				{
+					accumulateComponents(oldest.colors, tempValues, oldest.time - windowStart);
+				}
+			}
+			accumulateComponents(current.colors, tempValues, now - std::max(windowStart, current.time));
+
+			/// The time the frames were shown inside the window, the window is not filled yet if less than its size
+			const int64_t shownTime = now - std::max(windowStart, oldest.time);
+
+			/// Normalizes the sum to the mean component values, like the weights of the frames (fs) do below
+			const double scale = (shownTime * static_cast<double>(_invWindow) < 1.0) ? _invWindow : 1.0 / shownTime;
+
+			// A sum is at most 255 per microsecond of the window, drop the bits exceeding the 31 bits of the kernel
+			unsigned shift = 0;
+			while (((255 * std::max<int64_t>(shownTime, 1)) >> shift) >= (int64_t(1) << 31))
+			{
+				++shift;
+			}
+
+			_kernels->normalize(tempValues.data(), meanValues.data(), 3 * N, shift, static_cast<float>(scale * Q16 * (int64_t(1) << shift)));
+		}
+		else
+		{
+			std::fill(meanValues.begin(), meanValues.end(), 0);
+		}
+
+		_previousInterpolationTime = now;
+		return;
+	}
+
 	/// Time where the frame has been shown
 	int64_t frameStart;
 
 	/// Time where the frame display would have ended
 	int64_t frameEnd = now;
 
-	/// Time where the current window has started
-	const int64_t windowStart = now - (MS_PER_MICRO * _settlingTime);
-
 	/// The total weight of the frames that were included in our window; sum of the individual weights
 	floatT fs = 0.0F;
 
@@ -337,10 +421,7 @@ void LinearColorSmoothing::interpolateFrame()
 	const floatT inv_fs = ((fs < 1.0F) ? 1.0F : 1.0F / fs) / (1 << SmallShiftBis);
 
 	// Normalize the mean component values for the window (fs)
-	for (size_t i = 0; i < 3 * N; ++i)
-	{
-		meanValues[i] = (tempValues[i] >> FPShiftSmall) * inv_fs;
-	}
+	_kernels->normalize(tempValues.data(), meanValues.data(), 3 * N, FPShiftSmall, inv_fs * Q16);
 
 	_previousInterpolationTime = now;
 }
@@ -353,10 +434,10 @@ void LinearColorSmoothing::performDecay(const int64_t now) {
 	const int64_t writeTarget = _previousWriteTime + _outputIntervalMicros;
 
 	/// Whether a frame interpolation is pending
-	const bool interpolatePending = now > interpolationTarget;
+	const bool interpolatePending = now >= interpolationTarget;
 
 	/// Whether a write is pending
-	const bool writePending = now > writeTarget;
+	const bool writePending = now >= writeTarget;
 
 	// Check whether a new interpolation frame is due
 	if (interpolatePending)
@@ -380,64 +461,62 @@ void LinearColorSmoothing::performDecay(const int64_t now) {
 
 		writeFrame();
 		++_renderedCounter;
-	}
 
-	// Check for sleep when no operation is pending.
-	// As our QTimer is not capable of sub 1ms timing but instead performs spinning -
-	// we have to do µsec-sleep to free CPU time; otherwise the thread would consume 100% CPU time.
-	if(_updateInterval <= 0 && !(interpolatePending || writePending)) {
-		const int64_t nextActionExpected = std::min(interpolationTarget, writeTarget);
-		const int64_t microsTillNextAction = nextActionExpected - now;
-		const int64_t SLEEP_MAX_MICROS = 1000L; // We want to use usleep for up to 1ms
-		const int64_t SLEEP_RES_MICROS = 100L; // Expected resolution is >= 100µs on stock linux
-
-		if(microsTillNextAction > SLEEP_RES_MICROS) {
-			const int64_t wait = std::min(microsTillNextAction - SLEEP_RES_MICROS, SLEEP_MAX_MICROS);
-			//usleep(wait);
-			std::this_thread::sleep_for(std::chrono::microseconds(wait));
+		// The delay of the write after its deadline
+		const int64_t jitter = now - writeTarget;
+		_jitterSum += jitter;
+		_jitterMax = std::max(_jitterMax, jitter);
+		if (jitter > _outputIntervalMicros)
+		{
+			++_deadlineMisses;
 		}
 	}
 
-	// Write stats every 30 sec
-	if ((now > (_renderedStatTime + 30 * 1000000)) && (_renderedCounter > _renderedStatCounter))
+	// Publish the statistics of the period
+	if (now > (_renderedStatTime + STATISTICS_PERIOD_MICROS))
 	{
-		Debug(_log, "decay - rendered frames [%d] (%f/s), interpolated frames [%d] (%f/s) in [%f ms]"
-		, _renderedCounter - _renderedStatCounter
-		, (1.0F * (_renderedCounter - _renderedStatCounter) / ((now - _renderedStatTime) / 1000000.0F))
-		, _interpolationCounter - _interpolationStatCounter
-		, (1.0F * (_interpolationCounter - _interpolationStatCounter) / ((now - _renderedStatTime) / 1000000.0F))
-		, (now - _renderedStatTime) / 1000.0F
-		);
+		const int64_t rendered = _renderedCounter - _renderedStatCounter;
+		const double period = (now - _renderedStatTime) / 1000000.0;
+
+		QJsonObject statistics;
+		statistics["renderedRate"] = rendered / period;
+		statistics["interpolationRate"] = (_interpolationCounter - _interpolationStatCounter) / period;
+		statistics["meanJitter"] = rendered > 0 ? static_cast<double>(_jitterSum) / rendered : 0.0;
+		statistics["maxJitter"] = static_cast<double>(_jitterMax);
+		statistics["deadlineMisses"] = static_cast<double>(_deadlineMisses);
+		{
+			QMutexLocker lock(&_statisticsMutex);
+			_statistics = statistics;
+		}
+
 		_renderedStatTime = now;
 		_renderedStatCounter = _renderedCounter;
 		_interpolationStatCounter = _interpolationCounter;
+		_jitterSum = 0;
+		_jitterMax = 0;
 	}
 }
 
 void LinearColorSmoothing::performLinear(const int64_t now) {
-	const int64_t deltaTime = _targetTime - now;
-	const float k = 1.0F - 1.0F * deltaTime / (_targetTime - _previousWriteTime);
-	const size_t N = _previousValues.size();
+	// The fraction of the remaining distance to the target to move; (now - previous write) : (target time - previous write)
+	const int64_t elapsed = now - _previousWriteTime;
+	const int64_t remaining = _targetTime - _previousWriteTime;
+	const uint32_t k = remaining > 0
+			? static_cast<uint32_t>(std::min<int64_t>(65535, std::max<int64_t>(0, (elapsed * 65536 + remaining - 1) / remaining)))
+			: 65535;
 
-	for (size_t i = 0; i < N; ++i)
-	{
-		const ColorRgb &target = _targetValues[i];
-		ColorRgb &prev         = _previousValues[i];
-
-		const int reddif   = target.red   - prev.red;
-		const int greendif = target.green - prev.green;
-		const int bluedif  = target.blue  - prev.blue;
-
-		prev.red   += (reddif   < 0 ? -1:1) * std::ceil(k * std::abs(reddif));
-		prev.green += (greendif < 0 ? -1:1) * std::ceil(k * std::abs(greendif));
-		prev.blue  += (bluedif  < 0 ? -1:1) * std::ceil(k * std::abs(bluedif));
-	}
+	const size_t count = 3 * std::min(_previousValues.size(), _targetValues.size());
+	_kernels->linearStep(reinterpret_cast<uint8_t*>(_previousValues.data()), reinterpret_cast<const uint8_t*>(_targetValues.data()), count, k);
 
 	writeFrame();
 }
 
 void LinearColorSmoothing::updateLeds()
 {
+	TRACE_SCOPE("smoothing.update");
+
+	QMutexLocker lock(&_stateMutex);
+
 	const int64_t now = micros();
 	const int64_t deltaTime = _targetTime - now;
 
@@ -445,6 +524,7 @@ void LinearColorSmoothing::updateLeds()
 	if (deltaTime < 0)
 	{
 		writeDirect();
+		parkUpdates(now);
 		return;
 	}
 
@@ -468,23 +548,26 @@ void LinearColorSmoothing::rememberFrame(const std::vector<ColorRgb> &ledColors)
 
 	const int64_t now = micros();
 
-	// Maintain the queue by removing outdated frames
-	const int64_t windowStart = now - (MS_PER_MICRO * _settlingTime);
-
-	int p = -1; // Start with -1 instead of 0, so we keep the last frame at least partially clipping the window
-
-	// As the frames are ordered chronologically we scan from the front (oldest) till we find the first fresh frame
-	for (auto it = _frameQueue.begin(); it != _frameQueue.end() && it->time < windowStart; ++it)
+	// Frames of another led layout can not be averaged with the new one
+	if (!_frameQueue.empty() && _frameQueue.back().colors.size() != ledColors.size())
 	{
-		++p;
+		_frameQueue.clear();
 	}
 
-	if (p > 0)
+	if (_frameQueue.empty())
+	{
+		_windowSum.assign(3 * ledColors.size(), 0);
+	}
+	else
 	{
-		//Debug(_log, "rememberFrame -  erasing %d frames", p);
-		_frameQueue.erase(_frameQueue.begin(), _frameQueue.begin() + p);
+		// The display of the previous frame ends now, so it is added to the window sum
+		const REMEMBERED_FRAME &previous = _frameQueue.back();
+		accumulateComponents(previous.colors, _windowSum, now - previous.time);
 	}
 
+	// Maintain the queue by removing outdated frames
+	expireFrames(now - (MS_PER_MICRO * _settlingTime));
+
 	// Append the latest frame at back of the queue
 	const REMEMBERED_FRAME frame = REMEMBERED_FRAME(now, ledColors);
 	_frameQueue.push_back(frame);
@@ -492,10 +575,22 @@ void LinearColorSmoothing::rememberFrame(const std::vector<ColorRgb> &ledColors)
 	//Debug(_log, "rememberFrame -  after _frameQueue.size() [%d]", _frameQueue.size());
 }
 
+void LinearColorSmoothing::expireFrames(const int64_t windowStart)
+{
+	// As the frames are ordered chronologically we scan from the front (oldest) till the successor is fresh,
+	// so we keep the last frame at least partially clipping the window
+	while (_frameQueue.size() > 1 && _frameQueue[1].time <= windowStart)
+	{
+		const REMEMBERED_FRAME &expired = _frameQueue.front();
+		accumulateComponents(expired.colors, _windowSum, expired.time - _frameQueue[1].time);
+		_frameQueue.pop_front();
+	}
+}
 
 void LinearColorSmoothing::clearRememberedFrames()
 {
 	_frameQueue.clear();
+	_windowSum.clear();
 
 	_ledCount = 0;
 	meanValues.clear();
@@ -506,6 +601,10 @@ void LinearColorSmoothing::clearRememberedFrames()
 void LinearColorSmoothing::queueColors(const std::vector<ColorRgb> &ledColors)
 {
 	//Debug(_log, "queueColors -  _outputDelay[%d] _outputQueue.size() [%d], _writeToLedsEnable[%d]", _outputDelay, _outputQueue.size(), _writeToLedsEnable);
+
+	// the latest input frame is traced with the first colors output after it
+	const int64_t captureTime = _hyperion->getLatencyTracker()->takeOver(LatencyTracker::SMOOTHING);
+
 	if (_outputDelay == 0)
 	{
 		// No output delay => immediate write
@@ -514,7 +613,7 @@ void LinearColorSmoothing::queueColors(const std::vector<ColorRgb> &ledColors)
 			//			if ( ledColors.size() == 0 )
 			//				qFatal ("No LedValues! - in LinearColorSmoothing::queueColors() - _outputDelay == 0");
 			//			else
-			emit _hyperion->ledDeviceData(ledColors);
+			outputColors(ledColors, captureTime);
 		}
 	}
 	else
@@ -523,6 +622,7 @@ void LinearColorSmoothing::queueColors(const std::vector<ColorRgb> &ledColors)
 		if (_writeToLedsEnable)
 		{
 			_outputQueue.push_back(ledColors);
+			_outputQueueCaptureTimes.push_back(captureTime);
 		}
 
 		// If the delay-buffer is filled pop the front and write to device
@@ -532,17 +632,41 @@ void LinearColorSmoothing::queueColors(const std::vector<ColorRgb> &ledColors)
 			{
 				if (!_pause)
 				{
-					emit _hyperion->ledDeviceData(_outputQueue.front());
+					outputColors(_outputQueue.front(), _outputQueueCaptureTimes.front());
 				}
 				_outputQueue.pop_front();
+				_outputQueueCaptureTimes.pop_front();
 			}
 		}
 	}
 }
 
+void LinearColorSmoothing::outputColors(const std::vector<ColorRgb> &ledColors, int64_t captureTime)
+{
+	if (captureTime != 0)
+	{
+		LatencyTracker* latency = _hyperion->getLatencyTracker();
+		latency->record(LatencyTracker::SMOOTHING, captureTime);
+		latency->handOver(LatencyTracker::DEVICE, captureTime);
+	}
+
+	if (_clockActive)
+	{
+		_hyperion->publishLedDeviceData(ledColors);
+	}
+	else
+	{
+		emit _hyperion->ledDeviceData(ledColors);
+	}
+}
+
 void LinearColorSmoothing::clearQueuedColors()
 {
-	QMetaObject::invokeMethod(_timer, "stop", Qt::QueuedConnection);
+	QMutexLocker lock(&_stateMutex);
+
+	stopUpdates();
+	leaveIdle(micros());
+	_settledUpdates = 0;
 	_previousValues.clear();
 
 	_targetValues.clear();
@@ -552,6 +676,8 @@ void LinearColorSmoothing::clearQueuedColors()
 
 void LinearColorSmoothing::componentStateChange(hyperion::Components component, bool state)
 {
+	QMutexLocker lock(&_stateMutex);
+
 	_writeToLedsEnable = state;
 	if (component == hyperion::COMP_LEDDEVICE)
 	{
@@ -566,6 +692,8 @@ void LinearColorSmoothing::componentStateChange(hyperion::Components component,
 
 void LinearColorSmoothing::setEnable(bool enable)
 {
+	QMutexLocker lock(&_stateMutex);
+
 	_enabled = enable;
 	if (!_enabled)
 	{
@@ -577,6 +705,8 @@ void LinearColorSmoothing::setEnable(bool enable)
 
 void LinearColorSmoothing::setPause(bool pause)
 {
+	QMutexLocker lock(&_stateMutex);
+
 	_pause = pause;
 }
 
@@ -627,6 +757,8 @@ unsigned LinearColorSmoothing::updateConfig(unsigned cfgID, int settlingTime_ms,
 
 bool LinearColorSmoothing::selectConfig(unsigned cfg, bool force)
 {
+	QMutexLocker lock(&_stateMutex);
+
 	if (_currentConfigId == cfg && !force)
 	{
 		//Debug( _log, "selectConfig SAME as before, not FORCED - _currentConfigId [%u], force [%d]", cfg, force);
@@ -637,6 +769,8 @@ bool LinearColorSmoothing::selectConfig(unsigned cfg, bool force)
 	//Debug( _log, "selectConfig FORCED - _currentConfigId [%u], force [%d]", cfg, force);
 	if (cfg < static_cast<uint>(_cfgList.count()) )
 	{
+		const bool usedOutputClock = useOutputClock();
+
 		_smoothingType = _cfgList[cfg].smoothingType;
 		_settlingTime = _cfgList[cfg].settlingTime;
 		_outputDelay = _cfgList[cfg].outputDelay;
@@ -654,7 +788,8 @@ bool LinearColorSmoothing::selectConfig(unsigned cfg, bool force)
 		const floatT inv_window = _invWindow;
 
 		// For decay != 1 use power-based approach for calculating the moving average values
-		if(std::abs(decay - 1.0F) > std::numeric_limits<float>::epsilon()) {
+		_linearWeighting = std::abs(decay - 1.0F) <= std::numeric_limits<float>::epsilon();
+		if(!_linearWeighting) {
 			// Exponential Decay
 			_weightFrame = [inv_window,decay](const int64_t fs, const int64_t fe, const int64_t ws) {
 				const floatT s = (fs - ws) * inv_window;
@@ -676,16 +811,18 @@ bool LinearColorSmoothing::selectConfig(unsigned cfg, bool force)
 		_renderedStatCounter = 0;
 		_interpolationCounter = 0;
 		_interpolationStatCounter = 0;
+		_jitterSum = 0;
+		_jitterMax = 0;
 
-		if (_cfgList[cfg].updateInterval != _updateInterval)
+		const int previousInterval = _updateInterval;
+		_updateInterval = _cfgList[cfg].updateInterval;
+		if (_updateInterval != previousInterval || useOutputClock() != usedOutputClock)
 		{
-
-			QMetaObject::invokeMethod(_timer, "stop", Qt::QueuedConnection);
-			_updateInterval = _cfgList[cfg].updateInterval;
+			stopUpdates();
 			if (this->enabled() && this->_writeToLedsEnable)
 			{
 				//Debug( _log, "_cfgList[cfg].updateInterval != _updateInterval - Restart timer - _updateInterval [%d]", _updateInterval);
-				QMetaObject::invokeMethod(_timer, "start", Qt::QueuedConnection, Q_ARG(int, _updateInterval));
+				startUpdates();
 			}
 			else
 			{
@@ -707,3 +844,164 @@ bool LinearColorSmoothing::selectConfig(unsigned cfg, bool force)
 	_currentConfigId = 0;
 	return false;
 }
+
+QJsonObject LinearColorSmoothing::getStatistics() const
+{
+	QMutexLocker lock(&_statisticsMutex);
+	return _statistics;
+}
+
+QJsonObject LinearColorSmoothing::getIdleStatistics() const
+{
+	const int64_t now = micros();
+
+	QMutexLocker lock(&_statisticsMutex);
+	const int64_t idleTime = _idleTime + (_idleSince != 0 ? now - _idleSince : 0);
+
+	QJsonObject idle;
+	idle["smoothingIdle"] = _idleSince != 0;
+	idle["smoothingIdleTime"] = static_cast<double>(idleTime / 1000);
+	return idle;
+}
+
+void LinearColorSmoothing::startUpdates()
+{
+	if (useOutputClock())
+	{
+		QMetaObject::invokeMethod(_timer, "stop", Qt::QueuedConnection);
+		{
+			std::lock_guard<std::mutex> lock(_clockMutex);
+			_clockActive = true;
+		}
+		if (_clockThread.joinable())
+		{
+			_clockCondition.notify_one();
+		}
+		else
+		{
+			_clockThread = std::thread(&LinearColorSmoothing::runOutputClock, this);
+		}
+	}
+	else
+	{
+		_clockActive = false;
+		QMetaObject::invokeMethod(_timer, "start", Qt::QueuedConnection, Q_ARG(int, _updateInterval));
+	}
+}
+
+void LinearColorSmoothing::stopUpdates()
+{
+	// the output clock thread finishes a pending update and waits for the next activation
+	_clockActive = false;
+	QMetaObject::invokeMethod(_timer, "stop", Qt::QueuedConnection);
+}
+
+int64_t LinearColorSmoothing::nextDeadline() const
+{
+	const int64_t writeTarget = _previousWriteTime + _outputIntervalMicros;
+	const int64_t interpolationTarget = _previousInterpolationTime + _interpolationIntervalMicros;
+
+	// an interpolation is not performed while the colors are settled, it will be done with the next write
+	if (interpolationTarget > micros())
+	{
+		return std::min(writeTarget, interpolationTarget);
+	}
+	return writeTarget;
+}
+
+void LinearColorSmoothing::parkUpdates(const int64_t now)
+{
+	// the settled colors have to pass the output queue to reach the device
+	if (++_settledUpdates <= _outputDelay)
+	{
+		return;
+	}
+
+	stopUpdates();
+
+	QMutexLocker lock(&_statisticsMutex);
+	if (_idleSince == 0)
+	{
+		_idleSince = now;
+	}
+}
+
+void LinearColorSmoothing::wakeUpdates(const int64_t now)
+{
+	leaveIdle(now);
+
+	// move on from the parked colors, the idle period is not part of the interpolation
+	_previousWriteTime = now;
+	_previousInterpolationTime = now;
+	startUpdates();
+}
+
+void LinearColorSmoothing::leaveIdle(const int64_t now)
+{
+	QMutexLocker lock(&_statisticsMutex);
+	if (_idleSince != 0)
+	{
+		_idleTime += now - _idleSince;
+		_idleSince = 0;
+	}
+}
+
+void LinearColorSmoothing::runOutputClock()
+{
+	bool realtime = false;
+
+	while (!_clockQuit)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_clockMutex);
+			_clockCondition.wait(lock, [this]() { return _clockActive || _clockQuit; });
+		}
+
+		if (_realtimeOutput != realtime)
+		{
+			realtime = _realtimeOutput;
+#if defined(__linux__)
+			sched_param param {};
+			param.sched_priority = realtime ? OUTPUT_CLOCK_REALTIME_PRIORITY : 0;
+			const int result = pthread_setschedparam(pthread_self(), realtime ? SCHED_FIFO : SCHED_OTHER, &param);
+			if (result != 0)
+			{
+				Warning(_log, "Failed to change the scheduling of the smoothing output thread: %s", strerror(result));
+			}
+#else
+			if (realtime)
+			{
+				Warning(_log, "Real-time scheduling of the smoothing output thread is not supported on this platform");
+			}
+#endif
+		}
+
+		int64_t deadline;
+		{
+			QMutexLocker lock(&_stateMutex);
+			if (!_clockActive)
+			{
+				continue;
+			}
+			deadline = nextDeadline();
+		}
+
+		// sleep until the absolute deadline, a late wake-up does not shift the following deadlines
+#if defined(__linux__)
+		timespec until;
+		until.tv_sec = static_cast<time_t>(deadline / 1000000);
+		until.tv_nsec = static_cast<long>(deadline % 1000000) * 1000;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR)
+		{
+		}
+#else
+		std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::microseconds(deadline)));
+#endif
+
+		QMutexLocker lock(&_stateMutex);
+		if (_clockActive)
+		{
+			updateLeds();
+		}
+	}
+}
@@ -3,9 +3,15 @@
 // STL includes
 #include <vector>
 #include <deque>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 // Qt includes
 #include <QVector>
+#include <QMutex>
+#include <QJsonObject>
 
 // hyperion includes
 #include <leddevice/LedDevice.h>
@@ -21,6 +27,10 @@ class QTimer;
 class Logger;
 class Hyperion;
 
+namespace hyperion {
+	struct SmoothingKernels;
+}
+
 /// The type of smoothing to perform
 enum SmoothingType {
 	/// "Linear" smoothing algorithm
@@ -68,6 +78,13 @@ enum SmoothingType {
 ///           the average color values to the 8-bit RGB resolution of the LED-device. Effectively,
 ///           this performs diffusion of the residual errors across multiple egress frames.
 ///
+///           Output clock
+///           ============
+///           With sub-millisecond timing (update frequency above 1 kHz) the interpolation and output
+///           are clocked by a dedicated thread sleeping until absolute deadlines, independent of the
+///           load of the instance's event loop. The frames are handed to the LedDevice thread through
+///           a single slot, a frame not written yet is replaced by the newer one.
+///
 ///
 
 class LinearColorSmoothing : public QObject
@@ -81,6 +98,8 @@ public:
 	///
 	LinearColorSmoothing(const QJsonDocument &config, Hyperion *hyperion);
 
+	~LinearColorSmoothing() override;
+
 	/// LED values as input for the smoothing filter
 	///
 	/// @param ledValues The color-value per led
@@ -93,6 +112,29 @@ public:
 	bool pause() const { return _pause; }
 	bool enabled() const { return _enabled && !_pause; }
 
+	/// @return The interval at which the leds are updated (msec)
+	int getUpdateInterval() const { return _updateInterval; }
+
+	///
+	/// @brief Get the output statistics of the last period (decay smoothing only)
+	///
+	/// The jitter is the delay of a write after its deadline, a deadline is missed when the delay
+	/// is longer than the output interval (a frame was skipped).
+	///
+	/// @return renderedRate and interpolationRate (1/s), meanJitter and maxJitter (µs), deadlineMisses (total)
+	///
+	QJsonObject getStatistics() const;
+
+	///
+	/// @brief Get the time the output was parked since start
+	///
+	/// Once the written colors reached the target and no changed colors arrive, the periodic
+	/// updates are stopped until the next change (idle).
+	///
+	/// @return smoothingIdle (currently parked) and smoothingIdleTime (total, ms)
+	///
+	QJsonObject getIdleStatistics() const;
+
 	///
 	/// @brief Add a new smoothing configuration which can be used with selectConfig()
 	/// @param   settlingTime_ms       The buffer time
@@ -175,6 +217,25 @@ private:
 	/// The Qt timer object
 	QTimer *_timer;
 
+	/// Serializes the smoothing state between the instance thread and the output clock thread
+	QMutex _stateMutex;
+
+	/// The output clock thread, started on first use
+	std::thread _clockThread;
+
+	/// Wakes the output clock thread when it is activated or shall quit
+	std::mutex _clockMutex;
+	std::condition_variable _clockCondition;
+
+	/// Whether the output clock thread drives the updates instead of the timer
+	std::atomic<bool> _clockActive;
+
+	/// Whether the output clock thread shall exit
+	std::atomic<bool> _clockQuit;
+
+	/// Whether the output clock thread runs with real-time scheduling priority
+	std::atomic<bool> _realtimeOutput;
+
 	/// The timestamp at which the target data should be fully applied
 	int64_t _targetTime;
 
@@ -196,6 +257,9 @@ private:
 	/// The output queue
 	std::deque<std::vector<ColorRgb>> _outputQueue;
 
+	/// The capture times of the frames traced with the queued colors, see LatencyTracker
+	std::deque<int64_t> _outputQueueCaptureTimes;
+
 	/// A frame of led colors used for temporal smoothing
 	class REMEMBERED_FRAME
 	{
@@ -222,6 +286,13 @@ private:
 	/// The queue of temporarily remembered frames
 	std::deque<REMEMBERED_FRAME> _frameQueue;
 
+	/// Sliding window accumulator: the sum of the color components of the queued frames, each scaled by the time
+	/// in microseconds it was shown. The most recent frame is not included, as it is still being shown.
+	std::vector<uint64_t> _windowSum;
+
+	/// Whether the frame weight only depends on the time a frame was shown (decay of 1), the window sum is used then
+	bool _linearWeighting;
+
 	/// Prevent sending data to device when no intput data is sent
 	bool _writeToLedsEnable;
 
@@ -295,6 +366,42 @@ private:
 	/// Frees the LED frames that were queued for calculating the moving average.
 	void clearRememberedFrames();
 
+	/// Starts the periodic led updates, by the output clock thread or the timer
+	void startUpdates();
+
+	/// Stops the periodic led updates
+	void stopUpdates();
+
+	/// @return Whether the current configuration is clocked by the output clock thread
+	bool useOutputClock() const { return _smoothingType == SmoothingType::Decay && _updateInterval <= 0; }
+
+	/// Main loop of the output clock thread
+	void runOutputClock();
+
+	/// @return The time of the next interpolation or write, to be called after an update
+	int64_t nextDeadline() const;
+
+	/// Stops the periodic updates once the settled colors have passed the output queue
+	void parkUpdates(int64_t now);
+
+	/// Restarts the parked updates for a changed target, the interpolation starts from now
+	void wakeUpdates(int64_t now);
+
+	/// Ends the idle period started by parkUpdates()
+	void leaveIdle(int64_t now);
+
+	/// Hands the colors to the led device, directly to its thread when clocked by the output clock thread
+	///
+	/// @param ledColors The colors to write
+	/// @param captureTime The capture time of the input frame output first with these colors, 0 for none
+	void outputColors(const std::vector<ColorRgb> &ledColors, int64_t captureTime);
+
+	/// Removes the frames which were replaced before the window started and subtracts them from the window sum.
+	/// The frame clipping the window start is kept.
+	///
+	/// @param windowStart The start time of the current window
+	void expireFrames(const int64_t windowStart);
+
 	/// (Re-)Initializes the color-component vectors with given number of values.
 	///
 	/// @param ledCount The number of colors.
@@ -303,15 +410,18 @@ private:
 	/// The number of led component-values that must be held per color; i.e. size of the color vectors reds / greens / blues
 	size_t _ledCount = 0;
 
-	/// The average component colors red, green, blue of the leds
-	std::vector<floatT> meanValues;
+	/// The average component colors red, green, blue of the leds (Q16 fixed point)
+	std::vector<int32_t> meanValues;
 
-	/// The residual component errors of the leds
-	std::vector<floatT> residualErrors;
+	/// The residual component errors of the leds (Q16 fixed point)
+	std::vector<int32_t> residualErrors;
 
 	/// The accumulated led color values in 64-bit fixed point domain
 	std::vector<uint64_t> tempValues;
 
+	/// The linear, normalization and dithering kernels for this CPU
+	const hyperion::SmoothingKernels* _kernels;
+
 	/// Writes the target frame RGB data to the LED device without any interpolation.
 	void writeDirect();
 
@@ -348,6 +458,14 @@ private:
 	/// @param weight The weight to use.
 	static inline void aggregateComponents(const std::vector<ColorRgb>& colors, std::vector<uint64_t>& weighted, const floatT weight);
 
+	/// Adds the RGB components of the LED colors scaled by the given duration to the window sum.
+	/// A negative duration subtracts them, the two's complement arithmetic of uint64_t keeps the sum exact.
+	///
+	/// @param colors The LED colors to accumulate.
+	/// @param sum The target vector, that accumulates the terms.
+	/// @param duration The time in microseconds the colors were shown.
+	static inline void accumulateComponents(const std::vector<ColorRgb>& colors, std::vector<uint64_t>& sum, const int64_t duration);
+
 	/// Gets the current time in microseconds from high precision system clock.
 	inline int64_t micros() const;
 
@@ -366,6 +484,26 @@ private:
 	/// The count of frames that have been interpolated when statistics were shown previously
 	int64_t _interpolationStatCounter;
 
+	/// The sum and maximum of the write delays after their deadline in the current statistics period (µs)
+	int64_t _jitterSum;
+	int64_t _jitterMax;
+
+	/// The total number of writes delayed by more than an output interval
+	uint64_t _deadlineMisses;
+
+	/// The statistics of the last period, see getStatistics()
+	mutable QMutex _statisticsMutex;
+	QJsonObject _statistics;
+
+	/// The number of updates which wrote the settled colors, they are parked after passing the output queue
+	unsigned _settledUpdates;
+
+	/// Start of the current idle period, 0 while the updates run (µs, guarded by _statisticsMutex)
+	int64_t _idleSince;
+
+	/// The duration of the finished idle periods (µs, guarded by _statisticsMutex)
+	int64_t _idleTime;
+
 	/// Frame weighting function for finding the frame's integral value
 	///
 	/// @param frameStart The start of frame time.
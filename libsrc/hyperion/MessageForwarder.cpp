@@ -115,7 +115,7 @@ void MessageForwarder::handlePriorityChanges(quint8 priority)
 		//while (!_forwardClients.isEmpty())
 		//	delete _forwardClients.takeFirst();
 
-		hyperion::Components activeCompId = _hyperion->getPriorityInfo(priority).componentId;
+		hyperion::Components activeCompId = _hyperion->getPrioritySnapshot()->getInputInfo(priority).componentId;
 		if (activeCompId == hyperion::COMP_GRABBER || activeCompId == hyperion::COMP_V4L)
 		{
 			if ( !obj["flat"].isNull() )
@@ -14,17 +14,48 @@ MultiColorAdjustment::~MultiColorAdjustment()
 	for (ColorAdjustment * adjustment : _adjustment)
 	{
 		delete adjustment;
-		// BUG: Calling pop_back while iterating is invalid
-		_adjustment.pop_back();
 	}
+	_adjustment.clear();
 }
 
 void MultiColorAdjustment::addAdjustment(ColorAdjustment * adjustment)
 {
+	updateChannelTable(adjustment);
 	_adjustmentIds.push_back(adjustment->_id);
 	_adjustment.push_back(adjustment);
 }
 
+void MultiColorAdjustment::updateAdjustments()
+{
+	for (ColorAdjustment* adjustment : _adjustment)
+	{
+		updateChannelTable(adjustment);
+	}
+}
+
+void MultiColorAdjustment::updateChannelTable(ColorAdjustment * adjustment)
+{
+	uint8_t B_RGB = 0, B_CMY = 0, B_W = 0;
+	adjustment->_rgbTransform.getBrightnessComponents(B_RGB, B_CMY, B_W);
+
+	// same order as the weights in applyAdjustment()
+	RgbChannelAdjustment* const channels[8] = {
+		&adjustment->_rgbBlackAdjustment, &adjustment->_rgbRedAdjustment, &adjustment->_rgbGreenAdjustment, &adjustment->_rgbBlueAdjustment,
+		&adjustment->_rgbCyanAdjustment, &adjustment->_rgbMagentaAdjustment, &adjustment->_rgbYellowAdjustment, &adjustment->_rgbWhiteAdjustment
+	};
+	const uint8_t brightness[8] = { 255, B_RGB, B_RGB, B_RGB, B_CMY, B_CMY, B_CMY, B_W };
+
+	for (int channel = 0; channel < 8; ++channel)
+	{
+		for (int input = 0; input < 256; ++input)
+		{
+			uint8_t red, green, blue;
+			channels[channel]->apply(static_cast<uint8_t>(input), brightness[channel], red, green, blue);
+			adjustment->_channelTable[channel][input] = uint32_t(red) | (uint32_t(green) << 11) | (uint32_t(blue) << 22);
+		}
+	}
+}
+
 void MultiColorAdjustment::setAdjustmentForLed(const QString& id, int startLed, int endLed)
 {
 	// abort
@@ -95,6 +126,38 @@ void MultiColorAdjustment::setBacklightEnabled(bool enable)
 	}
 }
 
+inline void MultiColorAdjustment::adjustColor(ColorAdjustment * adjustment, ColorRgb & color)
+{
+	uint8_t ored   = color.red;
+	uint8_t ogreen = color.green;
+	uint8_t oblue  = color.blue;
+
+	adjustment->_rgbTransform.transform(ored,ogreen,oblue);
+
+	uint32_t nrng = (uint32_t) (255-ored)*(255-ogreen);
+	uint32_t rng  = (uint32_t) (ored)    *(255-ogreen);
+	uint32_t nrg  = (uint32_t) (255-ored)*(ogreen);
+	uint32_t rg   = (uint32_t) (ored)    *(ogreen);
+
+	uint8_t black   = nrng*(255-oblue)/65025;
+	uint8_t red     = rng *(255-oblue)/65025;
+	uint8_t green   = nrg *(255-oblue)/65025;
+	uint8_t blue    = nrng*(oblue)    /65025;
+	uint8_t cyan    = nrg *(oblue)    /65025;
+	uint8_t magenta = rng *(oblue)    /65025;
+	uint8_t yellow  = rg  *(255-oblue)/65025;
+	uint8_t white   = rg  *(oblue)    /65025;
+
+	// sum up the channel adjustments of all eight corners, the fields wrap like uint8_t
+	const uint32_t (&table)[8][256] = adjustment->_channelTable;
+	const uint32_t sum = table[0][black] + table[1][red] + table[2][green] + table[3][blue]
+			+ table[4][cyan] + table[5][magenta] + table[6][yellow] + table[7][white];
+
+	color.red   = static_cast<uint8_t>(sum);
+	color.green = static_cast<uint8_t>(sum >> 11);
+	color.blue  = static_cast<uint8_t>(sum >> 22);
+}
+
 void MultiColorAdjustment::applyAdjustment(std::vector<ColorRgb>& ledColors)
 {
 	const size_t itCnt = qMin(_ledAdjustments.size(), ledColors.size());
@@ -107,44 +170,41 @@ void MultiColorAdjustment::applyAdjustment(std::vector<ColorRgb>& ledColors)
 			// No transform set for this led (do nothing)
 			continue;
 		}
-		ColorRgb& color = ledColors[i];
-
-		uint8_t ored   = color.red;
-		uint8_t ogreen = color.green;
-		uint8_t oblue  = color.blue;
-		uint8_t B_RGB = 0, B_CMY = 0, B_W = 0;
-
-		adjustment->_rgbTransform.transform(ored,ogreen,oblue);
-		adjustment->_rgbTransform.getBrightnessComponents(B_RGB, B_CMY, B_W);
-
-		uint32_t nrng = (uint32_t) (255-ored)*(255-ogreen);
-		uint32_t rng  = (uint32_t) (ored)    *(255-ogreen);
-		uint32_t nrg  = (uint32_t) (255-ored)*(ogreen);
-		uint32_t rg   = (uint32_t) (ored)    *(ogreen);
-
-		uint8_t black   = nrng*(255-oblue)/65025;
-		uint8_t red     = rng *(255-oblue)/65025;
-		uint8_t green   = nrg *(255-oblue)/65025;
-		uint8_t blue    = nrng*(oblue)    /65025;
-		uint8_t cyan    = nrg *(oblue)    /65025;
-		uint8_t magenta = rng *(oblue)    /65025;
-		uint8_t yellow  = rg  *(255-oblue)/65025;
-		uint8_t white   = rg  *(oblue)    /65025;
-
-		uint8_t OR, OG, OB, RR, RG, RB, GR, GG, GB, BR, BG, BB;
-		uint8_t CR, CG, CB, MR, MG, MB, YR, YG, YB, WR, WG, WB;
-
-		adjustment->_rgbBlackAdjustment.apply  (black  , 255  , OR, OG, OB);
-		adjustment->_rgbRedAdjustment.apply    (red    , B_RGB, RR, RG, RB);
-		adjustment->_rgbGreenAdjustment.apply  (green  , B_RGB, GR, GG, GB);
-		adjustment->_rgbBlueAdjustment.apply   (blue   , B_RGB, BR, BG, BB);
-		adjustment->_rgbCyanAdjustment.apply   (cyan   , B_CMY, CR, CG, CB);
-		adjustment->_rgbMagentaAdjustment.apply(magenta, B_CMY, MR, MG, MB);
-		adjustment->_rgbYellowAdjustment.apply (yellow , B_CMY, YR, YG, YB);
-		adjustment->_rgbWhiteAdjustment.apply  (white  , B_W  , WR, WG, WB);
-
-		color.red   = OR + RR + GR + BR + CR + MR + YR + WR;
-		color.green = OG + RG + GG + BG + CG + MG + YG + WG;
-		color.blue  = OB + RB + GB + BB + CB + MB + YB + WB;
+		adjustColor(adjustment, ledColors[i]);
+	}
+}
+
+void MultiColorAdjustment::applyAdjustment(std::vector<ColorRgb>& ledColors, const std::vector<ColorOrderRun>& colorOrderRuns)
+{
+	const size_t itCnt = qMin(_ledAdjustments.size(), ledColors.size());
+	for (const ColorOrderRun& run : colorOrderRuns)
+	{
+		const size_t end = qMin(run.end, itCnt);
+		if (run.isIdentity())
+		{
+			for (size_t i=run.begin; i<end; ++i)
+			{
+				if (_ledAdjustments[i] != nullptr)
+				{
+					adjustColor(_ledAdjustments[i], ledColors[i]);
+				}
+			}
+		}
+		else
+		{
+			for (size_t i=run.begin; i<end; ++i)
+			{
+				ColorRgb& color = ledColors[i];
+				if (_ledAdjustments[i] != nullptr)
+				{
+					adjustColor(_ledAdjustments[i], color);
+				}
+
+				const uint8_t channels[3] = { color.red, color.green, color.blue };
+				color.red   = channels[run.channel[0]];
+				color.green = channels[run.channel[1]];
+				color.blue  = channels[run.channel[2]];
+			}
+		}
 	}
 }
@@ -1,5 +1,7 @@
 // STL includes
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <limits>
 
 // qt incl
@@ -12,9 +14,14 @@
 
 // utils
 #include <utils/Logger.h>
+#include <utils/LatencyTracker.h>
+#include <utils/Tracer.h>
 
 const int PriorityMuxer::LOWEST_PRIORITY = std::numeric_limits<uint8_t>::max();
 
+/// Deadlines kept beyond the number of inputs before the outdated ones are dropped
+const size_t OUTDATED_DEADLINES_MAX = 64;
+
 PriorityMuxer::PriorityMuxer(int ledCount, QObject * parent)
 	: QObject(parent)
 	, _log(Logger::getInstance("HYPERION"))
@@ -24,9 +31,17 @@ PriorityMuxer::PriorityMuxer(int ledCount, QObject * parent)
 	, _activeInputs()
 	, _lowestPriorityInfo()
 	, _sourceAutoSelectEnabled(true)
-	, _updateTimer(new QTimer(this))
+	, _enabled(true)
+	, _deadlines()
+	, _timeoutTimer(new QTimer(this))
+	, _armedDeadline(0)
 	, _timer(new QTimer(this))
-	, _blockTimer(new QTimer(this))
+	, _snapshot()
+	, _currentSnapshot()
+	, _spareSnapshot()
+	, _spareInputs()
+	, _changedInputs()
+	, _snapshotOutdated(true)
 {
 	// init lowest priority info
 	_lowestPriorityInfo.priority       = PriorityMuxer::LOWEST_PRIORITY;
@@ -35,21 +50,21 @@ PriorityMuxer::PriorityMuxer(int ledCount, QObject * parent)
 	_lowestPriorityInfo.componentId    = hyperion::COMP_COLOR;
 	_lowestPriorityInfo.origin         = "System";
 	_lowestPriorityInfo.owner          = "";
+	_lowestPriorityInfo.captureTime    = 0;
 
 	_activeInputs[PriorityMuxer::LOWEST_PRIORITY] = _lowestPriorityInfo;
+	publishSnapshot();
 
-	// adapt to 1s interval for COLOR and EFFECT timeouts > -1
+	// 1s interval for COLOR and EFFECT timeouts > -1
 	connect(_timer, &QTimer::timeout, this, &PriorityMuxer::timeTrigger);
-	_timer->setSingleShot(true);
-	_blockTimer->setSingleShot(true);
-	// forward timeRunner signal to prioritiesChanged signal & threading workaround
+	_timer->setInterval(1000);
+	// forward timeRunner signal to prioritiesChanged signal
 	connect(this, &PriorityMuxer::timeRunner, this, &PriorityMuxer::prioritiesChanged);
-	connect(this, &PriorityMuxer::signalTimeTrigger, this, &PriorityMuxer::timeTrigger);
 
-	// start muxer timer
-	connect(_updateTimer, &QTimer::timeout, this, &PriorityMuxer::setCurrentTime);
-	_updateTimer->setInterval(250);
-	_updateTimer->start();
+	// the timeout timer is armed for the next deadline only
+	connect(_timeoutTimer, &QTimer::timeout, this, &PriorityMuxer::handleTimeouts);
+	_timeoutTimer->setSingleShot(true);
+	_timeoutTimer->setTimerType(Qt::PreciseTimer);
 }
 
 PriorityMuxer::~PriorityMuxer()
@@ -58,7 +73,22 @@ PriorityMuxer::~PriorityMuxer()
 
 void PriorityMuxer::setEnable(bool enable)
 {
-	enable ? _updateTimer->start() : _updateTimer->stop();
+	_enabled = enable;
+	if (enable)
+	{
+		handleTimeouts();
+
+		// resume the time runner of a running effect or color
+		for (const InputInfo& input : _activeInputs)
+		{
+			startTimeRunner(input);
+		}
+	}
+	else
+	{
+		_timeoutTimer->stop();
+		_timer->stop();
+	}
 }
 
 bool PriorityMuxer::setSourceAutoSelectEnabled(bool enable, bool update)
@@ -73,11 +103,14 @@ bool PriorityMuxer::setSourceAutoSelectEnabled(bool enable, bool update)
 		}
 
 		_sourceAutoSelectEnabled = enable;
+		_snapshotOutdated = true;
 		Debug(_log, "Source auto select is now %s", enable ? "enabled" : "disabled");
 
 		// update _currentPriority if called from external
 		if(update)
 			setCurrentTime();
+		else
+			publishSnapshot();
 
 		return true;
 	}
@@ -103,9 +136,11 @@ void PriorityMuxer::updateLedColorsLength(int ledCount)
 		if (infoIt->ledColors.size() >= 1)
 		{
 			infoIt->ledColors.resize(ledCount, infoIt->ledColors.at(0));
+			inputChanged(infoIt->priority);
 		}
 		++infoIt;
 	}
+	publishSnapshot();
 }
 
 QList<int> PriorityMuxer::getPriorities() const
@@ -149,12 +184,17 @@ void PriorityMuxer::registerInput(int priority, hyperion::Components component,
 		reusedInput = true;
 
 	InputInfo& input     = _activeInputs[priority];
+	// a new component of an active input may change the visible component, e.g. color -> effect
+	const bool activeComponentChange = !newInput && input.componentId != component && input.timeoutTime_ms != -100;
 	input.priority       = priority;
 	input.timeoutTime_ms = newInput ? -100 : input.timeoutTime_ms;
+	input.captureTime    = newInput ? 0 : input.captureTime;
 	input.componentId    = component;
 	input.origin         = origin;
 	input.smooth_cfg     = smooth_cfg;
 	input.owner          = owner;
+	inputChanged(priority);
+	publishSnapshot();
 
 	if (newInput)
 	{
@@ -165,6 +205,11 @@ void PriorityMuxer::registerInput(int priority, hyperion::Components component,
 		return;
 	}
 
+	if (activeComponentChange)
+	{
+		setCurrentTime();
+	}
+
 	if (reusedInput)
 	{
 		emit timeRunner();
@@ -197,9 +242,17 @@ bool PriorityMuxer::setInput(int priority, const std::vector<ColorRgb>& ledColor
 		activeChange = true;
 	}
 	// update input
-	input.timeoutTime_ms = timeout_ms;
+	if (input.timeoutTime_ms != timeout_ms)
+	{
+		input.timeoutTime_ms = timeout_ms;
+		scheduleTimeout(priority, timeout_ms);
+	}
 	input.ledColors      = ledColors;
 	input.image.clear();
+	input.captureTime    = LatencyTracker::now();
+	startTimeRunner(input);
+	inputChanged(priority);
+	publishSnapshot();
 
 	// emit active change
 	if(activeChange)
@@ -217,6 +270,8 @@ bool PriorityMuxer::setInput(int priority, const std::vector<ColorRgb>& ledColor
 
 bool PriorityMuxer::setInputImage(int priority, const Image<ColorRgb>& image, int64_t timeout_ms)
 {
+	TRACE_SCOPE("muxer.setInputImage");
+
 	if(!_activeInputs.contains(priority))
 	{
 		Error(_log,"setInputImage() used without registerInput() for priority '%d', probably the priority reached timeout",priority);
@@ -241,9 +296,17 @@ bool PriorityMuxer::setInputImage(int priority, const Image<ColorRgb>& image, in
 		activeChange = true;
 	}
 	// update input
-	input.timeoutTime_ms = timeout_ms;
+	if (input.timeoutTime_ms != timeout_ms)
+	{
+		input.timeoutTime_ms = timeout_ms;
+		scheduleTimeout(priority, timeout_ms);
+	}
 	input.image          = image;
 	input.ledColors.clear();
+	input.captureTime    = image.captureTime() != 0 ? image.captureTime() : LatencyTracker::now();
+	startTimeRunner(input);
+	inputChanged(priority);
+	publishSnapshot();
 
 	// emit active change
 	if(activeChange)
@@ -268,6 +331,7 @@ bool PriorityMuxer::clearInput(int priority)
 	if (priority < PriorityMuxer::LOWEST_PRIORITY && _activeInputs.remove(priority))
 	{
 		Debug(_log,"Removed source priority %d",priority);
+		_snapshotOutdated = true;
 		// on clear success update _currentPriority
 		setCurrentTime();
 		// emit 'prioritiesChanged' only if _sourceAutoSelectEnabled is false
@@ -286,6 +350,8 @@ void PriorityMuxer::clearAll(bool forceClearAll)
 		_activeInputs.clear();
 		_currentPriority = PriorityMuxer::LOWEST_PRIORITY;
 		_activeInputs[_currentPriority] = _lowestPriorityInfo;
+		inputChanged(_currentPriority);
+		publishSnapshot();
 	}
 	else
 	{
@@ -306,6 +372,7 @@ void PriorityMuxer::setCurrentTime()
 	int newPriority;
 	_activeInputs.contains(0) ? newPriority = 0 : newPriority = PriorityMuxer::LOWEST_PRIORITY;
 
+	bool timedOut = false;
 	for (auto infoIt = _activeInputs.begin(); infoIt != _activeInputs.end();)
 	{
 		if (infoIt->timeoutTime_ms > 0 && infoIt->timeoutTime_ms <= now)
@@ -313,7 +380,7 @@ void PriorityMuxer::setCurrentTime()
 			int tPrio = infoIt->priority;
 			infoIt = _activeInputs.erase(infoIt);
 			Debug(_log,"Timeout clear for priority %d",tPrio);
-			emit prioritiesChanged();
+			timedOut = true;
 		}
 		else
 		{
@@ -321,10 +388,6 @@ void PriorityMuxer::setCurrentTime()
 			if(infoIt->timeoutTime_ms > -100)
 				newPriority = qMin(newPriority, infoIt->priority);
 
-			// call timeTrigger when effect or color is running with timeout > 0, blacklist prio 255
-			if(infoIt->priority < 254 && infoIt->timeoutTime_ms > 0 && (infoIt->componentId == hyperion::COMP_EFFECT || infoIt->componentId == hyperion::COMP_COLOR  || infoIt->componentId == hyperion::COMP_IMAGE))
-				emit signalTimeTrigger(); // as signal to prevent Threading issues
-
 			++infoIt;
 		}
 	}
@@ -344,10 +407,22 @@ void PriorityMuxer::setCurrentTime()
 	}
 	// apply & emit on change (after apply!)
 	hyperion::Components comp = getComponentOfPriority(newPriority);
-	if (_currentPriority != newPriority || comp != _prevVisComp)
+	const bool visibleChange = _currentPriority != newPriority || comp != _prevVisComp;
+	if (visibleChange)
 	{
 		_previousPriority = _currentPriority;
 		_currentPriority = newPriority;
+		_snapshotOutdated = true;
+	}
+	_snapshotOutdated = _snapshotOutdated || timedOut;
+	publishSnapshot();
+
+	if (timedOut)
+	{
+		emit prioritiesChanged();
+	}
+	if (visibleChange)
+	{
 		Debug(_log, "Set visible priority to %d", newPriority);
 		emit visiblePriorityChanged(newPriority);
 		// check for visible comp change
@@ -362,13 +437,216 @@ void PriorityMuxer::setCurrentTime()
 
 void PriorityMuxer::timeTrigger()
 {
-	if(_blockTimer->isActive())
+	// continue while an effect or color with timeout > 0 is running
+	for (const InputInfo& input : _activeInputs)
+	{
+		if (isTimedInput(input))
+		{
+			emit timeRunner();
+			return;
+		}
+	}
+	_timer->stop();
+}
+
+void PriorityMuxer::handleTimeouts()
+{
+	if (!_enabled)
+	{
+		return;
+	}
+
+	setCurrentTime();
+	armTimeoutTimer();
+}
+
+void PriorityMuxer::scheduleTimeout(int priority, int64_t timeout_ms)
+{
+	if (timeout_ms <= 0)
+	{
+		return;
+	}
+
+	// inputs updated with a new timeout per frame leave a deadline each, drop them from time to time
+	if (_deadlines.size() > static_cast<size_t>(_activeInputs.size()) + OUTDATED_DEADLINES_MAX)
+	{
+		_deadlines.clear();
+		for (const InputInfo& input : _activeInputs)
+		{
+			if (input.timeoutTime_ms > 0 && input.priority != priority)
+			{
+				_deadlines.emplace_back(input.timeoutTime_ms, input.priority);
+			}
+		}
+		std::make_heap(_deadlines.begin(), _deadlines.end(), std::greater<std::pair<int64_t, int>>());
+	}
+
+	_deadlines.emplace_back(timeout_ms, priority);
+	std::push_heap(_deadlines.begin(), _deadlines.end(), std::greater<std::pair<int64_t, int>>());
+
+	if (_enabled && (!_timeoutTimer->isActive() || timeout_ms < _armedDeadline))
+	{
+		armTimeoutTimer();
+	}
+}
+
+void PriorityMuxer::armTimeoutTimer()
+{
+	while (!_deadlines.empty())
+	{
+		const std::pair<int64_t, int>& next = _deadlines.front();
+		const auto inputIt = _activeInputs.constFind(next.second);
+		if (inputIt != _activeInputs.constEnd() && inputIt->timeoutTime_ms == next.first)
+		{
+			break;
+		}
+		std::pop_heap(_deadlines.begin(), _deadlines.end(), std::greater<std::pair<int64_t, int>>());
+		_deadlines.pop_back();
+	}
+
+	if (_deadlines.empty())
 	{
-		_timer->start(500);
+		_timeoutTimer->stop();
+		return;
+	}
+
+	_armedDeadline = _deadlines.front().first;
+	const int64_t remaining = _armedDeadline - QDateTime::currentMSecsSinceEpoch();
+	_timeoutTimer->start(static_cast<int>(qBound<int64_t>(0, remaining, std::numeric_limits<int>::max())));
+}
+
+void PriorityMuxer::startTimeRunner(const InputInfo& input)
+{
+	if (_enabled && isTimedInput(input) && !_timer->isActive())
+	{
+		_timer->start();
+	}
+}
+
+bool PriorityMuxer::isTimedInput(const InputInfo& input)
+{
+	// blacklist prio 255
+	return input.priority < 254 && input.timeoutTime_ms > 0 && (input.componentId == hyperion::COMP_EFFECT || input.componentId == hyperion::COMP_COLOR || input.componentId == hyperion::COMP_IMAGE);
+}
+
+void PriorityMuxer::inputChanged(int priority)
+{
+	if (std::find(_changedInputs.begin(), _changedInputs.end(), priority) == _changedInputs.end())
+	{
+		_changedInputs.push_back(priority);
+	}
+	_snapshotOutdated = true;
+}
+
+void PriorityMuxer::publishSnapshot()
+{
+	if (!_snapshotOutdated)
+	{
+		return;
+	}
+
+	TRACE_SCOPE("muxer.publishSnapshot");
+
+	// reuse the previous snapshot once the readers released it, usually the case between two frames
+	std::shared_ptr<Snapshot> snapshot;
+	if (_spareSnapshot && _spareSnapshot.use_count() == 1)
+	{
+		// synchronize with the release of the last reader before writing into it
+		std::atomic_thread_fence(std::memory_order_acquire);
+		snapshot = std::move(_spareSnapshot);
+		_spareInputs.swap(snapshot->_inputs);
 	}
 	else
 	{
-		emit timeRunner();
-		_blockTimer->start(1000);
+		snapshot = std::make_shared<Snapshot>();
+		snapshot->_lowestPriorityInfo = std::make_shared<InputInfo>(_lowestPriorityInfo);
+	}
+	_spareSnapshot.reset();
+	snapshot->_inputs.clear();
+
+	snapshot->currentPriority = _currentPriority;
+	snapshot->previousPriority = _previousPriority;
+	snapshot->sourceAutoSelectEnabled = _sourceAutoSelectEnabled;
+
+	// both lists are ordered by priority like _activeInputs
+	static const std::vector<std::shared_ptr<InputInfo>> noInputs;
+	const std::vector<std::shared_ptr<InputInfo>>& currentInputs = _currentSnapshot ? _currentSnapshot->_inputs : noInputs;
+	auto currentIt = currentInputs.begin();
+	auto spareIt = _spareInputs.begin();
+
+	for (auto infoIt = _activeInputs.constBegin(); infoIt != _activeInputs.constEnd(); ++infoIt)
+	{
+		const int priority = infoIt.key();
+		while (currentIt != currentInputs.end() && (*currentIt)->priority < priority)
+		{
+			++currentIt;
+		}
+		while (spareIt != _spareInputs.end() && (*spareIt)->priority < priority)
+		{
+			++spareIt;
+		}
+
+		const bool changed = std::find(_changedInputs.begin(), _changedInputs.end(), priority) != _changedInputs.end();
+		if (!changed && currentIt != currentInputs.end() && (*currentIt)->priority == priority)
+		{
+			// unchanged channels are shared with the current snapshot
+			snapshot->_inputs.push_back(*currentIt);
+		}
+		else if (spareIt != _spareInputs.end() && (*spareIt)->priority == priority && spareIt->use_count() == 1)
+		{
+			// overwrite the outdated channel of the reused snapshot, keeps the capacity of the led colors
+			std::atomic_thread_fence(std::memory_order_acquire);
+			**spareIt = infoIt.value();
+			snapshot->_inputs.push_back(std::move(*spareIt));
+		}
+		else
+		{
+			snapshot->_inputs.push_back(std::make_shared<InputInfo>(infoIt.value()));
+		}
+	}
+	_spareInputs.clear();
+	_changedInputs.clear();
+	_snapshotOutdated = false;
+
+	std::atomic_store(&_snapshot, SnapshotPtr(snapshot));
+	_spareSnapshot = std::move(_currentSnapshot);
+	_currentSnapshot = std::move(snapshot);
+}
+
+bool PriorityMuxer::Snapshot::hasPriority(int priority) const
+{
+	if (priority == PriorityMuxer::LOWEST_PRIORITY)
+	{
+		return true;
+	}
+	const auto it = std::lower_bound(_inputs.begin(), _inputs.end(), priority,
+		[](const std::shared_ptr<InputInfo>& input, int value) { return input->priority < value; });
+	return it != _inputs.end() && (*it)->priority == priority;
+}
+
+QList<int> PriorityMuxer::Snapshot::getPriorities() const
+{
+	QList<int> priorities;
+	for (const std::shared_ptr<InputInfo>& input : _inputs)
+	{
+		priorities.append(input->priority);
+	}
+	return priorities;
+}
+
+const PriorityMuxer::InputInfo& PriorityMuxer::Snapshot::getInputInfo(int priority) const
+{
+	const auto byPriority = [](const std::shared_ptr<InputInfo>& input, int value) { return input->priority < value; };
+
+	auto it = std::lower_bound(_inputs.begin(), _inputs.end(), priority, byPriority);
+	if (it == _inputs.end() || (*it)->priority != priority)
+	{
+		it = std::lower_bound(_inputs.begin(), _inputs.end(), PriorityMuxer::LOWEST_PRIORITY, byPriority);
+		if (it == _inputs.end() || (*it)->priority != PriorityMuxer::LOWEST_PRIORITY)
+		{
+			// fallback
+			return *_lowestPriorityInfo;
+		}
 	}
+	return **it;
 }
@@ -0,0 +1,109 @@
+#include <hyperion/SharedFrameStage.h>
+
+#include <QMutexLocker>
+
+using namespace hyperion;
+
+constexpr size_t SharedFrameStage::CAPACITY;
+
+std::shared_ptr<SharedFrameStage::Frame> SharedFrameStage::frame(const Image<ColorRgb>& image)
+{
+	std::shared_ptr<Frame> entry;
+	std::shared_ptr<Frame> evicted;
+	{
+		QMutexLocker lock(&_mutex);
+
+		for (const std::shared_ptr<Frame>& known : _frames)
+		{
+			const Image<ColorRgb>& knownImage = known->image;
+			if (knownImage.memptr() == image.memptr() && knownImage.width() == image.width() && knownImage.height() == image.height())
+			{
+				return known;
+			}
+		}
+
+		entry = std::make_shared<Frame>();
+		entry->image = image;
+		_frames.insert(_frames.begin(), entry);
+
+		if (_frames.size() > CAPACITY)
+		{
+			evicted = std::move(_frames.back());
+			_frames.pop_back();
+		}
+	}
+
+	if (evicted)
+	{
+		// keep the table of the oldest frame for the next one, unless an instance still reads it
+		std::shared_ptr<IntegralImage> integral;
+		{
+			QMutexLocker frameLock(&evicted->mutex);
+			integral = std::move(evicted->integral);
+		}
+		if (integral && integral.use_count() == 1)
+		{
+			QMutexLocker lock(&_mutex);
+			if (_spareIntegrals.size() < CAPACITY)
+			{
+				_spareIntegrals.push_back(std::move(integral));
+			}
+		}
+	}
+
+	return entry;
+}
+
+BlackBorder SharedFrameStage::blackBorder(const Image<ColorRgb>& image, const QString& detectionKey, const std::function<BlackBorder()>& detect)
+{
+	const std::shared_ptr<Frame> entry = frame(image);
+
+	QMutexLocker lock(&entry->mutex);
+	for (const auto& border : entry->borders)
+	{
+		if (border.first == detectionKey)
+		{
+			++_hits;
+			return border.second;
+		}
+	}
+
+	++_misses;
+	const BlackBorder border = detect();
+	entry->borders.emplace_back(detectionKey, border);
+	return border;
+}
+
+std::shared_ptr<const IntegralImage> SharedFrameStage::integralImage(const Image<ColorRgb>& image)
+{
+	const std::shared_ptr<Frame> entry = frame(image);
+
+	QMutexLocker lock(&entry->mutex);
+	if (entry->integral)
+	{
+		++_hits;
+	}
+	else
+	{
+		++_misses;
+		{
+			QMutexLocker spareLock(&_mutex);
+			if (!_spareIntegrals.empty())
+			{
+				entry->integral = std::move(_spareIntegrals.back());
+				_spareIntegrals.pop_back();
+			}
+		}
+		if (!entry->integral)
+		{
+			entry->integral = std::make_shared<IntegralImage>();
+		}
+		entry->integral->update(image);
+	}
+
+	if (!entry->integral->valid())
+	{
+		return nullptr;
+	}
+	return entry->integral;
+}
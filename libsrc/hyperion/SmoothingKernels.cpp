@@ -0,0 +1,285 @@
+#include "SmoothingKernels.h"
+
+#include <utils/CpuFeatures.h>
+
+#include <cstdlib>
+
+#if defined(HYPERION_SIMD_X86)
+	#include <emmintrin.h>
+#elif defined(HYPERION_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
+using namespace hyperion;
+
+namespace {
+
+/// Q16 value of a half 8-bit step, for rounding
+const int32_t HALF = 1 << 15;
+
+// The scalar kernels define the results, the vectorized ones process the bulk of the array
+// and leave the remainder to them.
+
+void linearStepScalar(uint8_t* previous, const uint8_t* target, size_t count, uint32_t k)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int diff = target[i] - previous[i];
+		const uint32_t step = (static_cast<uint32_t>(std::abs(diff)) * k + 0xFFFF) >> 16;
+		previous[i] = static_cast<uint8_t>(diff < 0 ? previous[i] - step : previous[i] + step);
+	}
+}
+
+// round(x) = floor(x + 0.5) for x >= 0, computed as (trunc(2x) + 1) / 2, which needs no further
+// floating point operation after the (exact) multiplication by 2 that could be fused differently
+void normalizeScalar(const uint64_t* sums, int32_t* mean, size_t count, unsigned shift, float scale)
+{
+	const float scale2 = 2.0F * scale;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int32_t doubled = static_cast<int32_t>(static_cast<float>(static_cast<int32_t>(sums[i] >> shift)) * scale2);
+		mean[i] = (doubled + 1) >> 1;
+	}
+}
+
+inline uint8_t clampComponent(int32_t value)
+{
+	return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+void ditherScalar(const int32_t* mean, int32_t* residual, uint8_t* out, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int32_t value = mean[i] + residual[i];
+		const uint8_t component = clampComponent((value + HALF) >> 16);
+		out[i] = component;
+		residual[i] = value - (static_cast<int32_t>(component) << 16);
+	}
+}
+
+void roundScalar(const int32_t* mean, uint8_t* out, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		out[i] = clampComponent((mean[i] + HALF) >> 16);
+	}
+}
+
+#if defined(HYPERION_SIMD_X86)
+
+// 16 components per iteration in 16 bit lanes. ceil(d * k / 2^16) is the high half of the product
+// plus one if the low half is not zero.
+HYPERION_TARGET_SSE2 void linearStepSse2(uint8_t* previous, const uint8_t* target, size_t count, uint32_t k)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_cmpeq_epi16(zero, zero);
+	const __m128i factor = _mm_set1_epi16(static_cast<short>(k));
+
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i previous8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + i));
+		const __m128i target8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i));
+
+		__m128i result[2];
+		for (int half = 0; half < 2; ++half)
+		{
+			const __m128i prev16 = half == 0 ? _mm_unpacklo_epi8(previous8, zero) : _mm_unpackhi_epi8(previous8, zero);
+			const __m128i target16 = half == 0 ? _mm_unpacklo_epi8(target8, zero) : _mm_unpackhi_epi8(target8, zero);
+
+			const __m128i diff = _mm_sub_epi16(target16, prev16);
+			const __m128i sign = _mm_srai_epi16(diff, 15);
+			const __m128i distance = _mm_sub_epi16(_mm_xor_si128(diff, sign), sign);
+
+			const __m128i high = _mm_mulhi_epu16(distance, factor);
+			const __m128i lowNonZero = _mm_xor_si128(_mm_cmpeq_epi16(_mm_mullo_epi16(distance, factor), zero), ones);
+			const __m128i step = _mm_sub_epi16(high, lowNonZero);
+
+			result[half] = _mm_add_epi16(prev16, _mm_sub_epi16(_mm_xor_si128(step, sign), sign));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(previous + i), _mm_packus_epi16(result[0], result[1]));
+	}
+
+	linearStepScalar(previous + i, target + i, count - i, k);
+}
+
+HYPERION_TARGET_SSE2 void normalizeSse2(const uint64_t* sums, int32_t* mean, size_t count, unsigned shift, float scale)
+{
+	const __m128i shiftCount = _mm_cvtsi32_si128(static_cast<int>(shift));
+	const __m128 scale2 = _mm_set1_ps(2.0F * scale);
+	const __m128i one = _mm_set1_epi32(1);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i a = _mm_srl_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i)), shiftCount);
+		const __m128i b = _mm_srl_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i + 2)), shiftCount);
+
+		// the low 32 bits of the four sums
+		const __m128i low = _mm_unpacklo_epi64(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0)), _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0)));
+
+		const __m128i doubled = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(low), scale2));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(mean + i), _mm_srai_epi32(_mm_add_epi32(doubled, one), 1));
+	}
+
+	normalizeScalar(sums + i, mean + i, count - i, shift, scale);
+}
+
+// 8 components per iteration. The saturating packs clamp to [0, 255], the clamped values are
+// widened again for the residuals.
+HYPERION_TARGET_SSE2 void ditherSse2(const int32_t* mean, int32_t* residual, uint8_t* out, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i half = _mm_set1_epi32(HALF);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i value0 = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mean + i)),
+											 _mm_loadu_si128(reinterpret_cast<const __m128i*>(residual + i)));
+		const __m128i value1 = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mean + i + 4)),
+											 _mm_loadu_si128(reinterpret_cast<const __m128i*>(residual + i + 4)));
+
+		const __m128i rounded = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(value0, half), 16), _mm_srai_epi32(_mm_add_epi32(value1, half), 16));
+		const __m128i component8 = _mm_packus_epi16(rounded, rounded);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), component8);
+
+		const __m128i component16 = _mm_unpacklo_epi8(component8, zero);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(residual + i), _mm_sub_epi32(value0, _mm_slli_epi32(_mm_unpacklo_epi16(component16, zero), 16)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(residual + i + 4), _mm_sub_epi32(value1, _mm_slli_epi32(_mm_unpackhi_epi16(component16, zero), 16)));
+	}
+
+	ditherScalar(mean + i, residual + i, out + i, count - i);
+}
+
+HYPERION_TARGET_SSE2 void roundSse2(const int32_t* mean, uint8_t* out, size_t count)
+{
+	const __m128i half = _mm_set1_epi32(HALF);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i value0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mean + i));
+		const __m128i value1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mean + i + 4));
+
+		const __m128i rounded = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(value0, half), 16), _mm_srai_epi32(_mm_add_epi32(value1, half), 16));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(rounded, rounded));
+	}
+
+	roundScalar(mean + i, out + i, count - i);
+}
+
+#elif defined(HYPERION_SIMD_NEON)
+
+// 16 components per iteration, the products of the distance and k are widened to 32 bit.
+void linearStepNeon(uint8_t* previous, const uint8_t* target, size_t count, uint32_t k)
+{
+	const uint16x4_t factor = vdup_n_u16(static_cast<uint16_t>(k));
+	const uint32x4_t roundUp = vdupq_n_u32(0xFFFF);
+
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint8x16_t previous8 = vld1q_u8(previous + i);
+		const uint8x16_t target8 = vld1q_u8(target + i);
+		const uint8x16_t distance8 = vabdq_u8(target8, previous8);
+		const uint8x16_t up = vcgtq_u8(target8, previous8);
+
+		const uint16x8_t distanceLow = vmovl_u8(vget_low_u8(distance8));
+		const uint16x8_t distanceHigh = vmovl_u8(vget_high_u8(distance8));
+
+		const uint16x8_t stepLow = vcombine_u16(
+					vmovn_u32(vshrq_n_u32(vaddq_u32(vmull_u16(vget_low_u16(distanceLow), factor), roundUp), 16)),
+					vmovn_u32(vshrq_n_u32(vaddq_u32(vmull_u16(vget_high_u16(distanceLow), factor), roundUp), 16)));
+		const uint16x8_t stepHigh = vcombine_u16(
+					vmovn_u32(vshrq_n_u32(vaddq_u32(vmull_u16(vget_low_u16(distanceHigh), factor), roundUp), 16)),
+					vmovn_u32(vshrq_n_u32(vaddq_u32(vmull_u16(vget_high_u16(distanceHigh), factor), roundUp), 16)));
+		const uint8x16_t step = vcombine_u8(vmovn_u16(stepLow), vmovn_u16(stepHigh));
+
+		vst1q_u8(previous + i, vbslq_u8(up, vaddq_u8(previous8, step), vsubq_u8(previous8, step)));
+	}
+
+	linearStepScalar(previous + i, target + i, count - i, k);
+}
+
+void normalizeNeon(const uint64_t* sums, int32_t* mean, size_t count, unsigned shift, float scale)
+{
+	const int64x2_t shiftCount = vdupq_n_s64(-static_cast<int64_t>(shift));
+	const float scale2 = 2.0F * scale;
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const uint32x2_t a = vmovn_u64(vshlq_u64(vld1q_u64(sums + i), shiftCount));
+		const uint32x2_t b = vmovn_u64(vshlq_u64(vld1q_u64(sums + i + 2), shiftCount));
+
+		const int32x4_t doubled = vcvtq_s32_f32(vmulq_n_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(vcombine_u32(a, b))), scale2));
+		vst1q_s32(mean + i, vshrq_n_s32(vaddq_s32(doubled, vdupq_n_s32(1)), 1));
+	}
+
+	normalizeScalar(sums + i, mean + i, count - i, shift, scale);
+}
+
+void ditherNeon(const int32_t* mean, int32_t* residual, uint8_t* out, size_t count)
+{
+	const int32x4_t half = vdupq_n_s32(HALF);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const int32x4_t value0 = vaddq_s32(vld1q_s32(mean + i), vld1q_s32(residual + i));
+		const int32x4_t value1 = vaddq_s32(vld1q_s32(mean + i + 4), vld1q_s32(residual + i + 4));
+
+		const int16x8_t rounded = vcombine_s16(vqmovn_s32(vshrq_n_s32(vaddq_s32(value0, half), 16)), vqmovn_s32(vshrq_n_s32(vaddq_s32(value1, half), 16)));
+		const uint8x8_t component8 = vqmovun_s16(rounded);
+		vst1_u8(out + i, component8);
+
+		const uint16x8_t component16 = vmovl_u8(component8);
+		vst1q_s32(residual + i, vsubq_s32(value0, vshlq_n_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(component16))), 16)));
+		vst1q_s32(residual + i + 4, vsubq_s32(value1, vshlq_n_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(component16))), 16)));
+	}
+
+	ditherScalar(mean + i, residual + i, out + i, count - i);
+}
+
+void roundNeon(const int32_t* mean, uint8_t* out, size_t count)
+{
+	const int32x4_t half = vdupq_n_s32(HALF);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const int16x8_t rounded = vcombine_s16(vqmovn_s32(vshrq_n_s32(vaddq_s32(vld1q_s32(mean + i), half), 16)),
+											   vqmovn_s32(vshrq_n_s32(vaddq_s32(vld1q_s32(mean + i + 4), half), 16)));
+		vst1_u8(out + i, vqmovun_s16(rounded));
+	}
+
+	roundScalar(mean + i, out + i, count - i);
+}
+
+#endif
+
+const SmoothingKernels SCALAR_KERNELS = { linearStepScalar, normalizeScalar, ditherScalar, roundScalar, "scalar" };
+
+} // namespace
+
+std::vector<SmoothingKernels> hyperion::availableSmoothingKernels()
+{
+	std::vector<SmoothingKernels> kernels { SCALAR_KERNELS };
+#if defined(HYPERION_SIMD_X86)
+	if (CpuFeatures::hasSSE2())
+	{
+		kernels.push_back({ linearStepSse2, normalizeSse2, ditherSse2, roundSse2, "sse2" });
+	}
+#elif defined(HYPERION_SIMD_NEON)
+	kernels.push_back({ linearStepNeon, normalizeNeon, ditherNeon, roundNeon, "neon" });
+#endif
+	return kernels;
+}
+
+const SmoothingKernels& hyperion::smoothingKernels()
+{
+	static const SmoothingKernels kernels = availableSmoothingKernels().back();
+	return kernels;
+}
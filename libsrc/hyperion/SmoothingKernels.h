@@ -0,0 +1,76 @@
+#pragma once
+
+// STL includes
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hyperion {
+
+///
+/// Fixed-point kernels of the color smoothing, with vectorized variants selected by CPU feature.
+///
+/// The kernels work element-wise on arrays of color components (3 per led, in the byte order of
+/// ColorRgb), so they process the led colors as one flat array regardless of the channel.
+/// Mean values and residual errors are signed Q16 fixed-point (65536 = one 8-bit step).
+///
+/// All variants of a kernel produce identical results.
+///
+struct SmoothingKernels
+{
+	///
+	/// Moves each component towards its target by ceil(k * |target - previous|)
+	///
+	/// @param previous  The current components, updated in place
+	/// @param target    The target components
+	/// @param count     The number of components
+	/// @param k         The fraction of the distance to move in Q16, [0, 65535]
+	///
+	void (*linearStep)(uint8_t* previous, const uint8_t* target, size_t count, uint32_t k);
+
+	///
+	/// Converts accumulated component sums into Q16 mean values: mean = round((sum >> shift) * scale)
+	///
+	/// @param sums   The accumulated sums, (sum >> shift) must be below 2^31
+	/// @param mean   The resulting mean values
+	/// @param count  The number of components
+	/// @param shift  The number of bits to drop from the sums
+	/// @param scale  The factor from the shifted sum to Q16
+	///
+	void (*normalize)(const uint64_t* sums, int32_t* mean, size_t count, unsigned shift, float scale);
+
+	///
+	/// Rounds the mean values plus the residual errors of the previous frame to 8 bit components and
+	/// keeps the new rounding errors as residuals (temporal dithering)
+	///
+	/// @param mean      The Q16 mean values
+	/// @param residual  The Q16 residual errors, updated in place
+	/// @param out       The resulting components
+	/// @param count     The number of components
+	///
+	void (*dither)(const int32_t* mean, int32_t* residual, uint8_t* out, size_t count);
+
+	///
+	/// Rounds the mean values to 8 bit components
+	///
+	/// @param mean   The Q16 mean values
+	/// @param out    The resulting components
+	/// @param count  The number of components
+	///
+	void (*round)(const int32_t* mean, uint8_t* out, size_t count);
+
+	/// Name of the instruction set, e.g. for log output
+	const char* name;
+};
+
+///
+/// @brief Get the fastest kernels supported by the CPU, selected once
+///
+const SmoothingKernels& smoothingKernels();
+
+///
+/// @brief Get all kernel variants supported by the CPU, the scalar reference first (for tests)
+///
+std::vector<SmoothingKernels> availableSmoothingKernels();
+
+} // namespace hyperion
@@ -11,6 +11,7 @@
 
 #include "hyperion/Hyperion.h"
 #include <utils/JsonUtils.h>
+#include <utils/Tracer.h>
 
 //std includes
 #include <sstream>
@@ -23,7 +24,9 @@ LedDevice::LedDevice(const QJsonObject& deviceConfig, QObject* parent)
 	  , _ledBuffer(0)
 	  , _refreshTimer(nullptr)
 	  , _refreshTimerInterval_ms(0)
+	  , _keepAliveInterval_ms(0)
 	  , _latchTime_ms(0)
+	  , _latency(nullptr)
 	  , _ledCount(0)
 	  , _isRestoreOrigState(false)
 	  , _isEnabled(false)
@@ -34,6 +37,9 @@ LedDevice::LedDevice(const QJsonObject& deviceConfig, QObject* parent)
 	  , _isInSwitchOff (false)
 	  , _lastWriteTime(QDateTime::currentDateTime())
 	  , _isRefreshEnabled (false)
+	  , _isIdle (false)
+	  , _idleSince (0)
+	  , _idleTime_ms (0)
 {
 	_activeDeviceType = deviceConfig["type"].toString("UNSPECIFIED").toLower();
 }
@@ -152,6 +158,7 @@ bool LedDevice::init(const QJsonObject &deviceConfig)
 	setLedCount( deviceConfig["currentLedCount"].toInt(1) ); // property injected to reflect real led count
 	setLatchTime( deviceConfig["latchTime"].toInt( _latchTime_ms ) );
 	setRewriteTime ( deviceConfig["rewriteTime"].toInt( _refreshTimerInterval_ms) );
+	setKeepAliveTime ( deviceConfig["keepAliveTime"].toInt( _keepAliveInterval_ms) );
 
 	return true;
 }
@@ -170,16 +177,61 @@ void LedDevice::stopRefreshTimer()
 	{
 		_refreshTimer->stop();
 	}
+	setIdle(false);
+}
+
+void LedDevice::setIdle(bool idle)
+{
+	if ( idle != _isIdle )
+	{
+		_isIdle = idle;
+
+		qint64 now = QDateTime::currentMSecsSinceEpoch();
+		if ( _isIdle )
+		{
+			_idleSince = now;
+		}
+		else
+		{
+			_idleTime_ms += now - _idleSince;
+		}
+
+		if ( _refreshTimer != nullptr )
+		{
+			_refreshTimer->setInterval( _isIdle ? qMax(_keepAliveInterval_ms, _refreshTimerInterval_ms) : _refreshTimerInterval_ms );
+		}
+	}
+}
+
+qint64 LedDevice::getIdleTime() const
+{
+	qint64 idleTime = _idleTime_ms;
+	if ( _isIdle )
+	{
+		idleTime += QDateTime::currentMSecsSinceEpoch() - _idleSince;
+	}
+	return idleTime;
 }
 
 int LedDevice::updateLeds(const std::vector<ColorRgb>& ledValues)
 {
+	TRACE_SCOPE("device.update");
+
 	int retval = 0;
 	if ( !_isEnabled || !_isOn || !_isDeviceReady || _isDeviceInError )
 	{
 		//std::cout << "LedDevice::updateLeds(), LedDevice NOT ready! ";
 		retval = -1;
 	}
+	else if ( _isRefreshEnabled && _refreshTimer->isActive() && ledValues == _lastLedValues )
+	{
+		// unchanged colors are kept by the refresh cycle, a frame with these colors is shown already
+		if ( _latency != nullptr )
+		{
+			_latency->record(LatencyTracker::DEVICE, _latency->takeOver(LatencyTracker::DEVICE));
+		}
+		retval = 0;
+	}
 	else
 	{
 		qint64 elapsedTimeMs = _lastWriteTime.msecsTo( QDateTime::currentDateTime() );
@@ -189,9 +241,16 @@ int LedDevice::updateLeds(const std::vector<ColorRgb>& ledValues)
 			retval = write(ledValues);
 			_lastWriteTime = QDateTime::currentDateTime();
 
+			// a latched frame stays handed over until the write
+			if ( _latency != nullptr && retval >= 0 )
+			{
+				_latency->record(LatencyTracker::DEVICE, _latency->takeOver(LatencyTracker::DEVICE));
+			}
+
 			// if device requires refreshing, save Led-Values and restart the timer
 			if ( _isRefreshEnabled && _isEnabled )
 			{
+				setIdle(false);
 				this->startRefreshTimer();
 				_lastLedValues = ledValues;
 			}
@@ -225,6 +284,9 @@ int LedDevice::rewriteLEDs()
 
 		retval = write(_lastLedValues);
 		_lastWriteTime = QDateTime::currentDateTime();
+
+		// the colors did not change for a refresh interval, continue at the keep-alive rate
+		setIdle(true);
 	}
 	else
 	{
@@ -405,6 +467,7 @@ void LedDevice::setLatchTime( int latchTime_ms )
 	assert(latchTime_ms >= 0);
 	_latchTime_ms = latchTime_ms;
 	Debug(_log, "LatchTime updated to %dms", _latchTime_ms);
+	emit latchTimeChanged(_latchTime_ms);
 }
 
 void LedDevice::setRewriteTime( int rewriteTime_ms )
@@ -434,6 +497,14 @@ void LedDevice::setRewriteTime( int rewriteTime_ms )
 	Debug(_log, "RewriteTime updated to %dms", _refreshTimerInterval_ms);
 }
 
+void LedDevice::setKeepAliveTime( int keepAliveTime_ms )
+{
+	assert(keepAliveTime_ms >= 0);
+	_keepAliveInterval_ms = keepAliveTime_ms;
+
+	Debug(_log, "KeepAliveTime updated to %dms", _keepAliveInterval_ms);
+}
+
 void LedDevice::printLedValues(const std::vector<ColorRgb>& ledValues)
 {
 	std::cout << "LedValues [" << ledValues.size() <<"] [";
@@ -51,12 +51,21 @@ void LedDeviceWrapper::createLedDevice(const QJsonObject& config)
 	QThread* thread = new QThread(this);
 	thread->setObjectName("LedDeviceThread");
 	_ledDevice = LedDeviceFactory::construct(config);
+	_ledDevice->setLatencyTracker(_hyperion->getLatencyTracker());
 	_ledDevice->moveToThread(thread);
 	// setup thread management
 	connect(thread, &QThread::started, _ledDevice, &LedDevice::start);
 
 	// further signals
 	connect(this, &LedDeviceWrapper::updateLeds, _ledDevice, &LedDevice::updateLeds, Qt::QueuedConnection);
+	LedDevice* device = _ledDevice;
+	connect(this, &LedDeviceWrapper::ledsPublished, _ledDevice, [this, device]() {
+		const std::vector<ColorRgb>* ledValues = _publishedLeds.take();
+		if (ledValues != nullptr)
+		{
+			device->updateLeds(*ledValues);
+		}
+	}, Qt::QueuedConnection);
 
 	connect(this, &LedDeviceWrapper::enable, _ledDevice, &LedDevice::enable);
 	connect(this, &LedDeviceWrapper::disable, _ledDevice, &LedDevice::disable);
@@ -67,6 +76,7 @@ void LedDeviceWrapper::createLedDevice(const QJsonObject& config)
 	connect(this, &LedDeviceWrapper::stopLedDevice, _ledDevice, &LedDevice::stop, Qt::BlockingQueuedConnection);
 
 	connect(_ledDevice, &LedDevice::enableStateChanged, this, &LedDeviceWrapper::handleInternalEnableState, Qt::QueuedConnection);
+	connect(_ledDevice, &LedDevice::latchTimeChanged, this, &LedDeviceWrapper::latchTimeChanged, Qt::QueuedConnection);
 
 	// start the thread
 	thread->start();
@@ -130,6 +140,13 @@ int LedDeviceWrapper::getLatchTime() const
 	return value;
 }
 
+qint64 LedDeviceWrapper::getIdleTime() const
+{
+	qint64 value = 0;
+	QMetaObject::invokeMethod(_ledDevice, "getIdleTime", Qt::BlockingQueuedConnection, Q_RETURN_ARG(qint64, value));
+	return value;
+}
+
 QString LedDeviceWrapper::getActiveDeviceType() const
 {
 	QString value = 0;
@@ -151,6 +168,15 @@ unsigned int LedDeviceWrapper::getLedCount() const
 	return value;
 }
 
+void LedDeviceWrapper::publishLeds(const std::vector<ColorRgb>& ledValues)
+{
+	_publishedLeds.back() = ledValues;
+	if (_publishedLeds.publish())
+	{
+		emit ledsPublished();
+	}
+}
+
 bool LedDeviceWrapper::enabled() const
 {
 	return _enabled;
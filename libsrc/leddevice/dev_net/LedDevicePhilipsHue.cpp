@@ -95,6 +95,8 @@ const int API_SSL_SERVER_PORT = 2100;
 const int STREAM_CONNECTION_RETRYS = 5;
 const int STREAM_SSL_HANDSHAKE_ATTEMPTS = 5;
 constexpr std::chrono::milliseconds STREAM_REWRITE_TIME{20};
+// The bridge ends the streaming after 10 seconds without data, unchanged colors are resent well before
+constexpr std::chrono::milliseconds STREAM_KEEPALIVE_TIME{1000};
 const int SSL_CIPHERSUITES[2] = { MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256, 0 };
 
 } //End of constants
@@ -950,6 +952,7 @@ bool LedDevicePhilipsHue::initLeds()
 				_devConfig["sslport"]        = API_SSL_SERVER_PORT;
 				_devConfig["servername"]     = API_SSL_SERVER_NAME;
 				_devConfig["rewriteTime"]    = static_cast<int>( STREAM_REWRITE_TIME.count() );
+				_devConfig["keepAliveTime"]  = static_cast<int>( STREAM_KEEPALIVE_TIME.count() );
 				_devConfig["psk"]            = _devConfig[ CONFIG_CLIENTKEY ].toString();
 				_devConfig["psk_identity"]   = _devConfig[ CONFIG_USERNAME ].toString();
 				_devConfig["seed_custom"]    = API_SSL_SEED_CUSTOM;
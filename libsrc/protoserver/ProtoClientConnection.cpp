@@ -7,6 +7,9 @@
 #include <QTimer>
 #include <QRgb>
 
+// utils
+#include <utils/LatencyTracker.h>
+
 // TODO Remove this class if third-party apps have been migrated (eg. Hyperion Android Grabber, Windows Screen grabber etc.)
 
 ProtoClientConnection::ProtoClientConnection(QTcpSocket* socket, int timeout, QObject *parent)
@@ -174,9 +177,9 @@ void ProtoClientConnection::handleImageCommand(const proto::ImageRequest &messag
 		return;
 	}
 
-	// create ImageRgb
-	Image<ColorRgb> image(width, height);
-	memcpy(image.memptr(), imageData.c_str(), imageData.size());
+	// view of the received message, copied only if it is kept (e.g. as input of an instance)
+	Image<ColorRgb> image(reinterpret_cast<const ColorRgb*>(imageData.data()), width, height);
+	image.setCaptureTime(LatencyTracker::now());
 
 	emit setGlobalInputImage(_priority, image, duration);
 
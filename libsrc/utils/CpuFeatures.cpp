@@ -0,0 +1,124 @@
+#include <utils/CpuFeatures.h>
+
+#include <string>
+
+#if defined(HYPERION_SIMD_X86) && defined(_MSC_VER) && !defined(__clang__)
+	#include <intrin.h>
+	#include <immintrin.h>
+#endif
+
+namespace CpuFeatures {
+
+namespace {
+
+#if defined(HYPERION_SIMD_X86) && defined(_MSC_VER) && !defined(__clang__)
+	struct X86Features
+	{
+		bool sse2  = false;
+		bool ssse3 = false;
+		bool avx2  = false;
+
+		X86Features()
+		{
+			int info[4];
+			__cpuid(info, 0);
+			const int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			sse2  = (info[3] & (1 << 26)) != 0;
+			ssse3 = (info[2] & (1 << 9)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx     = (info[2] & (1 << 28)) != 0;
+
+			if (maxLeaf >= 7 && osxsave && avx)
+			{
+				// ymm state must be enabled by the OS
+				const unsigned long long xcr0 = _xgetbv(0);
+				if ((xcr0 & 0x6) == 0x6)
+				{
+					__cpuidex(info, 7, 0);
+					avx2 = (info[1] & (1 << 5)) != 0;
+				}
+			}
+		}
+	};
+
+	const X86Features& x86Features()
+	{
+		static const X86Features features;
+		return features;
+	}
+#endif
+
+} // namespace
+
+bool hasSSE2()
+{
+#if defined(HYPERION_SIMD_X86)
+	#if defined(_MSC_VER) && !defined(__clang__)
+		return x86Features().sse2;
+	#else
+		return __builtin_cpu_supports("sse2");
+	#endif
+#else
+	return false;
+#endif
+}
+
+bool hasSSSE3()
+{
+#if defined(HYPERION_SIMD_X86)
+	#if defined(_MSC_VER) && !defined(__clang__)
+		return x86Features().ssse3;
+	#else
+		return __builtin_cpu_supports("ssse3");
+	#endif
+#else
+	return false;
+#endif
+}
+
+bool hasAVX2()
+{
+#if defined(HYPERION_SIMD_X86)
+	#if defined(_MSC_VER) && !defined(__clang__)
+		return x86Features().avx2;
+	#else
+		return __builtin_cpu_supports("avx2");
+	#endif
+#else
+	return false;
+#endif
+}
+
+bool hasNEON()
+{
+#if defined(HYPERION_SIMD_NEON)
+	return true;
+#else
+	return false;
+#endif
+}
+
+const char* featureString()
+{
+	static const std::string features = []() -> std::string
+	{
+		std::string str;
+		if (hasSSE2())  { str += "sse2 "; }
+		if (hasSSSE3()) { str += "ssse3 "; }
+		if (hasAVX2())  { str += "avx2 "; }
+		if (hasNEON())  { str += "neon "; }
+
+		if (str.empty())
+		{
+			return std::string("none");
+		}
+		str.pop_back();
+		return str;
+	}();
+
+	return features.c_str();
+}
+
+} // namespace CpuFeatures
@@ -0,0 +1,106 @@
+#include <utils/ImageBufferPool.h>
+
+#include <cstdlib>
+#include <iterator>
+#include <new>
+
+#include <QMutexLocker>
+
+constexpr size_t ImageBufferPool::MIN_POOLED_BYTES;
+
+size_t ImageBufferPool::sizeClass(size_t bytes)
+{
+	if (bytes < MIN_POOLED_BYTES)
+	{
+		return bytes;
+	}
+
+	// four classes per power of two, at most 25% of a buffer are unused
+	unsigned highestBit = 0;
+	while ((bytes >> highestBit) > 1)
+	{
+		++highestBit;
+	}
+	const size_t step = size_t(1) << (highestBit - 2);
+	return (bytes + step - 1) & ~(step - 1);
+}
+
+void* ImageBufferPool::acquire(size_t bytes, size_t& capacity)
+{
+	capacity = sizeClass(bytes);
+
+	if (capacity >= MIN_POOLED_BYTES)
+	{
+		QMutexLocker lock(&_mutex);
+
+		// most recently released first, its pages are likely still resident
+		for (auto it = _free.rbegin(); it != _free.rend(); ++it)
+		{
+			if (it->capacity == capacity)
+			{
+				void* data = it->data;
+				_retainedBytes -= capacity;
+				_free.erase(std::next(it).base());
+				++_reuses;
+				return data;
+			}
+		}
+	}
+
+	void* data = std::malloc(capacity > 0 ? capacity : 1);
+	if (data == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	++_allocations;
+	return data;
+}
+
+void ImageBufferPool::release(void* buffer, size_t capacity)
+{
+	if (buffer == nullptr)
+	{
+		return;
+	}
+
+	if (capacity >= MIN_POOLED_BYTES)
+	{
+		QMutexLocker lock(&_mutex);
+		if (capacity <= _maxRetainedBytes)
+		{
+			_free.push_back(Buffer{buffer, capacity});
+			_retainedBytes += capacity;
+			trim();
+			return;
+		}
+		++_evictions;
+	}
+
+	std::free(buffer);
+}
+
+void ImageBufferPool::setMaxRetainedBytes(size_t bytes)
+{
+	QMutexLocker lock(&_mutex);
+	_maxRetainedBytes = bytes;
+	trim();
+}
+
+ImageBufferPool::Statistics ImageBufferPool::statistics() const
+{
+	QMutexLocker lock(&_mutex);
+	return Statistics{_allocations, _reuses, _evictions, _free.size(), _retainedBytes};
+}
+
+void ImageBufferPool::trim()
+{
+	size_t count = 0;
+	while (count < _free.size() && (_retainedBytes > _maxRetainedBytes || _free.size() - count > _maxRetainedBuffers))
+	{
+		std::free(_free[count].data);
+		_retainedBytes -= _free[count].capacity;
+		++_evictions;
+		++count;
+	}
+	_free.erase(_free.begin(), _free.begin() + count);
+}
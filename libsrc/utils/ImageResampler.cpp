@@ -1,7 +1,192 @@
 #include "utils/ImageResampler.h"
-#include <utils/ColorSys.h>
+#include <utils/SampleDemand.h>
 #include <utils/Logger.h>
 
+#include "ResamplerKernels.h"
+
+namespace {
+
+/// The rows of the planes of the source row to convert
+struct SourceRow
+{
+	/// The packed pixels, or the luma plane of the planar formats
+	const uint8_t * pixels;
+	/// The chroma plane of the planar formats, interleaved U and V for NV12
+	const uint8_t * chromaU;
+	/// The V plane of I420
+	const uint8_t * chromaV;
+};
+
+/// Converts count pixels of a row, from xSource on every step-th pixel
+using RowConverter = void (*)(const SourceRow & row, int xSource, int step, int count, const YuvCoefficients & matrix, ColorRgb * output);
+
+template <PixelFormat FORMAT>
+inline void convertPixel(const SourceRow & row, int x, const YuvCoefficients & matrix, ColorRgb & rgb);
+
+template <>
+inline void convertPixel<PixelFormat::YUYV>(const SourceRow & row, int x, const YuvCoefficients & matrix, ColorRgb & rgb)
+{
+	const uint8_t * pair = row.pixels + ((x >> 1) << 2);
+	yuvToRgb(matrix, pair[((x & 1) == 0) ? 0 : 2], pair[1], pair[3], rgb);
+}
+
+template <>
+inline void convertPixel<PixelFormat::UYVY>(const SourceRow & row, int x, const YuvCoefficients & matrix, ColorRgb & rgb)
+{
+	const uint8_t * pair = row.pixels + ((x >> 1) << 2);
+	yuvToRgb(matrix, pair[((x & 1) == 0) ? 1 : 3], pair[0], pair[2], rgb);
+}
+
+template <>
+inline void convertPixel<PixelFormat::BGR16>(const SourceRow & row, int x, const YuvCoefficients &, ColorRgb & rgb)
+{
+	const uint8_t * pixel = row.pixels + (x << 1);
+	rgb.blue  = (pixel[0] & 0x1f) << 3;
+	rgb.green = (((pixel[1] & 0x7) << 3) | (pixel[0] & 0xE0) >> 5) << 2;
+	rgb.red   = (pixel[1] & 0xF8);
+}
+
+template <>
+inline void convertPixel<PixelFormat::BGR24>(const SourceRow & row, int x, const YuvCoefficients &, ColorRgb & rgb)
+{
+	const uint8_t * pixel = row.pixels + (x << 1) + x;
+	rgb.blue  = pixel[0];
+	rgb.green = pixel[1];
+	rgb.red   = pixel[2];
+}
+
+template <>
+inline void convertPixel<PixelFormat::RGB32>(const SourceRow & row, int x, const YuvCoefficients &, ColorRgb & rgb)
+{
+	const uint8_t * pixel = row.pixels + (x << 2);
+	rgb.red   = pixel[0];
+	rgb.green = pixel[1];
+	rgb.blue  = pixel[2];
+}
+
+template <>
+inline void convertPixel<PixelFormat::BGR32>(const SourceRow & row, int x, const YuvCoefficients &, ColorRgb & rgb)
+{
+	const uint8_t * pixel = row.pixels + (x << 2);
+	rgb.blue  = pixel[0];
+	rgb.green = pixel[1];
+	rgb.red   = pixel[2];
+}
+
+template <>
+inline void convertPixel<PixelFormat::NV12>(const SourceRow & row, int x, const YuvCoefficients & matrix, ColorRgb & rgb)
+{
+	const uint8_t * uv = row.chromaU + (x & ~1);
+	yuvToRgb(matrix, row.pixels[x], uv[0], uv[1], rgb);
+}
+
+template <>
+inline void convertPixel<PixelFormat::I420>(const SourceRow & row, int x, const YuvCoefficients & matrix, ColorRgb & rgb)
+{
+	yuvToRgb(matrix, row.pixels[x], row.chromaU[x >> 1], row.chromaV[x >> 1], rgb);
+}
+
+template <PixelFormat FORMAT>
+void convertPixels(const SourceRow & row, int xSource, int step, int count, const YuvCoefficients & matrix, ColorRgb * output)
+{
+	for (int i = 0; i < count; ++i, xSource += step)
+	{
+		convertPixel<FORMAT>(row, xSource, matrix, output[i]);
+	}
+}
+
+template <PixelFormat FORMAT>
+void convertRow(const SourceRow & row, int xSource, int step, int count, const YuvCoefficients & matrix, ColorRgb * output)
+{
+	convertPixels<FORMAT>(row, xSource, step, count, matrix, output);
+}
+
+// consecutive pixels of the common capture formats are converted by the vectorized kernels
+
+template <>
+void convertRow<PixelFormat::YUYV>(const SourceRow & row, int xSource, int step, int count, const YuvCoefficients & matrix, ColorRgb * output)
+{
+	if (step != 1 || count <= 0)
+	{
+		convertPixels<PixelFormat::YUYV>(row, xSource, step, count, matrix, output);
+		return;
+	}
+
+	// the kernels start with a pixel pair
+	if ((xSource & 1) != 0)
+	{
+		convertPixel<PixelFormat::YUYV>(row, xSource++, matrix, *output++);
+		--count;
+	}
+	resamplerKernels().yuyvToRgb(row.pixels + (xSource << 1), output, size_t(count), matrix);
+}
+
+template <>
+void convertRow<PixelFormat::UYVY>(const SourceRow & row, int xSource, int step, int count, const YuvCoefficients & matrix, ColorRgb * output)
+{
+	if (step != 1 || count <= 0)
+	{
+		convertPixels<PixelFormat::UYVY>(row, xSource, step, count, matrix, output);
+		return;
+	}
+
+	// the kernels start with a pixel pair
+	if ((xSource & 1) != 0)
+	{
+		convertPixel<PixelFormat::UYVY>(row, xSource++, matrix, *output++);
+		--count;
+	}
+	resamplerKernels().uyvyToRgb(row.pixels + (xSource << 1), output, size_t(count), matrix);
+}
+
+template <>
+void convertRow<PixelFormat::RGB32>(const SourceRow & row, int xSource, int step, int count, const YuvCoefficients & matrix, ColorRgb * output)
+{
+	if (step != 1 || count <= 0)
+	{
+		convertPixels<PixelFormat::RGB32>(row, xSource, step, count, matrix, output);
+		return;
+	}
+
+	resamplerKernels().rgb32ToRgb(row.pixels + (xSource << 2), output, size_t(count));
+}
+
+template <>
+void convertRow<PixelFormat::BGR32>(const SourceRow & row, int xSource, int step, int count, const YuvCoefficients & matrix, ColorRgb * output)
+{
+	if (step != 1 || count <= 0)
+	{
+		convertPixels<PixelFormat::BGR32>(row, xSource, step, count, matrix, output);
+		return;
+	}
+
+	resamplerKernels().bgr32ToRgb(row.pixels + (xSource << 2), output, size_t(count));
+}
+
+/// The row converter of a format, nullptr if the resampler can not convert it
+RowConverter rowConverter(PixelFormat pixelFormat)
+{
+	switch (pixelFormat)
+	{
+		case PixelFormat::YUYV:  return convertRow<PixelFormat::YUYV>;
+		case PixelFormat::UYVY:  return convertRow<PixelFormat::UYVY>;
+		case PixelFormat::BGR16: return convertRow<PixelFormat::BGR16>;
+		case PixelFormat::BGR24: return convertRow<PixelFormat::BGR24>;
+		case PixelFormat::RGB32: return convertRow<PixelFormat::RGB32>;
+		case PixelFormat::BGR32: return convertRow<PixelFormat::BGR32>;
+		case PixelFormat::NV12:  return convertRow<PixelFormat::NV12>;
+		case PixelFormat::I420:  return convertRow<PixelFormat::I420>;
+#ifdef HAVE_JPEG_DECODER
+		case PixelFormat::MJPEG:
+#endif
+		case PixelFormat::NO_CHANGE:
+		break;
+	}
+	return nullptr;
+}
+
+} // namespace
+
 ImageResampler::ImageResampler()
 	: _horizontalDecimation(1)
 	, _verticalDecimation(1)
@@ -10,6 +195,7 @@ ImageResampler::ImageResampler()
 	, _cropTop(0)
 	, _cropBottom(0)
 	, _videoMode(VideoMode::VIDEO_2D)
+	, _yuvMatrix(YuvMatrix::BT601)
 {
 }
 
@@ -40,8 +226,25 @@ void ImageResampler::setVideoMode(VideoMode mode)
 	_videoMode = mode;
 }
 
+void ImageResampler::setYuvMatrix(YuvMatrix matrix)
+{
+	_yuvMatrix = matrix;
+}
+
 void ImageResampler::processImage(const uint8_t * data, int width, int height, int lineLength, PixelFormat pixelFormat, Image<ColorRgb> &outputImage) const
 {
+	// select the conversion once per image, not per pixel
+	const RowConverter convert = rowConverter(pixelFormat);
+	if (convert == nullptr)
+	{
+		if (pixelFormat == PixelFormat::NO_CHANGE)
+		{
+			Error(Logger::getInstance("ImageResampler"), "Invalid pixel format given");
+		}
+		return;
+	}
+	const YuvCoefficients & matrix = yuvCoefficients(_yuvMatrix);
+
 	int cropRight  = _cropRight;
 	int cropBottom = _cropBottom;
 
@@ -64,74 +267,50 @@ void ImageResampler::processImage(const uint8_t * data, int width, int height, i
 
 	outputImage.resize(outputWidth, outputHeight);
 
+	// the chroma planes of the 4:2:0 formats follow the luma plane, a chroma row covers two luma rows
+	const uint8_t * chromaU = nullptr;
+	const uint8_t * chromaV = nullptr;
+	int chromaLineLength = 0;
+	if (pixelFormat == PixelFormat::NV12)
+	{
+		chromaLineLength = lineLength;
+		chromaU = data + lineLength * height;
+	}
+	else if (pixelFormat == PixelFormat::I420)
+	{
+		chromaLineLength = lineLength >> 1;
+		chromaU = data + lineLength * height;
+		chromaV = chromaU + chromaLineLength * ((height + 1) >> 1);
+	}
+
+	// convert only the pixels the consumers of the image read, if they told so
+	const std::shared_ptr<const SampleDemand::Mask> mask = SampleDemand::getInstance()->getMask(outputWidth, outputHeight);
+	outputImage.setSampleGeneration(mask ? mask->generation : 0);
+
+	const int xSourceBegin = _cropLeft + (_horizontalDecimation >> 1);
+
+	ColorRgb * output = outputImage.memptr();
 	for (int yDest = 0, ySource = _cropTop + (_verticalDecimation >> 1); yDest < outputHeight; ySource += _verticalDecimation, ++yDest)
 	{
-		int yOffset = lineLength * ySource;
+		SourceRow row;
+		row.pixels  = data + lineLength * ySource;
+		row.chromaU = (chromaU != nullptr) ? chromaU + chromaLineLength * (ySource >> 1) : nullptr;
+		row.chromaV = (chromaV != nullptr) ? chromaV + chromaLineLength * (ySource >> 1) : nullptr;
+		ColorRgb * outputRow = output + yDest * outputWidth;
 
-		for (int xDest = 0, xSource = _cropLeft + (_horizontalDecimation >> 1); xDest < outputWidth; xSource += _horizontalDecimation, ++xDest)
+		if (mask)
 		{
-			ColorRgb & rgb = outputImage(xDest, yDest);
-
-			switch (pixelFormat)
+			for (uint32_t i = mask->rowIntervals[yDest]; i < mask->rowIntervals[yDest + 1]; ++i)
 			{
-				case PixelFormat::UYVY:
-				{
-					int index = yOffset + (xSource << 1);
-					uint8_t y = data[index+1];
-					uint8_t u = ((xSource&1) == 0) ? data[index  ] : data[index-2];
-					uint8_t v = ((xSource&1) == 0) ? data[index+2] : data[index  ];
-					ColorSys::yuv2rgb(y, u, v, rgb.red, rgb.green, rgb.blue);
-				}
-				break;
-				case PixelFormat::YUYV:
-				{
-					int index = yOffset + (xSource << 1);
-					uint8_t y = data[index];
-					uint8_t u = ((xSource&1) == 0) ? data[index+1] : data[index-1];
-					uint8_t v = ((xSource&1) == 0) ? data[index+3] : data[index+1];
-					ColorSys::yuv2rgb(y, u, v, rgb.red, rgb.green, rgb.blue);
-				}
-				break;
-				case PixelFormat::BGR16:
-				{
-					int index = yOffset + (xSource << 1);
-					rgb.blue  = (data[index] & 0x1f) << 3;
-					rgb.green = (((data[index+1] & 0x7) << 3) | (data[index] & 0xE0) >> 5) << 2;
-					rgb.red   = (data[index+1] & 0xF8);
-				}
-				break;
-				case PixelFormat::BGR24:
-				{
-					int index = yOffset + (xSource << 1) + xSource;
-					rgb.blue  = data[index  ];
-					rgb.green = data[index+1];
-					rgb.red   = data[index+2];
-				}
-				break;
-				case PixelFormat::RGB32:
-				{
-					int index = yOffset + (xSource << 2);
-					rgb.red   = data[index  ];
-					rgb.green = data[index+1];
-					rgb.blue  = data[index+2];
-				}
-				break;
-				case PixelFormat::BGR32:
-				{
-					int index = yOffset + (xSource << 2);
-					rgb.blue  = data[index  ];
-					rgb.green = data[index+1];
-					rgb.red   = data[index+2];
-				}
-				break;
-#ifdef HAVE_JPEG_DECODER
-				case PixelFormat::MJPEG:
-				break;
-#endif
-				case PixelFormat::NO_CHANGE:
-					Error(Logger::getInstance("ImageResampler"), "Invalid pixel format given");
-				break;
+				const std::pair<unsigned, unsigned> & interval = mask->intervals[i];
+				const int xDestBegin = int(interval.first);
+				convert(row, xSourceBegin + xDestBegin * _horizontalDecimation, _horizontalDecimation,
+						int(interval.second) - xDestBegin, matrix, outputRow + xDestBegin);
 			}
 		}
+		else
+		{
+			convert(row, xSourceBegin, _horizontalDecimation, outputWidth, matrix, outputRow);
+		}
 	}
 }
@@ -0,0 +1,153 @@
+#include <utils/LatencyTracker.h>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+
+constexpr size_t LatencyTracker::BUCKETS;
+
+LatencyTracker::LatencyTracker()
+{
+	for (Histogram& histogram : _histograms)
+	{
+		for (std::atomic<uint32_t>& bucket : histogram.buckets)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+		histogram.max.store(0, std::memory_order_relaxed);
+	}
+	for (std::atomic<int64_t>& handOver : _handOver)
+	{
+		handOver.store(0, std::memory_order_relaxed);
+	}
+	_since.store(now(), std::memory_order_relaxed);
+}
+
+int64_t LatencyTracker::now()
+{
+	const auto now = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+}
+
+const char* LatencyTracker::stageName(Stage stage)
+{
+	switch (stage)
+	{
+		case MUXER:      return "muxer";
+		case PROCESS:    return "process";
+		case ADJUSTMENT: return "adjustment";
+		case SMOOTHING:  return "smoothing";
+		case DEVICE:     return "device";
+		default:         return "";
+	}
+}
+
+size_t LatencyTracker::bucketOf(int64_t latency)
+{
+	if (latency < 32)
+	{
+		return latency > 0 ? static_cast<size_t>(latency) : 0;
+	}
+
+	const uint64_t value = static_cast<uint64_t>(latency);
+	size_t exponent = 5;
+	while ((value >> (exponent + 1)) != 0)
+	{
+		++exponent;
+	}
+	const size_t bucket = 32 + (exponent - 5) * 16 + ((value >> (exponent - 4)) & 15);
+	return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+int64_t LatencyTracker::latencyOf(size_t bucket)
+{
+	if (bucket < 32)
+	{
+		return static_cast<int64_t>(bucket);
+	}
+
+	const size_t exponent = 5 + (bucket - 32) / 16;
+	const int64_t lower = static_cast<int64_t>(16 + (bucket - 32) % 16) << (exponent - 4);
+	return lower + ((int64_t(1) << (exponent - 4)) / 2);
+}
+
+void LatencyTracker::record(Stage stage, int64_t captureTime)
+{
+	if (captureTime == 0)
+	{
+		return;
+	}
+
+	const int64_t latency = now() - captureTime;
+	Histogram& histogram = _histograms[stage];
+	histogram.buckets[bucketOf(latency)].fetch_add(1, std::memory_order_relaxed);
+
+	int64_t max = histogram.max.load(std::memory_order_relaxed);
+	while (latency > max && !histogram.max.compare_exchange_weak(max, latency, std::memory_order_relaxed))
+	{
+	}
+}
+
+void LatencyTracker::handOver(Stage stage, int64_t captureTime)
+{
+	_handOver[stage].store(captureTime, std::memory_order_relaxed);
+}
+
+int64_t LatencyTracker::takeOver(Stage stage)
+{
+	// cheap check first, the stages poll for every output
+	if (_handOver[stage].load(std::memory_order_relaxed) == 0)
+	{
+		return 0;
+	}
+	return _handOver[stage].exchange(0, std::memory_order_relaxed);
+}
+
+LatencyTracker::Summary LatencyTracker::summary(Stage stage) const
+{
+	const Histogram& histogram = _histograms[stage];
+
+	uint32_t counts[BUCKETS];
+	uint64_t total = 0;
+	for (size_t i = 0; i < BUCKETS; ++i)
+	{
+		counts[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+		total += counts[i];
+	}
+
+	Summary summary = {total, 0, 0, 0, histogram.max.load(std::memory_order_relaxed)};
+	if (total == 0)
+	{
+		return summary;
+	}
+
+	// the bucket of the n-th smallest latency for each percentile
+	const uint64_t ranks[] = {(total * 50 + 99) / 100, (total * 95 + 99) / 100, (total * 99 + 99) / 100};
+	int64_t* const results[] = {&summary.p50, &summary.p95, &summary.p99};
+	size_t next = 0;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BUCKETS && next < 3; ++i)
+	{
+		seen += counts[i];
+		while (next < 3 && seen >= ranks[next])
+		{
+			// the bucket mid may exceed the largest value recorded
+			*results[next] = std::min(latencyOf(i), summary.max);
+			++next;
+		}
+	}
+	return summary;
+}
+
+void LatencyTracker::reset()
+{
+	for (Histogram& histogram : _histograms)
+	{
+		for (std::atomic<uint32_t>& bucket : histogram.buckets)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+		histogram.max.store(0, std::memory_order_relaxed);
+	}
+	_since.store(now(), std::memory_order_relaxed);
+}
@@ -0,0 +1,297 @@
+#include "ResamplerKernels.h"
+
+#include <utils/CpuFeatures.h>
+
+#if defined(HYPERION_SIMD_X86)
+	#include <tmmintrin.h>
+#elif defined(HYPERION_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
+namespace {
+
+// limited range, see ITU-R BT.601 and BT.709
+const YuvCoefficients BT601_COEFFICIENTS = { 298, 409, 100, 208, 516 };
+const YuvCoefficients BT709_COEFFICIENTS = { 298, 459, 55, 136, 541 };
+
+// The scalar kernels define the results, the vectorized ones process the bulk of the row
+// and leave the remainder to them.
+
+/// @tparam Y0, U, Y1, V  The byte offsets of the components in a pixel pair
+template <int Y0, int U, int Y1, int V>
+void packedYuvToRgbScalar(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint8_t* pair = source + (i >> 1) * 4;
+		yuvToRgb(matrix, pair[(i & 1) != 0 ? Y1 : Y0], pair[U], pair[V], output[i]);
+	}
+}
+
+void yuyvToRgbScalar(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	packedYuvToRgbScalar<0, 1, 2, 3>(source, output, count, matrix);
+}
+
+void uyvyToRgbScalar(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	packedYuvToRgbScalar<1, 0, 3, 2>(source, output, count, matrix);
+}
+
+/// @tparam R, G, B  The byte offsets of the components in a pixel
+template <int R, int G, int B>
+void xrgbToRgbScalar(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint8_t* pixel = source + i * 4;
+		output[i].red   = pixel[R];
+		output[i].green = pixel[G];
+		output[i].blue  = pixel[B];
+	}
+}
+
+void bgr32ToRgbScalar(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	xrgbToRgbScalar<2, 1, 0>(source, output, count);
+}
+
+void rgb32ToRgbScalar(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	xrgbToRgbScalar<0, 1, 2>(source, output, count);
+}
+
+const ResamplerKernels SCALAR_KERNELS = { yuyvToRgbScalar, uyvyToRgbScalar, bgr32ToRgbScalar, rgb32ToRgbScalar, "scalar" };
+
+#if defined(HYPERION_SIMD_X86)
+
+/// Two 16 bit coefficients for _mm_madd_epi16, the first one for the lower lane of a pair
+HYPERION_TARGET_SSSE3 inline __m128i coefficientPair(int first, int second)
+{
+	return _mm_set1_epi32(static_cast<int>(static_cast<uint16_t>(first) | (static_cast<uint32_t>(static_cast<uint16_t>(second)) << 16)));
+}
+
+/// (sum + 128) >> 8 of 8 lanes of 32 bit sums, saturated to 16 bit lanes
+HYPERION_TARGET_SSSE3 inline __m128i descale(__m128i low, __m128i high)
+{
+	const __m128i round = _mm_set1_epi32(128);
+	return _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(low, round), 8), _mm_srai_epi32(_mm_add_epi32(high, round), 8));
+}
+
+// 8 pixels per iteration. The products are summed in 32 bit (_mm_madd_epi16), so the results are
+// exactly those of the scalar code. The saturating packs clamp to [0, 255], a shuffle interleaves
+// the channels to 24 bit pixels.
+template <bool UYVY>
+HYPERION_TARGET_SSSE3 void packedYuvToRgbSsse3(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+	const __m128i lumaOffset = _mm_set1_epi16(16);
+	const __m128i chromaOffset = _mm_set1_epi16(128);
+
+	// pairs of (luma, v), (luma, u) and (v, 0)
+	const __m128i red = coefficientPair(matrix.y, matrix.rv);
+	const __m128i greenU = coefficientPair(matrix.y, -matrix.gu);
+	const __m128i greenV = coefficientPair(-matrix.gv, 0);
+	const __m128i blue = coefficientPair(matrix.y, matrix.bu);
+
+	// bytes of the 8 pixels from r0..r7 g0..g7 and b0..b7
+	const __m128i rg0 = _mm_setr_epi8(0, 8, -1, 1, 9, -1, 2, 10, -1, 3, 11, -1, 4, 12, -1, 5);
+	const __m128i b0  = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+	const __m128i rg1 = _mm_setr_epi8(13, -1, 6, 14, -1, 7, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i b1  = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+		const __m128i luma = UYVY ? _mm_srli_epi16(pixels, 8) : _mm_and_si128(pixels, lowBytes);
+		const __m128i chroma = UYVY ? _mm_and_si128(pixels, lowBytes) : _mm_srli_epi16(pixels, 8);
+
+		// chroma is u0 v0 u1 v1 u2 v2 u3 v3, a pixel pair shares its u and v
+		const __m128i u = _mm_shufflehi_epi16(_mm_shufflelo_epi16(chroma, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+		const __m128i v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(chroma, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+
+		const __m128i c = _mm_sub_epi16(luma, lumaOffset);
+		const __m128i d = _mm_sub_epi16(u, chromaOffset);
+		const __m128i e = _mm_sub_epi16(v, chromaOffset);
+
+		const __m128i ceLow = _mm_unpacklo_epi16(c, e);
+		const __m128i ceHigh = _mm_unpackhi_epi16(c, e);
+		const __m128i cdLow = _mm_unpacklo_epi16(c, d);
+		const __m128i cdHigh = _mm_unpackhi_epi16(c, d);
+		const __m128i eLow = _mm_unpacklo_epi16(e, zero);
+		const __m128i eHigh = _mm_unpackhi_epi16(e, zero);
+
+		const __m128i r = descale(_mm_madd_epi16(ceLow, red), _mm_madd_epi16(ceHigh, red));
+		const __m128i g = descale(_mm_add_epi32(_mm_madd_epi16(cdLow, greenU), _mm_madd_epi16(eLow, greenV)),
+								  _mm_add_epi32(_mm_madd_epi16(cdHigh, greenU), _mm_madd_epi16(eHigh, greenV)));
+		const __m128i b = descale(_mm_madd_epi16(cdLow, blue), _mm_madd_epi16(cdHigh, blue));
+
+		const __m128i rg = _mm_packus_epi16(r, g);
+		const __m128i bb = _mm_packus_epi16(b, b);
+
+		uint8_t* out = reinterpret_cast<uint8_t*>(output + i);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_or_si128(_mm_shuffle_epi8(rg, rg0), _mm_shuffle_epi8(bb, b0)));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + 16), _mm_or_si128(_mm_shuffle_epi8(rg, rg1), _mm_shuffle_epi8(bb, b1)));
+	}
+
+	packedYuvToRgbScalar<UYVY ? 1 : 0, UYVY ? 0 : 1, UYVY ? 3 : 2, UYVY ? 2 : 3>(source + i * 2, output + i, count - i, matrix);
+}
+
+HYPERION_TARGET_SSSE3 void yuyvToRgbSsse3(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	packedYuvToRgbSsse3<false>(source, output, count, matrix);
+}
+
+HYPERION_TARGET_SSSE3 void uyvyToRgbSsse3(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	packedYuvToRgbSsse3<true>(source, output, count, matrix);
+}
+
+// 4 pixels per shuffle. The 16 byte store writes 4 bytes beyond the 12 bytes of the pixels, they
+// are overwritten by the next store, the loop leaves at least 4 more pixels to the scalar code.
+template <int R, int G, int B>
+HYPERION_TARGET_SSSE3 void xrgbToRgbSsse3(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	const __m128i pack = _mm_setr_epi8(R, G, B, 4 + R, 4 + G, 4 + B, 8 + R, 8 + G, 8 + B, 12 + R, 12 + G, 12 + B, -1, -1, -1, -1);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_shuffle_epi8(pixels, pack));
+	}
+
+	xrgbToRgbScalar<R, G, B>(source + i * 4, output + i, count - i);
+}
+
+HYPERION_TARGET_SSSE3 void bgr32ToRgbSsse3(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	xrgbToRgbSsse3<2, 1, 0>(source, output, count);
+}
+
+HYPERION_TARGET_SSSE3 void rgb32ToRgbSsse3(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	xrgbToRgbSsse3<0, 1, 2>(source, output, count);
+}
+
+#elif defined(HYPERION_SIMD_NEON)
+
+/// (cy * c + cd * d + ce * e + 128) >> 8 of 8 lanes in 32 bit, clamped to [0, 255]
+inline uint8x8_t yuvChannelNeon(int16x8_t c, int16x8_t d, int16x8_t e, int16_t cy, int16_t cd, int16_t ce)
+{
+	const int32x4_t round = vdupq_n_s32(128);
+
+	int32x4_t low = vmlal_n_s16(round, vget_low_s16(c), cy);
+	low = vmlal_n_s16(low, vget_low_s16(d), cd);
+	low = vmlal_n_s16(low, vget_low_s16(e), ce);
+
+	int32x4_t high = vmlal_n_s16(round, vget_high_s16(c), cy);
+	high = vmlal_n_s16(high, vget_high_s16(d), cd);
+	high = vmlal_n_s16(high, vget_high_s16(e), ce);
+
+	return vqmovun_s16(vcombine_s16(vqshrn_n_s32(low, 8), vqshrn_n_s32(high, 8)));
+}
+
+inline int16x8_t offsetNeon(uint8x8_t component, int16_t offset)
+{
+	return vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(component)), vdupq_n_s16(offset));
+}
+
+// 16 pixels per iteration, the even and the odd pixels of the pairs are converted separately and
+// interleaved again. The products are summed in 32 bit, so the results are exactly those of the
+// scalar code.
+template <bool UYVY>
+void packedYuvToRgbNeon(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint8x8x4_t pairs = vld4_u8(source + i * 2);
+		const int16x8_t c[2] = { offsetNeon(pairs.val[UYVY ? 1 : 0], 16), offsetNeon(pairs.val[UYVY ? 3 : 2], 16) };
+		const int16x8_t d = offsetNeon(pairs.val[UYVY ? 0 : 1], 128);
+		const int16x8_t e = offsetNeon(pairs.val[UYVY ? 2 : 3], 128);
+
+		uint8x8_t r[2], g[2], b[2];
+		for (int odd = 0; odd < 2; ++odd)
+		{
+			r[odd] = yuvChannelNeon(c[odd], d, e, matrix.y, 0, matrix.rv);
+			g[odd] = yuvChannelNeon(c[odd], d, e, matrix.y, -matrix.gu, -matrix.gv);
+			b[odd] = yuvChannelNeon(c[odd], d, e, matrix.y, matrix.bu, 0);
+		}
+
+		const uint8x8x2_t red = vzip_u8(r[0], r[1]);
+		const uint8x8x2_t green = vzip_u8(g[0], g[1]);
+		const uint8x8x2_t blue = vzip_u8(b[0], b[1]);
+
+		uint8_t* out = reinterpret_cast<uint8_t*>(output + i);
+		vst3_u8(out, (uint8x8x3_t{{ red.val[0], green.val[0], blue.val[0] }}));
+		vst3_u8(out + 24, (uint8x8x3_t{{ red.val[1], green.val[1], blue.val[1] }}));
+	}
+
+	packedYuvToRgbScalar<UYVY ? 1 : 0, UYVY ? 0 : 1, UYVY ? 3 : 2, UYVY ? 2 : 3>(source + i * 2, output + i, count - i, matrix);
+}
+
+void yuyvToRgbNeon(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	packedYuvToRgbNeon<false>(source, output, count, matrix);
+}
+
+void uyvyToRgbNeon(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix)
+{
+	packedYuvToRgbNeon<true>(source, output, count, matrix);
+}
+
+// 8 pixels per iteration, de- and re-interleaved by the structure loads and stores
+template <int R, int G, int B>
+void xrgbToRgbNeon(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const uint8x8x4_t pixels = vld4_u8(source + i * 4);
+		vst3_u8(reinterpret_cast<uint8_t*>(output + i), (uint8x8x3_t{{ pixels.val[R], pixels.val[G], pixels.val[B] }}));
+	}
+
+	xrgbToRgbScalar<R, G, B>(source + i * 4, output + i, count - i);
+}
+
+void bgr32ToRgbNeon(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	xrgbToRgbNeon<2, 1, 0>(source, output, count);
+}
+
+void rgb32ToRgbNeon(const uint8_t* source, ColorRgb* output, size_t count)
+{
+	xrgbToRgbNeon<0, 1, 2>(source, output, count);
+}
+
+#endif
+
+} // namespace
+
+const YuvCoefficients& yuvCoefficients(YuvMatrix matrix)
+{
+	return (matrix == YuvMatrix::BT709) ? BT709_COEFFICIENTS : BT601_COEFFICIENTS;
+}
+
+std::vector<ResamplerKernels> availableResamplerKernels()
+{
+	std::vector<ResamplerKernels> kernels { SCALAR_KERNELS };
+#if defined(HYPERION_SIMD_X86)
+	if (CpuFeatures::hasSSSE3())
+	{
+		kernels.push_back({ yuyvToRgbSsse3, uyvyToRgbSsse3, bgr32ToRgbSsse3, rgb32ToRgbSsse3, "ssse3" });
+	}
+#elif defined(HYPERION_SIMD_NEON)
+	kernels.push_back({ yuyvToRgbNeon, uyvyToRgbNeon, bgr32ToRgbNeon, rgb32ToRgbNeon, "neon" });
+#endif
+	return kernels;
+}
+
+const ResamplerKernels& resamplerKernels()
+{
+	static const ResamplerKernels kernels = availableResamplerKernels().back();
+	return kernels;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+// STL includes
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Utils includes
+#include <utils/ColorRgb.h>
+#include <utils/ImageResampler.h>
+
+///
+/// Fixed-point YUV to RGB matrix for limited range (video level) input, coefficients in Q8:
+/// r = (y * (Y - 16) + rv * (V - 128) + 128) >> 8
+/// g = (y * (Y - 16) - gu * (U - 128) - gv * (V - 128) + 128) >> 8
+/// b = (y * (Y - 16) + bu * (U - 128) + 128) >> 8
+///
+struct YuvCoefficients
+{
+	int16_t y;
+	int16_t rv;
+	int16_t gu;
+	int16_t gv;
+	int16_t bu;
+};
+
+///
+/// @brief Get the coefficients of a matrix
+///
+const YuvCoefficients& yuvCoefficients(YuvMatrix matrix);
+
+///
+/// @brief Convert one YUV pixel, the reference of all YUV kernels
+///
+inline void yuvToRgb(const YuvCoefficients& matrix, uint8_t y, uint8_t u, uint8_t v, ColorRgb& rgb)
+{
+	const int c = y - 16;
+	const int d = u - 128;
+	const int e = v - 128;
+
+	const int r = (matrix.y * c + matrix.rv * e + 128) >> 8;
+	const int g = (matrix.y * c - matrix.gu * d - matrix.gv * e + 128) >> 8;
+	const int b = (matrix.y * c + matrix.bu * d + 128) >> 8;
+
+	rgb.red   = static_cast<uint8_t>(r < 0 ? 0 : (r > 255 ? 255 : r));
+	rgb.green = static_cast<uint8_t>(g < 0 ? 0 : (g > 255 ? 255 : g));
+	rgb.blue  = static_cast<uint8_t>(b < 0 ? 0 : (b > 255 ? 255 : b));
+}
+
+///
+/// Row kernels of the image resampler for consecutive pixels (no horizontal decimation), with
+/// vectorized variants selected by CPU feature.
+///
+/// All variants of a kernel produce identical results.
+///
+struct ResamplerKernels
+{
+	///
+	/// Converts packed 4:2:2 pixels (Y0 U Y1 V) to RGB
+	///
+	/// @param source  The first pixel, an even pixel of the row
+	/// @param output  The resulting pixels
+	/// @param count   The number of pixels
+	/// @param matrix  The YUV matrix
+	///
+	void (*yuyvToRgb)(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix);
+
+	///
+	/// Converts packed 4:2:2 pixels (U Y0 V Y1) to RGB, see yuyvToRgb
+	///
+	void (*uyvyToRgb)(const uint8_t* source, ColorRgb* output, size_t count, const YuvCoefficients& matrix);
+
+	///
+	/// Converts 32 bit pixels with the byte order B G R X to RGB
+	///
+	/// @param source  The first pixel
+	/// @param output  The resulting pixels
+	/// @param count   The number of pixels
+	///
+	void (*bgr32ToRgb)(const uint8_t* source, ColorRgb* output, size_t count);
+
+	///
+	/// Converts 32 bit pixels with the byte order R G B X to RGB, see bgr32ToRgb
+	///
+	void (*rgb32ToRgb)(const uint8_t* source, ColorRgb* output, size_t count);
+
+	/// Name of the instruction set, e.g. for log output
+	const char* name;
+};
+
+///
+/// @brief Get the fastest kernels supported by the CPU, selected once
+///
+const ResamplerKernels& resamplerKernels();
+
+///
+/// @brief Get all kernel variants supported by the CPU, the scalar reference first (for tests)
+///
+std::vector<ResamplerKernels> availableResamplerKernels();
@@ -0,0 +1,148 @@
+#include <utils/SampleDemand.h>
+
+#include <algorithm>
+
+#include <QMutexLocker>
+
+void SampleDemand::setDemand(const void* consumer, unsigned width, unsigned height, const std::vector<Span>& spans)
+{
+	QMutexLocker lock(&_mutex);
+	_demands[consumer] = Demand{false, false, width, height, spans};
+	rebuild();
+}
+
+void SampleDemand::setSupplementaryDemand(const void* consumer, unsigned width, unsigned height, const std::vector<Span>& spans)
+{
+	QMutexLocker lock(&_mutex);
+	_demands[consumer] = Demand{false, true, width, height, spans};
+	rebuild();
+}
+
+void SampleDemand::setFullDemand(const void* consumer)
+{
+	QMutexLocker lock(&_mutex);
+	_demands[consumer] = Demand{true, false, 0, 0, {}};
+	rebuild();
+}
+
+void SampleDemand::removeConsumer(const void* consumer)
+{
+	QMutexLocker lock(&_mutex);
+	if (_demands.erase(consumer) > 0)
+	{
+		rebuild();
+	}
+}
+
+std::shared_ptr<const SampleDemand::Mask> SampleDemand::getMask(unsigned width, unsigned height) const
+{
+	QMutexLocker lock(&_mutex);
+	if (_mask && _mask->width == width && _mask->height == height)
+	{
+		return _mask;
+	}
+	return nullptr;
+}
+
+uint64_t SampleDemand::generation() const
+{
+	QMutexLocker lock(&_mutex);
+	return _generation;
+}
+
+void SampleDemand::rebuild()
+{
+	_mask.reset();
+	++_generation;
+
+	// supplementary demands alone (e.g. a standalone capture tool) need the whole image
+	const auto primary = std::find_if(_demands.begin(), _demands.end(), [](const std::pair<const void* const, Demand>& entry) {
+		return !entry.second.supplementary;
+	});
+	if (primary == _demands.end())
+	{
+		return;
+	}
+
+	// all consumers have to read sparse images of the same size
+	const Demand& first = primary->second;
+	for (const auto& entry : _demands)
+	{
+		const Demand& demand = entry.second;
+		if (!demand.supplementary && (demand.full || demand.width != first.width || demand.height != first.height))
+		{
+			return;
+		}
+	}
+
+	const unsigned width  = first.width;
+	const unsigned height = first.height;
+	if (width == 0 || height == 0)
+	{
+		return;
+	}
+
+	// collect the clipped spans of all consumers per row
+	std::vector<std::vector<std::pair<unsigned, unsigned>>> rows(height);
+	for (const auto& entry : _demands)
+	{
+		// supplementary demands for images of another size do not affect this mask
+		if (entry.second.width != width || entry.second.height != height)
+		{
+			continue;
+		}
+
+		for (const Span& span : entry.second.spans)
+		{
+			const unsigned xEnd = std::min(span.xEnd, width);
+			if (span.row < height && span.xBegin < xEnd)
+			{
+				rows[span.row].emplace_back(span.xBegin, xEnd);
+			}
+		}
+	}
+
+	auto mask = std::make_shared<Mask>();
+	mask->width = width;
+	mask->height = height;
+	mask->pixelCount = 0;
+	mask->generation = _generation;
+	mask->rowIntervals.reserve(height + 1);
+
+	for (auto& row : rows)
+	{
+		mask->rowIntervals.push_back(uint32_t(mask->intervals.size()));
+		if (row.empty())
+		{
+			continue;
+		}
+
+		// merge overlapping and adjacent ranges
+		std::sort(row.begin(), row.end());
+		std::pair<unsigned, unsigned> current = row.front();
+		for (const auto& range : row)
+		{
+			if (range.first <= current.second)
+			{
+				current.second = std::max(current.second, range.second);
+			}
+			else
+			{
+				mask->pixelCount += current.second - current.first;
+				mask->intervals.push_back(current);
+				current = range;
+			}
+		}
+		mask->pixelCount += current.second - current.first;
+		mask->intervals.push_back(current);
+	}
+	mask->rowIntervals.push_back(uint32_t(mask->intervals.size()));
+
+	// converting most of the image in pieces gains nothing
+	if (mask->pixelCount * 2 > uint64_t(width) * height)
+	{
+		return;
+	}
+
+	_mask = std::move(mask);
+}
@@ -0,0 +1,242 @@
+#include <utils/Tracer.h>
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Qt includes
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QThread>
+
+namespace {
+
+struct Event
+{
+	std::atomic<const char*> name;
+	std::atomic<int64_t> timestamp;
+	std::atomic<int64_t> value;
+	std::atomic<uint8_t> type;
+};
+
+struct ThreadBuffer
+{
+	Event events[Tracer::EVENTS_PER_THREAD];
+	/// Index + 1 of the event being written, it overwrites the event EVENTS_PER_THREAD before
+	std::atomic<uint64_t> claimed{0};
+	/// Number of events completely written
+	std::atomic<uint64_t> written{0};
+	/// Events before this index were cleared
+	std::atomic<uint64_t> cleared{0};
+	/// False once the thread ended, the buffer can be taken over then
+	std::atomic<bool> attached{true};
+
+	// guarded by the registry mutex
+	int tid = 0;
+	QString threadName;
+};
+
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	int nextTid = 1;
+};
+
+Registry& registry()
+{
+	// never destroyed, threads may still end after the static destructors ran
+	static Registry* instance = new Registry;
+	return *instance;
+}
+
+struct ThreadSlot
+{
+	ThreadBuffer* buffer = nullptr;
+
+	~ThreadSlot()
+	{
+		if (buffer != nullptr)
+		{
+			buffer->attached.store(false, std::memory_order_release);
+		}
+	}
+};
+
+thread_local ThreadSlot threadSlot;
+
+ThreadBuffer* attachThread()
+{
+	Registry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+
+	ThreadBuffer* buffer = nullptr;
+	for (const auto& candidate : reg.buffers)
+	{
+		if (!candidate->attached.load(std::memory_order_acquire))
+		{
+			// drop the events of the ended thread
+			buffer = candidate.get();
+			buffer->cleared.store(buffer->written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			buffer->attached.store(true, std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	if (buffer == nullptr)
+	{
+		reg.buffers.emplace_back(new ThreadBuffer);
+		buffer = reg.buffers.back().get();
+	}
+
+	buffer->tid = reg.nextTid++;
+	const QThread* thread = QThread::currentThread();
+	buffer->threadName = (thread != nullptr && !thread->objectName().isEmpty())
+			? thread->objectName()
+			: QString("Thread %1").arg(buffer->tid);
+
+	threadSlot.buffer = buffer;
+	return buffer;
+}
+
+} // namespace
+
+int64_t Tracer::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::complete(const char* name, int64_t start, int64_t duration)
+{
+	record(COMPLETE, name, start, duration);
+}
+
+void Tracer::counter(const char* name, int64_t value)
+{
+	record(COUNTER, name, now(), value);
+}
+
+void Tracer::instant(const char* name)
+{
+	record(INSTANT, name, now(), 0);
+}
+
+void Tracer::record(Type type, const char* name, int64_t timestamp, int64_t value)
+{
+	ThreadBuffer* buffer = threadSlot.buffer;
+	if (buffer == nullptr)
+	{
+		buffer = attachThread();
+	}
+
+	// only the owning thread writes, a concurrent dump detects overwritten events by the claimed index
+	const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+	buffer->claimed.store(index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Event& event = buffer->events[index % EVENTS_PER_THREAD];
+	event.name.store(name, std::memory_order_relaxed);
+	event.timestamp.store(timestamp, std::memory_order_relaxed);
+	event.value.store(value, std::memory_order_relaxed);
+	event.type.store(type, std::memory_order_relaxed);
+
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+QJsonObject Tracer::dumpChromeTrace()
+{
+	struct Copy
+	{
+		const char* name;
+		int64_t timestamp;
+		int64_t value;
+		uint8_t type;
+	};
+
+	const qint64 pid = QCoreApplication::applicationPid();
+	std::vector<Copy> copies;
+	copies.reserve(EVENTS_PER_THREAD);
+
+	QJsonArray traceEvents;
+	Registry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+
+	for (const auto& buffer : reg.buffers)
+	{
+		const uint64_t end = buffer->written.load(std::memory_order_acquire);
+		uint64_t begin = std::max(buffer->cleared.load(std::memory_order_relaxed), end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0);
+
+		copies.clear();
+		for (uint64_t index = begin; index < end; ++index)
+		{
+			const Event& event = buffer->events[index % EVENTS_PER_THREAD];
+			copies.push_back({ event.name.load(std::memory_order_relaxed),
+							   event.timestamp.load(std::memory_order_relaxed),
+							   event.value.load(std::memory_order_relaxed),
+							   event.type.load(std::memory_order_relaxed) });
+		}
+
+		// skip the events the thread overwrote while they were copied
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t claimed = buffer->claimed.load(std::memory_order_relaxed);
+		const size_t skip = claimed > begin + EVENTS_PER_THREAD
+				? static_cast<size_t>(std::min<uint64_t>(claimed - EVENTS_PER_THREAD - begin, copies.size()))
+				: 0;
+
+		QJsonObject threadName;
+		threadName["name"] = "thread_name";
+		threadName["ph"] = "M";
+		threadName["pid"] = pid;
+		threadName["tid"] = buffer->tid;
+		threadName["args"] = QJsonObject{ { "name", buffer->threadName } };
+		traceEvents.append(threadName);
+
+		for (size_t i = skip; i < copies.size(); ++i)
+		{
+			const Copy& copy = copies[i];
+			QJsonObject event;
+			event["name"] = copy.name;
+			event["pid"] = pid;
+			event["tid"] = buffer->tid;
+			// Chrome traces are in microseconds
+			event["ts"] = copy.timestamp / 1000.0;
+
+			switch (copy.type)
+			{
+			case COMPLETE:
+				event["ph"] = "X";
+				event["dur"] = copy.value / 1000.0;
+				break;
+			case COUNTER:
+				event["ph"] = "C";
+				event["args"] = QJsonObject{ { "value", static_cast<qint64>(copy.value) } };
+				break;
+			default:
+				event["ph"] = "i";
+				event["s"] = "t";
+				break;
+			}
+			traceEvents.append(event);
+		}
+	}
+
+	QJsonObject trace;
+	trace["displayTimeUnit"] = "ms";
+	trace["traceEvents"] = traceEvents;
+	return trace;
+}
+
+void Tracer::clear()
+{
+	Registry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+
+	for (const auto& buffer : reg.buffers)
+	{
+		buffer->cleared.store(buffer->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+}
@@ -36,9 +36,14 @@ bool XcbWrapper::displayInit()
 
 void XcbWrapper::capture()
 {
-	_grabber.grabFrame(_screenshot, !_inited);
-	emit sig_screenshot(_screenshot);
+	// nothing to send while the screen does not change
+	const bool unchanged = _grabber.grabFrame(_screenshot, !_inited) > 0;
 	_inited = true;
+
+	if (!unchanged)
+	{
+		emit sig_screenshot(_screenshot);
+	}
 }
 
 void XcbWrapper::setVideoMode(const VideoMode mode)
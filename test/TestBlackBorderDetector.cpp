@@ -137,6 +137,113 @@ int TC_UNKNOWN_BORDER()
 	return result;
 }
 
+Image<ColorRgb> createScanImage(unsigned width, unsigned height, unsigned horizontalBorder, unsigned verticalBorder, unsigned seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> component(64, 255);
+
+	Image<ColorRgb> image(width, height);
+	for (unsigned y=0; y<height; ++y)
+	{
+		for (unsigned x=0; x<width; ++x)
+		{
+			if (y < horizontalBorder || y >= height - horizontalBorder || x < verticalBorder || x >= width - verticalBorder)
+			{
+				image(x,y) = ColorRgb::BLACK;
+			}
+			else
+			{
+				image(x,y) = {uint8_t(component(random)), uint8_t(component(random)), uint8_t(component(random))};
+			}
+		}
+	}
+	return image;
+}
+
+int checkScan(const char* name, const BlackBorder& border, bool unknown, int horizontalSize, int verticalSize)
+{
+	if (border.unknown != unknown || (!unknown && (border.horizontalSize != horizontalSize || border.verticalSize != verticalSize)))
+	{
+		std::cerr << "Scan failed for " << name << ": unknown " << border.unknown << " horizontal " << border.horizontalSize << " vertical " << border.verticalSize << std::endl;
+		return -1;
+	}
+	std::cout << "Scan correctly detected " << name << std::endl;
+	return 0;
+}
+
+int TC_SCAN_BORDERS()
+{
+	int result = 0;
+
+	// odd sizes to cover the remainders of the vectorized line scan
+	for (unsigned width : {64u, 161u, 333u})
+	{
+		const unsigned height = width * 9 / 16 + 1;
+
+		BlackBorderDetector detector(0.05);
+		result |= checkScan("no border", detector.process_scan(createScanImage(width, height, 0, 0, width)), false, 0, 0);
+
+		BlackBorderDetector letterboxDetector(0.05);
+		result |= checkScan("letterbox", letterboxDetector.process_scan(createScanImage(width, height, height / 8, 0, width)), false, int(height / 8), 0);
+
+		BlackBorderDetector pillarboxDetector(0.05);
+		result |= checkScan("pillarbox", pillarboxDetector.process_scan(createScanImage(width, height, 0, width / 8, width)), false, 0, int(width / 8));
+
+		BlackBorderDetector dualDetector(0.05);
+		result |= checkScan("two-sided border", dualDetector.process_scan(createScanImage(width, height, height / 6, width / 5, width)), false, int(height / 6), int(width / 5));
+
+		BlackBorderDetector darkDetector(0.05);
+		result |= checkScan("dark frame", darkDetector.process_scan(Image<ColorRgb>(width, height)), true, 0, 0);
+	}
+
+	return result;
+}
+
+int TC_SCAN_LOGO()
+{
+	BlackBorderDetector detector(0.05);
+
+	// a logo and a few noisy pixels in the black bars do not belong to the picture
+	Image<ColorRgb> image = createScanImage(320, 180, 20, 0, 1);
+	for (unsigned y=4; y<8; ++y)
+	{
+		for (unsigned x=290; x<294; ++x)
+		{
+			image(x,y) = ColorRgb::WHITE;
+		}
+	}
+	image(10,175) = ColorRgb::WHITE;
+	image(200,170) = ColorRgb::WHITE;
+
+	return checkScan("letterbox with logo", detector.process_scan(image), false, 20, 0);
+}
+
+int TC_SCAN_SCENE_CHANGE()
+{
+	int result = 0;
+
+	BlackBorderDetector detector(0.05);
+	Image<ColorRgb> image = createScanImage(160, 90, 12, 0, 2);
+	result |= checkScan("first frame", detector.process_scan(image), false, 12, 0);
+
+	// rows 9 to 11 are no rows of the scene grid, the previous border is kept
+	Image<ColorRgb> similar = createScanImage(160, 90, 12, 0, 2);
+	for (unsigned y=9; y<12; ++y)
+	{
+		for (unsigned x=0; x<160; ++x)
+		{
+			similar(x,y) = ColorRgb::WHITE;
+			similar(x,89-y) = ColorRgb::WHITE;
+		}
+	}
+	result |= checkScan("unchanged scene", detector.process_scan(similar), false, 12, 0);
+
+	// a new scene is scanned again
+	result |= checkScan("scene change", detector.process_scan(createScanImage(160, 90, 9, 0, 3)), false, 9, 0);
+
+	return result;
+}
+
 int main()
 {
 	TC_NO_BORDER();
@@ -145,5 +252,10 @@ int main()
 	TC_DUAL_BORDER();
 	TC_UNKNOWN_BORDER();
 
-	return 0;
+	int result = 0;
+	result |= TC_SCAN_BORDERS();
+	result |= TC_SCAN_LOGO();
+	result |= TC_SCAN_SCENE_CHANGE();
+
+	return result;
 }
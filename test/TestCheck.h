@@ -0,0 +1,21 @@
+#pragma once
+
+// STL includes
+#include <iostream>
+#include <string>
+
+///
+/// @brief Report a failed test condition
+/// @param condition  The condition to check
+/// @param message    The description of the condition, printed when it does not hold
+/// @return 0 if the condition holds, 1 otherwise (to be or'ed into the exit code of the test)
+///
+inline int check(bool condition, const std::string& message)
+{
+	if (!condition)
+	{
+		std::cout << "Failed: " << message << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,109 @@
+// STL includes
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Utils includes
+#include <utils/Image.h>
+#include <utils/ColorRgb.h>
+#include <utils/ImageBufferPool.h>
+
+#include "TestCheck.h"
+
+namespace {
+
+/// Creates and fills frames of the given size like a grabber does
+double produceFrames(unsigned width, unsigned height, unsigned count)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < count; ++i)
+	{
+		Image<ColorRgb> image(width, height);
+		image.memptr()[i % (width * height)] = ColorRgb::RED;
+	}
+	const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / count;
+}
+
+} // namespace
+
+int main()
+{
+	ImageBufferPool* pool = ImageBufferPool::getInstance();
+	int result = 0;
+
+	// size classes
+	result |= check(ImageBufferPool::sizeClass(100) == 100, "small requests are not rounded");
+	result |= check(ImageBufferPool::sizeClass(1920*1080*3 + 3) >= 1920*1080*3 + 3, "size class holds the request");
+	result |= check(ImageBufferPool::sizeClass(1920*1080*3 + 3) <= (1920*1080*3 + 3) * 5 / 4, "size class wastes at most 25%");
+	result |= check(ImageBufferPool::sizeClass(1920*1080*3) == ImageBufferPool::sizeClass(1920*1080*3 + 3), "similar sizes share a class");
+
+	// a freed frame is handed out again
+	ImageBufferPool::Statistics before = pool->statistics();
+	const ColorRgb* first;
+	{
+		Image<ColorRgb> image(1280, 720);
+		first = image.memptr();
+	}
+	{
+		Image<ColorRgb> image(1280, 720, ColorRgb::BLUE);
+		result |= check(image.memptr() == first, "buffer is reused");
+		result |= check(image(1279, 719) == ColorRgb::BLUE, "reused buffer is initialized");
+	}
+	ImageBufferPool::Statistics after = pool->statistics();
+	result |= check(after.allocations - before.allocations == 1, "one allocation");
+	result |= check(after.reuses - before.reuses == 1, "one reuse");
+
+	// copy on write detaches into a pooled buffer and keeps the content
+	{
+		Image<ColorRgb> image(640, 480, ColorRgb::GREEN);
+		Image<ColorRgb> copy = image;
+		copy.memptr()[0] = ColorRgb::RED;
+		result |= check(image.memptr()[0] == ColorRgb::GREEN && copy(639, 479) == ColorRgb::GREEN, "detached copy");
+	}
+
+	// steady state of a stream of frames does not allocate
+	before = pool->statistics();
+	const double pooledMs = produceFrames(1920, 1080, 200);
+	after = pool->statistics();
+	result |= check(after.allocations - before.allocations <= 1, "stream of frames is served from the pool");
+
+	// frames released by other threads are recycled
+	before = pool->statistics();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([]() { produceFrames(960, 540, 100); });
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	after = pool->statistics();
+	result |= check(after.allocations - before.allocations <= 4, "concurrent frames are served from the pool");
+
+	// the retained memory is bounded
+	pool->setMaxRetainedBytes(4 * 1024 * 1024);
+	{
+		std::vector<Image<ColorRgb>> images(8, Image<ColorRgb>(1920, 1080));
+		for (Image<ColorRgb>& image : images)
+		{
+			image.memptr()[0] = ColorRgb::WHITE;
+		}
+	}
+	after = pool->statistics();
+	result |= check(after.retainedBytes <= 4 * 1024 * 1024, "retained bytes are bounded");
+
+	// without recycling every frame is a fresh allocation
+	pool->setMaxRetainedBytes(0);
+	before = pool->statistics();
+	const double unpooledMs = produceFrames(1920, 1080, 200);
+	after = pool->statistics();
+	result |= check(after.allocations - before.allocations == 200 && after.retainedBuffers == 0, "recycling disabled");
+
+	std::cout << "1920x1080 frame: pooled " << pooledMs << " ms, unpooled " << unpooledMs << " ms"
+			  << ", allocations " << after.allocations << ", reuses " << after.reuses << ", evictions " << after.evictions << std::endl;
+
+	return result;
+}
@@ -0,0 +1,187 @@
+// STL includes
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Utils includes
+#include <utils/Image.h>
+#include <utils/ColorRgb.h>
+
+// Hyperion includes
+#include <hyperion/ImageToLedsMap.h>
+#include <hyperion/LedString.h>
+
+namespace {
+
+///
+/// Index based mapping as used before the span based ImageToLedsMap. It is kept here as
+/// reference for correctness and speed.
+///
+class IndexImageToLedsMap
+{
+public:
+	IndexImageToLedsMap(unsigned width, unsigned height, const std::vector<Led>& leds)
+	{
+		for (const Led& led : leds)
+		{
+			std::vector<unsigned> ledColors;
+			if ((led.maxX_frac-led.minX_frac) >= 1e-6 && (led.maxY_frac-led.minY_frac) >= 1e-6)
+			{
+				unsigned minX_idx = unsigned(qRound(width  * led.minX_frac));
+				unsigned maxX_idx = unsigned(qRound(width  * led.maxX_frac));
+				unsigned minY_idx = unsigned(qRound(height * led.minY_frac));
+				unsigned maxY_idx = unsigned(qRound(height * led.maxY_frac));
+
+				minX_idx = qMin(minX_idx, width - 1);
+				if (minX_idx == maxX_idx)
+				{
+					maxX_idx++;
+				}
+				minY_idx = qMin(minY_idx, height - 1);
+				if (minY_idx == maxY_idx)
+				{
+					maxY_idx++;
+				}
+
+				for (unsigned y = minY_idx; y < qMin(maxY_idx, height); ++y)
+				{
+					for (unsigned x = minX_idx; x < qMin(maxX_idx, width); ++x)
+					{
+						ledColors.push_back(y*width + x);
+					}
+				}
+			}
+			_colorsMap.push_back(ledColors);
+		}
+	}
+
+	void getMeanLedColor(const Image<ColorRgb>& image, std::vector<ColorRgb>& ledColors) const
+	{
+		auto led = ledColors.begin();
+		for (const std::vector<unsigned>& colors : _colorsMap)
+		{
+			if (colors.empty())
+			{
+				*led++ = ColorRgb::BLACK;
+				continue;
+			}
+
+			uint_fast32_t cummRed = 0, cummGreen = 0, cummBlue = 0;
+			for (const unsigned colorOffset : colors)
+			{
+				const ColorRgb& pixel = image.memptr()[colorOffset];
+				cummRed   += pixel.red;
+				cummGreen += pixel.green;
+				cummBlue  += pixel.blue;
+			}
+			*led++ = ColorRgb{uint8_t(cummRed/colors.size()), uint8_t(cummGreen/colors.size()), uint8_t(cummBlue/colors.size())};
+		}
+	}
+
+	size_t indexBytes() const
+	{
+		size_t bytes = 0;
+		for (const std::vector<unsigned>& colors : _colorsMap)
+		{
+			bytes += colors.size() * sizeof(unsigned);
+		}
+		return bytes;
+	}
+
+private:
+	std::vector<std::vector<unsigned>> _colorsMap;
+};
+
+/// Classic frame layout with the given number of leds per side and a depth of 8% of the image
+std::vector<Led> createLeds(unsigned ledsPerSide)
+{
+	std::vector<Led> leds;
+	const double depth = 0.08;
+	for (unsigned i = 0; i < ledsPerSide; ++i)
+	{
+		const double begin = double(i) / ledsPerSide;
+		const double end   = double(i + 1) / ledsPerSide;
+		leds.push_back({begin, end, 0.0, depth, ColorOrder::ORDER_RGB});
+		leds.push_back({1.0 - depth, 1.0, begin, end, ColorOrder::ORDER_RGB});
+		leds.push_back({begin, end, 1.0 - depth, 1.0, ColorOrder::ORDER_RGB});
+		leds.push_back({0.0, depth, begin, end, ColorOrder::ORDER_RGB});
+	}
+	return leds;
+}
+
+template <typename Func>
+double measureMs(unsigned loops, Func func)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < loops; ++i)
+	{
+		func();
+	}
+	const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / loops;
+}
+
+} // namespace
+
+int main()
+{
+	const unsigned loops = 100;
+	const unsigned sizes[][2] = { {80, 45}, {480, 270}, {960, 540}, {1920, 1080} };
+	const std::vector<Led> leds = createLeds(80);
+
+	std::cout << "Summation kernel: " << hyperion::accumulateColorsKernelName() << ", leds: " << leds.size() << std::endl;
+
+	int result = 0;
+	for (const auto& size : sizes)
+	{
+		const unsigned width = size[0];
+		const unsigned height = size[1];
+
+		Image<ColorRgb> image(width, height);
+		for (ssize_t i = 0; i < image.size(); ++i)
+		{
+			reinterpret_cast<uint8_t*>(image.memptr())[i] = uint8_t(std::rand());
+		}
+
+		const IndexImageToLedsMap indexMap(width, height, leds);
+		const hyperion::ImageToLedsMap spanMap(width, height, 0, 0, leds);
+
+		std::vector<ColorRgb> indexColors(leds.size());
+		std::vector<ColorRgb> spanColors(leds.size());
+
+		const double indexMs = measureMs(loops, [&]() { indexMap.getMeanLedColor(image, indexColors); });
+		const double spanMs  = measureMs(loops, [&]() { spanMap.getMeanLedColor(image, spanColors); });
+		const double uniMs   = measureMs(loops, [&]() { spanMap.getUniLedColor(image, spanColors); });
+
+		hyperion::IntegralImage integral;
+		std::vector<ColorRgb> integralColors(leds.size());
+		const double integralMs = measureMs(loops, [&]() { integral.update(image); spanMap.getIntegralLedColor(integral, integralColors); });
+
+		spanMap.getMeanLedColor(image, spanColors);
+		for (size_t i = 0; i < leds.size(); ++i)
+		{
+			if (indexColors[i].red != spanColors[i].red || indexColors[i].green != spanColors[i].green || indexColors[i].blue != spanColors[i].blue)
+			{
+				std::cout << "Mismatch at led " << i << ": " << indexColors[i] << " != " << spanColors[i] << std::endl;
+				result = 1;
+				break;
+			}
+			if (indexColors[i].red != integralColors[i].red || indexColors[i].green != integralColors[i].green || indexColors[i].blue != integralColors[i].blue)
+			{
+				std::cout << "Integral mismatch at led " << i << ": " << indexColors[i] << " != " << integralColors[i] << std::endl;
+				result = 1;
+				break;
+			}
+		}
+
+		std::cout << width << "x" << height
+				  << " index: " << indexMs << " ms (" << indexMap.indexBytes() / 1024 << " KiB)"
+				  << " span: " << spanMs << " ms"
+				  << " uni: " << uniMs << " ms"
+				  << " integral: " << integralMs << " ms"
+				  << " speedup: " << indexMs / spanMs << "x" << std::endl;
+	}
+
+	return result;
+}
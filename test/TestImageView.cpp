@@ -0,0 +1,94 @@
+// STL includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Utils includes
+#include <utils/Image.h>
+#include <utils/ColorRgb.h>
+
+// Hyperion includes
+#include <hyperion/ImageToLedsMap.h>
+#include <hyperion/IntegralImage.h>
+#include <hyperion/LedString.h>
+
+#include "TestCheck.h"
+
+int main()
+{
+	const unsigned width = 301;
+	const unsigned height = 97;
+	// rows padded to a multiple of 4 bytes like a QImage or a capture buffer
+	const size_t stride = (width * sizeof(ColorRgb) + 3) & ~size_t(3);
+
+	std::vector<uint8_t> buffer(stride * height);
+	for (uint8_t& byte : buffer)
+	{
+		byte = uint8_t(std::rand());
+	}
+	const std::vector<uint8_t> original = buffer;
+
+	// packed reference copy
+	Image<ColorRgb> packed(width, height);
+	for (unsigned y = 0; y < height; ++y)
+	{
+		memcpy(&packed(0, y), buffer.data() + y * stride, width * sizeof(ColorRgb));
+	}
+
+	int result = 0;
+
+	const Image<ColorRgb> view(reinterpret_cast<const ColorRgb*>(buffer.data()), width, height, stride);
+	result |= check(view.isBorrowed() && view.stride() == stride, "view refers to the buffer");
+	result |= check(view(width - 1, height - 1) == packed(width - 1, height - 1) && view.row(7)[5] == packed(5, 7), "pixel access honours the stride");
+	const unsigned index = 7 * width + 5;
+	result |= check(view.red(index) == packed(5, 7).red && view.green(index) == packed(5, 7).green && view.blue(index) == packed(5, 7).blue, "channel access honours the stride");
+	result |= check(view.size() == packed.size(), "size of the pixels without padding");
+
+	// the led mapping reads the view directly
+	std::vector<Led> leds;
+	for (unsigned i = 0; i < 10; ++i)
+	{
+		leds.push_back({i / 10.0, (i + 1) / 10.0, 0.0, 0.2, ColorOrder::ORDER_RGB});
+		leds.push_back({0.0, 0.1, i / 10.0, (i + 1) / 10.0, ColorOrder::ORDER_RGB});
+	}
+	const hyperion::ImageToLedsMap map(width, height, 0, 0, leds);
+	std::vector<ColorRgb> viewColors(leds.size()), packedColors(leds.size());
+	map.getMeanLedColor(view, viewColors);
+	map.getMeanLedColor(packed, packedColors);
+	result |= check(viewColors == packedColors, "led colors of the view");
+	map.getUniLedColor(view, viewColors);
+	map.getUniLedColor(packed, packedColors);
+	result |= check(viewColors == packedColors, "mean color of the view");
+
+	hyperion::IntegralImage viewIntegral, packedIntegral;
+	viewIntegral.update(view);
+	packedIntegral.update(packed);
+	const hyperion::IntegralImage::Entry viewSum = viewIntegral.sum(3, 4, 250, 90);
+	const hyperion::IntegralImage::Entry packedSum = packedIntegral.sum(3, 4, 250, 90);
+	result |= check(viewSum.red == packedSum.red && viewSum.green == packedSum.green && viewSum.blue == packedSum.blue, "integral image of the view");
+	result |= check(view.isBorrowed(), "reading does not copy");
+
+	// keeping the image copies the pixels once, further copies share them
+	const Image<ColorRgb> kept = view;
+	const Image<ColorRgb> keptAgain = view;
+	result |= check(!view.isBorrowed() && !kept.isBorrowed(), "copy owns the pixels");
+	result |= check(kept.memptr() == keptAgain.memptr() && kept.stride() == width * sizeof(ColorRgb), "copies share one packed buffer");
+	result |= check(memcmp(kept.memptr(), packed.memptr(), width * height * sizeof(ColorRgb)) == 0, "copy holds the pixels");
+
+	// writing a view never touches the borrowed memory
+	Image<ColorRgb> written(reinterpret_cast<const ColorRgb*>(buffer.data()), width, height, stride);
+	written(0, 0) = ColorRgb::RED;
+	written.resize(10, 10);
+	result |= check(!written.isBorrowed() && buffer == original, "write access copies the pixels");
+
+	// a moved view stays a view
+	Image<ColorRgb> moved(std::move(Image<ColorRgb>(reinterpret_cast<const ColorRgb*>(buffer.data()), width, height, stride)));
+	result |= check(moved.isBorrowed() && moved(1, 1) == packed(1, 1), "moved view");
+
+	Image<ColorRgb> converted;
+	moved.toRgb(converted);
+	result |= check(memcmp(converted.memptr(), packed.memptr(), width * height * sizeof(ColorRgb)) == 0, "conversion of a view");
+
+	std::cout << (result == 0 ? "image views ok" : "image views failed") << std::endl;
+	return result;
+}
@@ -0,0 +1,71 @@
+// STL includes
+#include <cstdlib>
+#include <iostream>
+
+// Utils includes
+#include <utils/Image.h>
+#include <utils/ColorRgb.h>
+#include <utils/LatencyTracker.h>
+
+#include "TestCheck.h"
+
+int main()
+{
+	int result = 0;
+
+	// buckets are exact for small latencies and within 4% above
+	bool exact = true;
+	bool accurate = true;
+	for (int64_t latency = 0; latency < (int64_t(1) << 27); latency += (latency < 1000) ? 1 : latency / 97)
+	{
+		const size_t bucket = LatencyTracker::bucketOf(latency);
+		const int64_t mid = LatencyTracker::latencyOf(bucket);
+		exact &= latency >= 32 || mid == latency;
+		accurate &= std::llabs(mid - latency) * 25 <= latency && LatencyTracker::bucketOf(mid) == bucket;
+	}
+	result |= check(exact, "small latencies are exact");
+	result |= check(accurate, "bucket error below 4%");
+	result |= check(LatencyTracker::bucketOf(-5) == 0 && LatencyTracker::bucketOf(int64_t(1) << 40) == LatencyTracker::BUCKETS - 1, "out of range latencies are clamped");
+
+	// percentiles of 1..1000 ms
+	LatencyTracker tracker;
+	const int64_t now = LatencyTracker::now();
+	for (int i = 1; i <= 1000; ++i)
+	{
+		tracker.record(LatencyTracker::DEVICE, now - i * 1000);
+	}
+	tracker.record(LatencyTracker::DEVICE, 0);
+	const LatencyTracker::Summary summary = tracker.summary(LatencyTracker::DEVICE);
+	result |= check(summary.count == 1000, "unknown capture times are not recorded");
+	result |= check(std::llabs(summary.p50 - 500000) < 25000, "p50");
+	result |= check(std::llabs(summary.p95 - 950000) < 45000, "p95");
+	result |= check(std::llabs(summary.p99 - 990000) < 45000, "p99");
+	result |= check(summary.max >= 1000000 && summary.p99 <= summary.max, "max");
+	result |= check(tracker.summary(LatencyTracker::MUXER).count == 0, "stages are separate");
+
+	// a handed over frame is taken once, superseded frames are dropped
+	tracker.handOver(LatencyTracker::SMOOTHING, 1);
+	tracker.handOver(LatencyTracker::SMOOTHING, 2);
+	result |= check(tracker.takeOver(LatencyTracker::SMOOTHING) == 2, "latest frame is handed over");
+	result |= check(tracker.takeOver(LatencyTracker::SMOOTHING) == 0, "frame is taken once");
+
+	tracker.reset();
+	result |= check(tracker.summary(LatencyTracker::DEVICE).count == 0 && tracker.summary(LatencyTracker::DEVICE).max == 0, "reset");
+
+	// the capture time is kept by copies and conversions
+	Image<ColorRgb> image(64, 36);
+	image.setCaptureTime(now);
+	Image<ColorRgb> copy = image;
+	copy.memptr()[0] = ColorRgb::RED;
+	Image<ColorRgb> converted;
+	image.toRgb(converted);
+	result |= check(copy.captureTime() == now && converted.captureTime() == now, "capture time is kept");
+
+	const ColorRgb pixels[4] = {ColorRgb::RED, ColorRgb::GREEN, ColorRgb::BLUE, ColorRgb::WHITE};
+	Image<ColorRgb> view(pixels, 2, 2);
+	view.setCaptureTime(now);
+	Image<ColorRgb> kept = view;
+	result |= check(kept.captureTime() == now && !kept.isBorrowed(), "capture time of a view is kept");
+
+	return result;
+}
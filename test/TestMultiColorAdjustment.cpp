@@ -0,0 +1,264 @@
+// STL includes
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Utils includes
+#include <utils/ColorRgb.h>
+
+// Hyperion includes
+#include <hyperion/ColorAdjustment.h>
+#include <hyperion/MultiColorAdjustment.h>
+
+namespace {
+
+///
+/// Per led color adjustment as used before the channel tables of MultiColorAdjustment. It is
+/// kept here as reference for correctness and speed.
+///
+void legacyAdjustment(ColorAdjustment* adjustment, ColorRgb& color)
+{
+	uint8_t ored   = color.red;
+	uint8_t ogreen = color.green;
+	uint8_t oblue  = color.blue;
+	uint8_t B_RGB = 0, B_CMY = 0, B_W = 0;
+
+	adjustment->_rgbTransform.transform(ored,ogreen,oblue);
+	adjustment->_rgbTransform.getBrightnessComponents(B_RGB, B_CMY, B_W);
+
+	uint32_t nrng = (uint32_t) (255-ored)*(255-ogreen);
+	uint32_t rng  = (uint32_t) (ored)    *(255-ogreen);
+	uint32_t nrg  = (uint32_t) (255-ored)*(ogreen);
+	uint32_t rg   = (uint32_t) (ored)    *(ogreen);
+
+	uint8_t black   = nrng*(255-oblue)/65025;
+	uint8_t red     = rng *(255-oblue)/65025;
+	uint8_t green   = nrg *(255-oblue)/65025;
+	uint8_t blue    = nrng*(oblue)    /65025;
+	uint8_t cyan    = nrg *(oblue)    /65025;
+	uint8_t magenta = rng *(oblue)    /65025;
+	uint8_t yellow  = rg  *(255-oblue)/65025;
+	uint8_t white   = rg  *(oblue)    /65025;
+
+	uint8_t OR, OG, OB, RR, RG, RB, GR, GG, GB, BR, BG, BB;
+	uint8_t CR, CG, CB, MR, MG, MB, YR, YG, YB, WR, WG, WB;
+
+	adjustment->_rgbBlackAdjustment.apply  (black  , 255  , OR, OG, OB);
+	adjustment->_rgbRedAdjustment.apply    (red    , B_RGB, RR, RG, RB);
+	adjustment->_rgbGreenAdjustment.apply  (green  , B_RGB, GR, GG, GB);
+	adjustment->_rgbBlueAdjustment.apply   (blue   , B_RGB, BR, BG, BB);
+	adjustment->_rgbCyanAdjustment.apply   (cyan   , B_CMY, CR, CG, CB);
+	adjustment->_rgbMagentaAdjustment.apply(magenta, B_CMY, MR, MG, MB);
+	adjustment->_rgbYellowAdjustment.apply (yellow , B_CMY, YR, YG, YB);
+	adjustment->_rgbWhiteAdjustment.apply  (white  , B_W  , WR, WG, WB);
+
+	color.red   = OR + RR + GR + BR + CR + MR + YR + WR;
+	color.green = OG + RG + GG + BG + CG + MG + YG + WG;
+	color.blue  = OB + RB + GB + BB + CB + MB + YB + WB;
+}
+
+struct Config
+{
+	const char* name;
+	double gamma[3];
+	double backlightThreshold;
+	bool backlightColored;
+	uint8_t brightness;
+	uint8_t brightnessCompensation;
+	bool randomChannels;
+};
+
+ColorAdjustment* createAdjustment(const Config& config)
+{
+	ColorAdjustment* adjustment = new ColorAdjustment();
+	adjustment->_id = config.name;
+
+	const uint8_t corners[8][3] = { {0,0,0}, {255,0,0}, {0,255,0}, {0,0,255}, {0,255,255}, {255,0,255}, {255,255,0}, {255,255,255} };
+	RgbChannelAdjustment* channels[8] = {
+		&adjustment->_rgbBlackAdjustment, &adjustment->_rgbRedAdjustment, &adjustment->_rgbGreenAdjustment, &adjustment->_rgbBlueAdjustment,
+		&adjustment->_rgbCyanAdjustment, &adjustment->_rgbMagentaAdjustment, &adjustment->_rgbYellowAdjustment, &adjustment->_rgbWhiteAdjustment
+	};
+	for (int i = 0; i < 8; ++i)
+	{
+		if (config.randomChannels)
+		{
+			channels[i]->setAdjustment(uint8_t(std::rand()), uint8_t(std::rand()), uint8_t(std::rand()));
+		}
+		else
+		{
+			channels[i]->setAdjustment(corners[i][0], corners[i][1], corners[i][2]);
+		}
+	}
+
+	adjustment->_rgbTransform = RgbTransform(config.gamma[0], config.gamma[1], config.gamma[2],
+			config.backlightThreshold, config.backlightColored, config.brightness, config.brightnessCompensation);
+	return adjustment;
+}
+
+/// Color byte order correction as done per led in Hyperion::update() before the color order runs
+void legacyColorOrder(ColorOrder order, ColorRgb& color)
+{
+	switch (order)
+	{
+	case ColorOrder::ORDER_RGB:
+		break;
+	case ColorOrder::ORDER_BGR:
+		std::swap(color.red, color.blue);
+		break;
+	case ColorOrder::ORDER_RBG:
+		std::swap(color.green, color.blue);
+		break;
+	case ColorOrder::ORDER_GRB:
+		std::swap(color.red, color.green);
+		break;
+	case ColorOrder::ORDER_GBR:
+		std::swap(color.red, color.green);
+		std::swap(color.green, color.blue);
+		break;
+	case ColorOrder::ORDER_BRG:
+		std::swap(color.red, color.blue);
+		std::swap(color.green, color.blue);
+		break;
+	}
+}
+
+/// Adjustment and color order in one pass must match the separate passes
+int testColorOrderRuns()
+{
+	const ColorOrder orders[] = { ColorOrder::ORDER_RGB, ColorOrder::ORDER_RBG, ColorOrder::ORDER_GRB, ColorOrder::ORDER_BRG, ColorOrder::ORDER_GBR, ColorOrder::ORDER_BGR };
+	const int ledCount = 3000;
+
+	LedString ledString;
+	for (int i = 0; i < ledCount; ++i)
+	{
+		// runs of varying length of all orders
+		ledString.leds().push_back({0.0, 1.0, 0.0, 1.0, orders[(i / (1 + i % 7)) % 6]});
+	}
+	const std::vector<ColorOrderRun> runs = ledString.colorOrderRuns();
+
+	const Config config = { "color order", {1.5, 1.5, 1.5}, 0.0, false, 100, 100, false };
+	MultiColorAdjustment adjustment(ledCount);
+	adjustment.addAdjustment(createAdjustment(config));
+	adjustment.setAdjustmentForLed(config.name, 0, ledCount - 1);
+
+	std::vector<ColorRgb> expected(ledCount);
+	for (ColorRgb& color : expected)
+	{
+		color = ColorRgb{ uint8_t(std::rand()), uint8_t(std::rand()), uint8_t(std::rand()) };
+	}
+	std::vector<ColorRgb> actual = expected;
+
+	adjustment.applyAdjustment(expected);
+	for (int i = 0; i < ledCount; ++i)
+	{
+		legacyColorOrder(ledString.leds()[i].colorOrder, expected[i]);
+	}
+
+	adjustment.applyAdjustment(actual, runs);
+
+	for (int i = 0; i < ledCount; ++i)
+	{
+		if (expected[i] != actual[i])
+		{
+			std::cout << "Color order mismatch at led " << i << ": " << expected[i] << " != " << actual[i] << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "color order: " << runs.size() << " runs for " << ledCount << " leds match" << std::endl;
+	return 0;
+}
+
+} // namespace
+
+int main()
+{
+	const Config configs[] = {
+		{ "default",           {1.5, 1.5, 1.5}, 0.0,  false, 100, 100, false },
+		{ "linear",            {1.0, 1.0, 1.0}, 0.0,  false, 100,   0, false },
+		{ "dimmed",            {2.2, 1.8, 2.0}, 0.0,  false,  35,  60, false },
+		{ "backlight",         {1.5, 1.5, 1.5}, 20.0, false,  80, 100, false },
+		{ "backlight colored", {1.5, 1.5, 1.5}, 35.0, true,   80, 100, false },
+		{ "random channels",   {1.3, 1.7, 2.1}, 10.0, true,   90,  50, true  },
+	};
+
+	// one led per red/green combination, blue is iterated
+	const int ledCount = 256 * 256;
+
+	int result = 0;
+	for (const Config& config : configs)
+	{
+		ColorAdjustment* reference = createAdjustment(config);
+
+		MultiColorAdjustment adjustment(ledCount);
+		adjustment.addAdjustment(new ColorAdjustment(*reference));
+		adjustment.setAdjustmentForLed(config.name, 0, ledCount - 1);
+
+		std::vector<ColorRgb> input(ledCount);
+		std::vector<ColorRgb> expected(ledCount);
+		std::vector<ColorRgb> actual(ledCount);
+
+		std::chrono::duration<double, std::milli> legacyTime(0), tableTime(0);
+		uint64_t mismatches = 0;
+		int maxError = 0;
+
+		// exhaustive: every 24 bit input color
+		for (int blue = 0; blue < 256; ++blue)
+		{
+			for (int i = 0; i < ledCount; ++i)
+			{
+				input[i] = ColorRgb{ uint8_t(i & 0xFF), uint8_t(i >> 8), uint8_t(blue) };
+			}
+
+			expected = input;
+			auto start = std::chrono::steady_clock::now();
+			for (ColorRgb& color : expected)
+			{
+				legacyAdjustment(reference, color);
+			}
+			legacyTime += std::chrono::steady_clock::now() - start;
+
+			actual = input;
+			start = std::chrono::steady_clock::now();
+			adjustment.applyAdjustment(actual);
+			tableTime += std::chrono::steady_clock::now() - start;
+
+			for (int i = 0; i < ledCount; ++i)
+			{
+				const int errors[3] = {
+					std::abs(int(expected[i].red)   - int(actual[i].red)),
+					std::abs(int(expected[i].green) - int(actual[i].green)),
+					std::abs(int(expected[i].blue)  - int(actual[i].blue))
+				};
+				for (int error : errors)
+				{
+					maxError = std::max(maxError, error);
+					if (error > 1 && mismatches++ == 0)
+					{
+						std::cout << "Mismatch for " << input[i] << ": " << expected[i] << " != " << actual[i] << std::endl;
+					}
+				}
+			}
+		}
+
+		if (mismatches > 0)
+		{
+			result = 1;
+		}
+
+		std::cout << config.name << ": max error " << maxError << ", mismatches " << mismatches
+				  << ", legacy " << legacyTime.count() << " ms, tables " << tableTime.count() << " ms"
+				  << ", speedup " << legacyTime.count() / tableTime.count() << "x" << std::endl;
+
+		delete reference;
+	}
+
+	if (testColorOrderRuns() != 0)
+	{
+		result = 1;
+	}
+
+	return result;
+}
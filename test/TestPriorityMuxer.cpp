@@ -0,0 +1,141 @@
+// STL includes
+#include <iostream>
+#include <vector>
+
+// Qt includes
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+
+// Hyperion includes
+#include <hyperion/PriorityMuxer.h>
+
+#include "TestCheck.h"
+
+/// Runs the event loop for the given time, the muxer handles its timeouts meanwhile
+static void wait(int ms)
+{
+	QEventLoop loop;
+	QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+	loop.exec();
+}
+
+/// Compares the published snapshot with the state of the muxer
+static bool snapshotMatches(const PriorityMuxer& muxer)
+{
+	const PriorityMuxer::SnapshotPtr snapshot = muxer.getSnapshot();
+	if (snapshot->getPriorities() != muxer.getPriorities() || snapshot->currentPriority != muxer.getCurrentPriority())
+	{
+		return false;
+	}
+
+	for (int priority : muxer.getPriorities())
+	{
+		const PriorityMuxer::InputInfo expected = muxer.getInputInfo(priority);
+		const PriorityMuxer::InputInfo& published = snapshot->getInputInfo(priority);
+		if (published.priority != expected.priority
+			|| published.timeoutTime_ms != expected.timeoutTime_ms
+			|| published.componentId != expected.componentId
+			|| published.ledColors != expected.ledColors)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	int result = 0;
+	const std::vector<ColorRgb> colors(10, ColorRgb::RED);
+	const std::vector<ColorRgb> otherColors(10, ColorRgb::BLUE);
+
+	PriorityMuxer muxer(10, nullptr);
+
+	hyperion::Components visibleComponent = hyperion::COMP_INVALID;
+	int timeRunnerCount = 0;
+	QObject::connect(&muxer, &PriorityMuxer::visibleComponentChanged, [&](hyperion::Components comp) { visibleComponent = comp; });
+	QObject::connect(&muxer, &PriorityMuxer::timeRunner, [&]() { ++timeRunnerCount; });
+
+	// the priorities in the order they disappear
+	QList<int> knownPriorities = muxer.getPriorities();
+	QList<int> removedPriorities;
+	QObject::connect(&muxer, &PriorityMuxer::prioritiesChanged, [&]() {
+		const QList<int> priorities = muxer.getPriorities();
+		for (int priority : knownPriorities)
+		{
+			if (!priorities.contains(priority))
+				removedPriorities.append(priority);
+		}
+		knownPriorities = priorities;
+	});
+
+	// a color followed by an effect on the same priority, like the web UI does
+	muxer.registerInput(1, hyperion::COMP_COLOR, "test");
+	muxer.setInput(1, colors, -1);
+	result |= check(visibleComponent == hyperion::COMP_COLOR, "the color is the visible component");
+	result |= check(snapshotMatches(muxer), "snapshot after setInput");
+
+	muxer.registerInput(1, hyperion::COMP_EFFECT, "test");
+	muxer.setInput(1, otherColors, -1);
+	result |= check(visibleComponent == hyperion::COMP_EFFECT, "the effect replaces the color as visible component");
+	result |= check(snapshotMatches(muxer), "snapshot after an update");
+
+	// a timed color keeps its time runner across a disable/enable cycle
+	muxer.registerInput(2, hyperion::COMP_COLOR, "test");
+	muxer.setInput(2, colors, 10000);
+	muxer.setEnable(false);
+	muxer.setEnable(true);
+
+	timeRunnerCount = 0;
+	wait(1500);
+	result |= check(timeRunnerCount > 0, "the time runner of a timed color resumes after enable");
+
+	// the channels time out in the order of their deadlines, not of their setInput() calls
+	muxer.registerInput(10, hyperion::COMP_COLOR, "test");
+	muxer.registerInput(11, hyperion::COMP_COLOR, "test");
+	muxer.registerInput(12, hyperion::COMP_COLOR, "test");
+	muxer.setInput(10, colors, 600);
+	muxer.setInput(11, colors, 200);
+	muxer.setInput(12, colors, 400);
+	knownPriorities = muxer.getPriorities();
+	removedPriorities.clear();
+	wait(1000);
+	result |= check(removedPriorities == QList<int>({11, 12, 10}), "timeouts in the order of their deadlines");
+	result |= check(snapshotMatches(muxer), "snapshot after a timeout");
+
+	// a new timeout replaces the earlier deadline of the channel
+	muxer.registerInput(20, hyperion::COMP_COLOR, "test");
+	muxer.setInput(20, colors, 200);
+	muxer.setInput(20, colors, 700);
+	wait(450);
+	result |= check(muxer.hasPriority(20), "an extended timeout is kept");
+	wait(600);
+	result |= check(!muxer.hasPriority(20), "an extended timeout expires");
+
+	// a channel updated with a new timeout per frame drops the outdated deadlines, those of other channels stay
+	muxer.registerInput(30, hyperion::COMP_IMAGE, "test");
+	muxer.registerInput(31, hyperion::COMP_COLOR, "test");
+	muxer.setInput(31, colors, 400);
+	for (int i = 0; i < 200; ++i)
+	{
+		muxer.setInput(30, colors, 5000 + i);
+	}
+	muxer.setInput(30, colors, 200);
+	knownPriorities = muxer.getPriorities();
+	removedPriorities.clear();
+	wait(800);
+	result |= check(removedPriorities == QList<int>({30, 31}), "timeouts after dropping the outdated deadlines");
+	result |= check(snapshotMatches(muxer), "snapshot after the timeouts");
+
+	// clearing a channel publishes its removal
+	muxer.clearInput(2);
+	result |= check(!muxer.getSnapshot()->hasPriority(2) && snapshotMatches(muxer), "snapshot after clearInput");
+	muxer.clearInput(1);
+	result |= check(muxer.getSnapshot()->currentPriority == PriorityMuxer::LOWEST_PRIORITY && snapshotMatches(muxer), "snapshot of the lowest priority");
+
+	std::cout << (result == 0 ? "priority muxer ok" : "priority muxer failed") << std::endl;
+	return result;
+}
@@ -0,0 +1,157 @@
+// STL includes
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Hyperion includes
+#include <utils/ColorSys.h>
+#include <utils/ImageResampler.h>
+#include <utils/ResamplerKernels.h>
+
+#include "TestCheck.h"
+
+namespace {
+
+bool equal(const std::vector<ColorRgb>& a, const std::vector<ColorRgb>& b)
+{
+	return std::memcmp(a.data(), b.data(), a.size() * sizeof(ColorRgb)) == 0;
+}
+
+} // namespace
+
+int main()
+{
+	const std::vector<ResamplerKernels> variants = availableResamplerKernels();
+	int result = 0;
+
+	std::srand(42);
+
+	// the BT.601 matrix converts like the former per pixel code
+	{
+		const YuvCoefficients& matrix = yuvCoefficients(YuvMatrix::BT601);
+		bool same = true;
+		for (int y = 0; y < 256; ++y)
+		{
+			for (int u = 0; u < 256; u += 3)
+			{
+				for (int v = 0; v < 256; v += 5)
+				{
+					ColorRgb rgb;
+					uint8_t r, g, b;
+					yuvToRgb(matrix, uint8_t(y), uint8_t(u), uint8_t(v), rgb);
+					ColorSys::yuv2rgb(uint8_t(y), uint8_t(u), uint8_t(v), r, g, b);
+					same &= rgb.red == r && rgb.green == g && rgb.blue == b;
+				}
+			}
+		}
+		result |= check(same, "BT.601 matches ColorSys::yuv2rgb");
+	}
+
+	// every variant converts like the scalar kernels, odd counts cover the scalar remainders
+	for (size_t count : { 0, 1, 7, 8, 15, 16, 17, 33, 1921 })
+	{
+		std::vector<uint8_t> source(count * 4);
+		for (uint8_t& byte : source)
+		{
+			byte = uint8_t(std::rand());
+		}
+
+		for (YuvMatrix yuvMatrix : { YuvMatrix::BT601, YuvMatrix::BT709 })
+		{
+			const YuvCoefficients& matrix = yuvCoefficients(yuvMatrix);
+			std::vector<ColorRgb> reference(count + 1), out(count + 1);
+
+			for (const ResamplerKernels& kernels : variants)
+			{
+				const std::string suffix = std::string(" of ") + kernels.name + " for " + std::to_string(count) + " pixels";
+
+				variants.front().yuyvToRgb(source.data(), reference.data(), count, matrix);
+				kernels.yuyvToRgb(source.data(), out.data(), count, matrix);
+				result |= check(equal(out, reference), "yuyvToRgb" + suffix);
+
+				variants.front().uyvyToRgb(source.data(), reference.data(), count, matrix);
+				kernels.uyvyToRgb(source.data(), out.data(), count, matrix);
+				result |= check(equal(out, reference), "uyvyToRgb" + suffix);
+			}
+		}
+
+		std::vector<ColorRgb> reference(count + 1), out(count + 1);
+		for (const ResamplerKernels& kernels : variants)
+		{
+			const std::string suffix = std::string(" of ") + kernels.name + " for " + std::to_string(count) + " pixels";
+
+			variants.front().bgr32ToRgb(source.data(), reference.data(), count);
+			kernels.bgr32ToRgb(source.data(), out.data(), count);
+			result |= check(equal(out, reference), "bgr32ToRgb" + suffix);
+
+			variants.front().rgb32ToRgb(source.data(), reference.data(), count);
+			kernels.rgb32ToRgb(source.data(), out.data(), count);
+			result |= check(equal(out, reference), "rgb32ToRgb" + suffix);
+		}
+	}
+
+	// the planar formats read their chroma from the planes behind the luma plane
+	{
+		const int width = 6;
+		const int height = 4;
+		const int lineLength = 8;
+		std::vector<uint8_t> nv12(lineLength * height * 3 / 2), i420(lineLength * height * 3 / 2);
+		for (size_t i = 0; i < nv12.size(); ++i)
+		{
+			nv12[i] = i420[i] = uint8_t(std::rand());
+		}
+
+		ImageResampler resampler;
+		resampler.setYuvMatrix(YuvMatrix::BT709);
+		const YuvCoefficients& matrix = yuvCoefficients(YuvMatrix::BT709);
+
+		Image<ColorRgb> outNv12, outI420;
+		resampler.processImage(nv12.data(), width, height, lineLength, PixelFormat::NV12, outNv12);
+		resampler.processImage(i420.data(), width, height, lineLength, PixelFormat::I420, outI420);
+
+		bool sameNv12 = true, sameI420 = true;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const uint8_t luma = nv12[y * lineLength + x];
+				const uint8_t* uv = nv12.data() + lineLength * height + (y / 2) * lineLength + (x / 2) * 2;
+				const uint8_t* u = i420.data() + lineLength * height + (y / 2) * (lineLength / 2) + x / 2;
+				const uint8_t* v = u + (lineLength / 2) * (height / 2);
+
+				ColorRgb expected;
+				yuvToRgb(matrix, luma, uv[0], uv[1], expected);
+				sameNv12 &= expected == outNv12(x, y);
+				yuvToRgb(matrix, luma, *u, *v, expected);
+				sameI420 &= expected == outI420(x, y);
+			}
+		}
+		result |= check(sameNv12, "NV12 conversion");
+		result |= check(sameI420, "I420 conversion");
+	}
+
+	// timing of a 1080p YUYV frame
+	{
+		const size_t count = 1920;
+		std::vector<uint8_t> source(count * 2);
+		std::vector<ColorRgb> out(count);
+		const YuvCoefficients& matrix = yuvCoefficients(YuvMatrix::BT601);
+
+		for (const ResamplerKernels& kernels : variants)
+		{
+			const int iterations = 100;
+			const auto begin = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations * 1080; ++i)
+			{
+				kernels.yuyvToRgb(source.data(), out.data(), count, matrix);
+			}
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+			std::cout << kernels.name << ": " << elapsed.count() / iterations << " ms per frame" << std::endl;
+		}
+	}
+
+	std::cout << (result == 0 ? "resampler kernels ok" : "resampler kernels failed") << std::endl;
+	return result;
+}
@@ -0,0 +1,195 @@
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Hyperion includes
+#include <hyperion/SmoothingKernels.h>
+
+#include "TestCheck.h"
+
+using namespace hyperion;
+
+namespace {
+
+// The floating point smoothing code the fixed point kernels replace, the golden reference
+
+long clampRounded(const float x)
+{
+	return std::min(255L, std::max(0L, std::lroundf(x)));
+}
+
+void linearStepFloat(std::vector<uint8_t>& previous, const std::vector<uint8_t>& target, float k)
+{
+	for (size_t i = 0; i < previous.size(); ++i)
+	{
+		const int diff = target[i] - previous[i];
+		previous[i] += (diff < 0 ? -1:1) * std::ceil(k * std::abs(diff));
+	}
+}
+
+void ditherFloat(const std::vector<float>& mean, std::vector<float>& residual, std::vector<uint8_t>& out)
+{
+	for (size_t i = 0; i < mean.size(); ++i)
+	{
+		const float f = mean[i] + residual[i];
+		const long rounded = clampRounded(f);
+		out[i] = static_cast<uint8_t>(rounded);
+		residual[i] = f - rounded;
+	}
+}
+
+} // namespace
+
+int main()
+{
+	// 2000 leds, odd count to cover the scalar remainders of the vector kernels
+	const size_t count = 3 * 2001;
+	const std::vector<SmoothingKernels> variants = availableSmoothingKernels();
+	int result = 0;
+
+	std::srand(42);
+	std::vector<uint8_t> target(count), start(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		target[i] = uint8_t(std::rand());
+		start[i] = uint8_t(std::rand());
+	}
+
+	// linear: every variant moves like the scalar kernel, within one step of the float code
+	for (int64_t elapsed : { 0, 1, 999, 20000, 39999, 40000 })
+	{
+		const int64_t remaining = 40000;
+		const uint32_t k = uint32_t(std::min<int64_t>(65535, (elapsed * 65536 + remaining - 1) / remaining));
+
+		std::vector<uint8_t> golden = start;
+		linearStepFloat(golden, target, 1.0F - 1.0F * (remaining - elapsed) / remaining);
+
+		std::vector<uint8_t> reference = start;
+		variants.front().linearStep(reference.data(), target.data(), count, k);
+
+		int maxDeviation = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			maxDeviation = std::max(maxDeviation, std::abs(int(reference[i]) - int(golden[i])));
+		}
+		result |= check(maxDeviation <= 1, "linear step close to the float code, k = " + std::to_string(k));
+
+		for (const SmoothingKernels& kernels : variants)
+		{
+			std::vector<uint8_t> previous = start;
+			kernels.linearStep(previous.data(), target.data(), count, k);
+			result |= check(previous == reference, std::string("linear step of ") + kernels.name);
+		}
+	}
+
+	// normalization and rounding: sums of a smoothing window, 8 bit result as the float code
+	std::vector<uint64_t> sums(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		sums[i] = uint64_t(target[i]) * 200000 + uint64_t(std::rand() % 200000);
+	}
+	const double scale = 1.0 / 200000;
+	{
+		std::vector<int32_t> reference(count);
+		variants.front().normalize(sums.data(), reference.data(), count, 0, float(scale * 65536));
+
+		int maxDeviation = 0;
+		std::vector<uint8_t> rounded(count);
+		variants.front().round(reference.data(), rounded.data(), count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			maxDeviation = std::max(maxDeviation, std::abs(int(rounded[i]) - int(clampRounded(float(sums[i] * scale)))));
+		}
+		result |= check(maxDeviation <= 1, "rounded mean close to the float code");
+
+		for (const SmoothingKernels& kernels : variants)
+		{
+			std::vector<int32_t> mean(count);
+			kernels.normalize(sums.data(), mean.data(), count, 0, float(scale * 65536));
+			result |= check(mean == reference, std::string("normalization of ") + kernels.name);
+
+			std::vector<int32_t> shifted(count);
+			kernels.normalize(sums.data(), shifted.data(), count, 3, float(scale * 65536 * 8));
+			std::vector<int32_t> shiftedReference(count);
+			variants.front().normalize(sums.data(), shiftedReference.data(), count, 3, float(scale * 65536 * 8));
+			result |= check(shifted == shiftedReference, std::string("shifted normalization of ") + kernels.name);
+
+			std::vector<uint8_t> out(count);
+			kernels.round(mean.data(), out.data(), count);
+			result |= check(out == rounded, std::string("rounding of ") + kernels.name);
+		}
+	}
+
+	// dithering: over a series of frames the output averages to the mean like the float code,
+	// including values which are clamped
+	std::vector<float> meanFloat(count);
+	std::vector<int32_t> meanFixed(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		meanFloat[i] = (i % 7 == 0) ? 255.75F - (i % 3) * 256.0F : (std::rand() % (255 * 256)) / 256.0F;
+		meanFixed[i] = int32_t(std::lround(meanFloat[i] * 65536));
+	}
+	const int frames = 64;
+	std::vector<float> residualFloat(count, 0.0F);
+	std::vector<long> totalFloat(count, 0);
+	std::vector<uint8_t> out(count);
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		ditherFloat(meanFloat, residualFloat, out);
+		for (size_t i = 0; i < count; ++i)
+		{
+			totalFloat[i] += out[i];
+		}
+	}
+
+	std::vector<long> totalReference;
+	for (const SmoothingKernels& kernels : variants)
+	{
+		std::vector<int32_t> residual(count, 0);
+		std::vector<long> total(count, 0);
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			kernels.dither(meanFixed.data(), residual.data(), out.data(), count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				total[i] += out[i];
+			}
+		}
+
+		if (totalReference.empty())
+		{
+			totalReference = total;
+			long maxDeviation = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				maxDeviation = std::max(maxDeviation, std::abs(total[i] - totalFloat[i]));
+			}
+			result |= check(maxDeviation <= 1, "dithered output sums like the float code");
+		}
+		result |= check(total == totalReference, std::string("dithering of ") + kernels.name);
+	}
+
+	// timing of one output frame of a 2000 led wall
+	for (const SmoothingKernels& kernels : variants)
+	{
+		std::vector<int32_t> mean(count), residual(count, 0);
+		std::vector<uint8_t> previous = start;
+		const int iterations = 10000;
+		const auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; ++i)
+		{
+			kernels.linearStep(previous.data(), target.data(), count, 1000);
+			kernels.normalize(sums.data(), mean.data(), count, 0, float(scale * 65536));
+			kernels.dither(mean.data(), residual.data(), out.data(), count);
+		}
+		const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - begin;
+		std::cout << kernels.name << ": " << elapsed.count() / iterations << " us per frame" << std::endl;
+	}
+
+	std::cout << (result == 0 ? "smoothing kernels ok" : "smoothing kernels failed") << std::endl;
+	return result;
+}
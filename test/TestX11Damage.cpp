@@ -0,0 +1,80 @@
+// STL includes
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+// Qt includes
+#include <QCoreApplication>
+
+// Hyperion includes
+#include <grabber/X11Grabber.h>
+
+#include "TestCheck.h"
+
+// Needs an X server, e.g. "xvfb-run test_x11damage"
+
+namespace {
+
+/// Grab until the grabber takes a frame, false if it did not within the time
+bool grabWithin(X11Grabber& grabber, Image<ColorRgb>& image, std::chrono::milliseconds time)
+{
+	const auto end = std::chrono::steady_clock::now() + time;
+	while (std::chrono::steady_clock::now() < end)
+	{
+		if (grabber.grabFrame(image) == 0)
+			return true;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	if (getenv("DISPLAY") == nullptr)
+	{
+		std::cout << "DISPLAY not set, skipped" << std::endl;
+		return 0;
+	}
+
+	int result = 0;
+
+	X11Grabber grabber(0, 0, 0, 0, 8);
+	if (!grabber.Setup())
+	{
+		std::cout << "Failed: X11 grabber setup" << std::endl;
+		return 1;
+	}
+
+	Image<ColorRgb> image(grabber.getImageWidth(), grabber.getImageHeight());
+	result |= check(grabber.grabFrame(image) == 0, "the first frame is grabbed");
+	result |= check(grabber.grabFrame(image) == 1, "an unchanged screen is not grabbed");
+	result |= check(grabber.grabFrame(image, true) == 0, "a forced frame is grabbed");
+
+	// draw on the root window through a connection of its own, like any other client
+	Display* display = XOpenDisplay(nullptr);
+	const Window root = DefaultRootWindow(display);
+	GC gc = XCreateGC(display, root, 0, nullptr);
+	XSetSubwindowMode(display, gc, IncludeInferiors);
+	XSetForeground(display, gc, WhitePixel(display, DefaultScreen(display)));
+	XFillRectangle(display, root, gc, 0, 0, 64, 64);
+	XSync(display, False);
+
+	result |= check(grabWithin(grabber, image, std::chrono::milliseconds(500)), "a damaged screen is grabbed");
+	result |= check(grabber.grabFrame(image) == 1, "the damage is reset by the grab");
+
+	XFreeGC(display, gc);
+	XCloseDisplay(display);
+
+	// the keep-alive frame of an unchanged screen
+	std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+	result |= check(grabber.grabFrame(image) == 0, "an unchanged screen is grabbed after a second");
+
+	std::cout << (result == 0 ? "x11 damage ok" : "x11 damage failed") << std::endl;
+	return result;
+}
@@ -0,0 +1,161 @@
+#include "Benchmark.h"
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Qt includes
+#include <QJsonArray>
+#include <QMap>
+
+// Hyperion includes
+#include <utils/CpuFeatures.h>
+#include <HyperionConfig.h>
+
+namespace {
+
+std::atomic<uint64_t> sink{0};
+
+double elapsedNs(const std::function<void()>& iteration, uint64_t iterations)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		iteration();
+	}
+	const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+double median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	const size_t middle = values.size() / 2;
+	return (values.size() % 2 != 0) ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+} // namespace
+
+Benchmark::Benchmark(int samples, double minSampleMs, const QRegularExpression& filter)
+	: _samples(std::max(1, samples))
+	, _minSampleNs(minSampleMs * 1e6)
+	, _filter(filter)
+{
+}
+
+void Benchmark::run(const QString& name, uint64_t items, const std::function<void()>& iteration)
+{
+	if (!_filter.match(name).hasMatch())
+	{
+		return;
+	}
+
+	// calibrate the batch size, this warms up the caches and the CPU clock as well
+	uint64_t iterations = 1;
+	double ns = elapsedNs(iteration, iterations);
+	while (ns < _minSampleNs && iterations < (1ULL << 40))
+	{
+		const double factor = (ns > 0) ? std::min(10.0, std::max(2.0, 1.2 * _minSampleNs / ns)) : 10.0;
+		iterations = static_cast<uint64_t>(std::ceil(iterations * factor));
+		ns = elapsedNs(iteration, iterations);
+	}
+
+	std::vector<double> perIteration;
+	perIteration.reserve(_samples);
+	for (int sample = 0; sample < _samples; ++sample)
+	{
+		perIteration.push_back(elapsedNs(iteration, iterations) / iterations);
+	}
+
+	Result result;
+	result.name = name;
+	result.items = items;
+	result.iterations = iterations;
+	result.medianNs = median(perIteration);
+	result.minNs = *std::min_element(perIteration.begin(), perIteration.end());
+
+	std::vector<double> deviations;
+	deviations.reserve(perIteration.size());
+	for (double value : perIteration)
+	{
+		deviations.push_back(std::abs(value - result.medianNs));
+	}
+	result.madNs = median(deviations);
+	result.baselineNs = 0;
+	_results.push_back(result);
+
+	fprintf(stderr, "%-48s %12.1f ns  +-%5.1f%%  %10.2f Mitems/s\n",
+			name.toLocal8Bit().constData(), result.medianNs, 100.0 * result.madNs / result.medianNs,
+			items * 1e3 / result.medianNs);
+}
+
+void Benchmark::consume(uint64_t value)
+{
+	sink.fetch_add(value, std::memory_order_relaxed);
+}
+
+QStringList Benchmark::compare(const QJsonObject& baseline, double threshold)
+{
+	QMap<QString, double> baselineNs;
+	for (const QJsonValue& entry : baseline["benchmarks"].toArray())
+	{
+		const QJsonObject benchmark = entry.toObject();
+		baselineNs[benchmark["name"].toString()] = benchmark["median_ns"].toDouble();
+	}
+
+	QStringList regressions;
+	for (Result& result : _results)
+	{
+		result.baselineNs = baselineNs.value(result.name, 0.0);
+		if (result.baselineNs <= 0)
+		{
+			continue;
+		}
+
+		const double change = result.medianNs / result.baselineNs - 1.0;
+		// a slowdown within the noise of the samples is no regression
+		const bool regressed = change > threshold && (result.medianNs - result.baselineNs) > 3 * result.madNs;
+		if (regressed)
+		{
+			regressions << result.name;
+		}
+
+		fprintf(stderr, "%-48s %12.1f ns  baseline %12.1f ns  %+7.1f%%%s\n",
+				result.name.toLocal8Bit().constData(), result.medianNs, result.baselineNs, 100.0 * change,
+				regressed ? "  REGRESSION" : "");
+	}
+	return regressions;
+}
+
+QJsonObject Benchmark::toJson() const
+{
+	QJsonArray benchmarks;
+	for (const Result& result : _results)
+	{
+		QJsonObject benchmark;
+		benchmark["name"] = result.name;
+		benchmark["items"] = static_cast<qint64>(result.items);
+		benchmark["iterations"] = static_cast<qint64>(result.iterations);
+		benchmark["median_ns"] = result.medianNs;
+		benchmark["min_ns"] = result.minNs;
+		benchmark["mad_ns"] = result.madNs;
+		benchmark["items_per_s"] = result.items * 1e9 / result.medianNs;
+		if (result.baselineNs > 0)
+		{
+			benchmark["baseline_ns"] = result.baselineNs;
+			benchmark["change"] = result.medianNs / result.baselineNs - 1.0;
+		}
+		benchmarks.append(benchmark);
+	}
+
+	QJsonObject report;
+	report["version"] = HYPERION_VERSION;
+	report["build"] = HYPERION_BUILD_ID;
+	report["cpu"] = CpuFeatures::featureString();
+	report["samples"] = _samples;
+	report["benchmarks"] = benchmarks;
+	return report;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// STL includes
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Qt includes
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+///
+/// Runs microbenchmarks and reports their timing as JSON.
+///
+/// A benchmark is calibrated to a batch of iterations taking at least the minimum sample time,
+/// then the batch is timed for a number of samples. The median of the samples is robust against
+/// scheduler outliers, their spread is given as median absolute deviation.
+///
+class Benchmark
+{
+public:
+	struct Result
+	{
+		QString name;
+		/// Work items per iteration, e.g. pixels or leds
+		uint64_t items;
+		/// Iterations per sample
+		uint64_t iterations;
+		double medianNs;
+		double minNs;
+		double madNs;
+		/// Median of the baseline, 0 if the baseline does not contain the benchmark
+		double baselineNs;
+	};
+
+	///
+	/// @param samples      The number of timed samples per benchmark
+	/// @param minSampleMs  The minimum duration of a sample
+	/// @param filter       Only benchmarks with a matching name are run
+	///
+	Benchmark(int samples, double minSampleMs, const QRegularExpression& filter);
+
+	///
+	/// @brief Time a benchmark if its name matches the filter and print the result to stderr
+	/// @param name       Unique name of the benchmark, e.g. "resampler/YUYV/1920x1080"
+	/// @param items      The work items processed by one iteration
+	/// @param iteration  One iteration of the benchmark
+	///
+	void run(const QString& name, uint64_t items, const std::function<void()>& iteration);
+
+	///
+	/// @brief Keep a computed value alive, so the compiler does not drop its computation
+	///
+	static void consume(uint64_t value);
+
+	///
+	/// @brief Compare the results with a previous report of this tool
+	/// @param baseline   The report of the baseline run
+	/// @param threshold  The relative slowdown of a regression, e.g. 0.1 for 10%
+	/// @return The names of the regressed benchmarks
+	///
+	QStringList compare(const QJsonObject& baseline, double threshold);
+
+	///
+	/// @brief The report of all results
+	///
+	QJsonObject toJson() const;
+
+private:
+	const int _samples;
+	const double _minSampleNs;
+	const QRegularExpression _filter;
+	std::vector<Result> _results;
+};
@@ -0,0 +1,520 @@
+// STL includes
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Qt includes
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+
+// flatbuffer includes
+#include <hyperion_request_generated.h>
+
+// Hyperion includes
+#include <blackborder/BlackBorderDetector.h>
+#include <commandline/Parser.h>
+#include <hyperion/ColorAdjustment.h>
+#include <hyperion/ImageToLedsMap.h>
+#include <hyperion/IntegralImage.h>
+#include <hyperion/LedString.h>
+#include <hyperion/MultiColorAdjustment.h>
+#include <hyperion/SmoothingKernels.h>
+#include <utils/ColorSys.h>
+#include <utils/ImageResampler.h>
+#include <utils/ResamplerKernels.h>
+#include <utils/RgbToRgbw.h>
+
+#include "Benchmark.h"
+
+using namespace commandline;
+
+namespace {
+
+// fixed seed, every run benchmarks the same data
+std::mt19937 rng(42);
+
+uint8_t randomByte()
+{
+	return static_cast<uint8_t>(rng());
+}
+
+std::vector<uint8_t> randomBytes(size_t size)
+{
+	std::vector<uint8_t> bytes(size);
+	for (uint8_t& byte : bytes)
+	{
+		byte = randomByte();
+	}
+	return bytes;
+}
+
+Image<ColorRgb> randomImage(unsigned width, unsigned height)
+{
+	Image<ColorRgb> image(width, height);
+	for (unsigned y = 0; y < height; ++y)
+	{
+		for (unsigned x = 0; x < width; ++x)
+		{
+			image(x, y) = ColorRgb{ randomByte(), randomByte(), randomByte() };
+		}
+	}
+	return image;
+}
+
+QString sizeName(unsigned width, unsigned height)
+{
+	return QString("%1x%2").arg(width).arg(height);
+}
+
+/// Classic frame layout with the given number of leds per side and a depth of 8% of the image
+std::vector<Led> createLeds(unsigned ledsPerSide, double depth = 0.08)
+{
+	std::vector<Led> leds;
+	for (unsigned i = 0; i < ledsPerSide; ++i)
+	{
+		const double begin = double(i) / ledsPerSide;
+		const double end   = double(i + 1) / ledsPerSide;
+		leds.push_back({begin, end, 0.0, depth, ColorOrder::ORDER_RGB});
+		leds.push_back({1.0 - depth, 1.0, begin, end, ColorOrder::ORDER_RGB});
+		leds.push_back({begin, end, 1.0 - depth, 1.0, ColorOrder::ORDER_RGB});
+		leds.push_back({0.0, depth, begin, end, ColorOrder::ORDER_RGB});
+	}
+	return leds;
+}
+
+void benchResampler(Benchmark& bench)
+{
+	const struct
+	{
+		PixelFormat format;
+		const char* name;
+		int bytesPerPixel;
+		/// Size of the frame in bytes per luma pixel, times 2
+		int frameSize;
+	} formats[] = {
+		{ PixelFormat::YUYV,  "YUYV",  2, 4 },
+		{ PixelFormat::UYVY,  "UYVY",  2, 4 },
+		{ PixelFormat::BGR16, "BGR16", 2, 4 },
+		{ PixelFormat::BGR24, "BGR24", 3, 6 },
+		{ PixelFormat::RGB32, "RGB32", 4, 8 },
+		{ PixelFormat::BGR32, "BGR32", 4, 8 },
+		{ PixelFormat::NV12,  "NV12",  1, 3 },
+		{ PixelFormat::I420,  "I420",  1, 3 },
+	};
+
+	const int width = 1920;
+	const int height = 1080;
+
+	for (const auto& format : formats)
+	{
+		const std::vector<uint8_t> frame = randomBytes(size_t(width) * height * format.frameSize / 2);
+
+		// full resolution and the usual size decimation of the USB capture
+		for (int decimation : { 1, 8 })
+		{
+			ImageResampler resampler;
+			resampler.setHorizontalPixelDecimation(decimation);
+			resampler.setVerticalPixelDecimation(decimation);
+			resampler.setCropping(0, 0, 0, 0);
+			resampler.setVideoMode(VideoMode::VIDEO_2D);
+
+			Image<ColorRgb> output;
+			resampler.processImage(frame.data(), width, height, width * format.bytesPerPixel, format.format, output);
+
+			bench.run(QString("resampler/%1/%2/d%3").arg(format.name, sizeName(width, height)).arg(decimation), output.width() * output.height(), [&]() {
+				resampler.processImage(frame.data(), width, height, width * format.bytesPerPixel, format.format, output);
+				Benchmark::consume(output.memptr()->red);
+			});
+		}
+	}
+}
+
+void benchResamplerKernels(Benchmark& bench)
+{
+	// a row of a 1080p frame
+	const size_t count = 1920;
+
+	const std::vector<uint8_t> row = randomBytes(count * 4);
+	std::vector<ColorRgb> out(count);
+	const YuvCoefficients& matrix = yuvCoefficients(YuvMatrix::BT601);
+
+	for (const ResamplerKernels& kernels : availableResamplerKernels())
+	{
+		const QString prefix = QString("resampler-kernels/%1/").arg(kernels.name);
+
+		bench.run(prefix + "yuyvToRgb", count, [&]() {
+			kernels.yuyvToRgb(row.data(), out.data(), count, matrix);
+			Benchmark::consume(out[0].red);
+		});
+		bench.run(prefix + "uyvyToRgb", count, [&]() {
+			kernels.uyvyToRgb(row.data(), out.data(), count, matrix);
+			Benchmark::consume(out[0].red);
+		});
+		bench.run(prefix + "bgr32ToRgb", count, [&]() {
+			kernels.bgr32ToRgb(row.data(), out.data(), count);
+			Benchmark::consume(out[0].red);
+		});
+		bench.run(prefix + "rgb32ToRgb", count, [&]() {
+			kernels.rgb32ToRgb(row.data(), out.data(), count);
+			Benchmark::consume(out[0].red);
+		});
+	}
+}
+
+void benchImageToLeds(Benchmark& bench)
+{
+	const std::vector<Led> leds = createLeds(80);
+	const unsigned sizes[][2] = { {240, 135}, {480, 270}, {1920, 1080} };
+
+	for (const auto& size : sizes)
+	{
+		const Image<ColorRgb> image = randomImage(size[0], size[1]);
+		const hyperion::ImageToLedsMap map(size[0], size[1], 0, 0, leds);
+		std::vector<ColorRgb> colors(leds.size());
+		hyperion::IntegralImage integral;
+
+		bench.run("image2leds/mean/" + sizeName(size[0], size[1]), leds.size(), [&]() {
+			map.getMeanLedColor(image, colors);
+			Benchmark::consume(colors[0].red);
+		});
+		bench.run("image2leds/uni/" + sizeName(size[0], size[1]), leds.size(), [&]() {
+			map.getUniLedColor(image, colors);
+			Benchmark::consume(colors[0].red);
+		});
+		bench.run("image2leds/integral/" + sizeName(size[0], size[1]), leds.size(), [&]() {
+			integral.update(image);
+			map.getIntegralLedColor(integral, colors);
+			Benchmark::consume(colors[0].red);
+		});
+	}
+
+	// the cost per pixel of both ways, their ratio is ImageToLedsMap::INTEGRAL_COST_PER_PIXEL
+	{
+		const unsigned width = 1920;
+		const unsigned height = 1080;
+		const Image<ColorRgb> image = randomImage(width, height);
+		hyperion::IntegralImage integral;
+
+		bench.run("integral/build/" + sizeName(width, height), uint64_t(width) * height, [&]() {
+			integral.update(image);
+			Benchmark::consume(integral.sum(0, 0, width, height).red);
+		});
+
+		// deep leds, each pixel is covered by about two of them
+		const std::vector<Led> overlapping = createLeds(80, 0.5);
+		const hyperion::ImageToLedsMap map(width, height, 0, 0, overlapping);
+		std::vector<ColorRgb> colors(overlapping.size());
+
+		bench.run("image2leds/mean-overlapping/" + sizeName(width, height), map.mappedPixelCount(), [&]() {
+			map.getMeanLedColor(image, colors);
+			Benchmark::consume(colors[0].red);
+		});
+	}
+}
+
+void benchColorAdjustment(Benchmark& bench)
+{
+	const int ledCount = 1000;
+
+	ColorAdjustment* adjustment = new ColorAdjustment();
+	adjustment->_id = "default";
+	adjustment->_rgbRedAdjustment.setAdjustment(255, 0, 0);
+	adjustment->_rgbGreenAdjustment.setAdjustment(0, 255, 0);
+	adjustment->_rgbBlueAdjustment.setAdjustment(0, 0, 255);
+	adjustment->_rgbCyanAdjustment.setAdjustment(0, 255, 255);
+	adjustment->_rgbMagentaAdjustment.setAdjustment(255, 0, 255);
+	adjustment->_rgbYellowAdjustment.setAdjustment(255, 255, 0);
+	adjustment->_rgbWhiteAdjustment.setAdjustment(255, 255, 255);
+	adjustment->_rgbTransform = RgbTransform(1.5, 1.5, 1.5, 0.0, false, 100, 100);
+
+	MultiColorAdjustment adjustments(ledCount);
+	adjustments.addAdjustment(adjustment);
+	adjustments.setAdjustmentForLed("default", 0, ledCount - 1);
+
+	LedString ledString;
+	for (int i = 0; i < ledCount; ++i)
+	{
+		// two strips with a different color order
+		ledString.leds().push_back({0.0, 1.0, 0.0, 1.0, i < ledCount / 2 ? ColorOrder::ORDER_RGB : ColorOrder::ORDER_GRB});
+	}
+	const std::vector<ColorOrderRun> runs = ledString.colorOrderRuns();
+
+	std::vector<ColorRgb> input(ledCount);
+	for (ColorRgb& color : input)
+	{
+		color = ColorRgb{ randomByte(), randomByte(), randomByte() };
+	}
+	std::vector<ColorRgb> colors = input;
+
+	bench.run("adjustment/apply/1000", ledCount, [&]() {
+		colors = input;
+		adjustments.applyAdjustment(colors);
+		Benchmark::consume(colors[0].red);
+	});
+	bench.run("adjustment/apply-order/1000", ledCount, [&]() {
+		colors = input;
+		adjustments.applyAdjustment(colors, runs);
+		Benchmark::consume(colors[0].red);
+	});
+}
+
+void benchSmoothingKernels(Benchmark& bench)
+{
+	// 1000 leds
+	const size_t count = 3 * 1000;
+
+	std::vector<uint8_t> targets[2] = { randomBytes(count), randomBytes(count) };
+	std::vector<uint8_t> previous = randomBytes(count);
+	std::vector<uint64_t> sums(count);
+	std::vector<int32_t> mean(count);
+	std::vector<int32_t> residual(count, 0);
+	std::vector<uint8_t> out(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		// 16 frames with a weight of 1024
+		sums[i] = static_cast<uint64_t>(randomByte()) * 16 * 1024;
+		mean[i] = static_cast<int32_t>(randomByte()) << 16 | (rng() & 0xFFFF);
+	}
+
+	for (const hyperion::SmoothingKernels& kernels : hyperion::availableSmoothingKernels())
+	{
+		const QString prefix = QString("smoothing/%1/").arg(kernels.name);
+		size_t frame = 0;
+
+		bench.run(prefix + "linearStep", count / 3, [&]() {
+			// alternate the targets, the colors never settle
+			kernels.linearStep(previous.data(), targets[++frame % 2].data(), count, 21845);
+			Benchmark::consume(previous[0]);
+		});
+		bench.run(prefix + "normalize", count / 3, [&]() {
+			// (sum >> 4) * 64 is the Q16 mean of the 16 frames
+			kernels.normalize(sums.data(), mean.data(), count, 4, 64.0f);
+			Benchmark::consume(static_cast<uint64_t>(mean[0]));
+		});
+		bench.run(prefix + "dither", count / 3, [&]() {
+			kernels.dither(mean.data(), residual.data(), out.data(), count);
+			Benchmark::consume(out[0]);
+		});
+		bench.run(prefix + "round", count / 3, [&]() {
+			kernels.round(mean.data(), out.data(), count);
+			Benchmark::consume(out[0]);
+		});
+	}
+}
+
+Image<ColorRgb> letterboxImage(unsigned width, unsigned height, unsigned border)
+{
+	Image<ColorRgb> image = randomImage(width, height);
+	for (unsigned y = 0; y < height; ++y)
+	{
+		if (y < border || y >= height - border)
+		{
+			for (unsigned x = 0; x < width; ++x)
+			{
+				image(x, y) = ColorRgb::BLACK;
+			}
+		}
+	}
+	return image;
+}
+
+void benchBlackBorder(Benchmark& bench)
+{
+	const unsigned width = 480;
+	const unsigned height = 270;
+	const Image<ColorRgb> images[2] = { letterboxImage(width, height, 33), letterboxImage(width, height, 35) };
+	const QString size = sizeName(width, height);
+
+	hyperion::BlackBorderDetector detector(0.05);
+
+	bench.run("blackborder/default/" + size, width * height, [&]() {
+		Benchmark::consume(detector.process(images[0]).horizontalSize);
+	});
+	bench.run("blackborder/classic/" + size, width * height, [&]() {
+		Benchmark::consume(detector.process_classic(images[0]).horizontalSize);
+	});
+	bench.run("blackborder/osd/" + size, width * height, [&]() {
+		Benchmark::consume(detector.process_osd(images[0]).horizontalSize);
+	});
+	bench.run("blackborder/letterbox/" + size, width * height, [&]() {
+		Benchmark::consume(detector.process_letterbox(images[0]).horizontalSize);
+	});
+
+	size_t frame = 0;
+	bench.run("blackborder/scan/" + size, width * height, [&]() {
+		// alternate the images, every frame is a scene change
+		Benchmark::consume(detector.process_scan(images[++frame % 2]).horizontalSize);
+	});
+	bench.run("blackborder/scan-unchanged/" + size, width * height, [&]() {
+		Benchmark::consume(detector.process_scan(images[0]).horizontalSize);
+	});
+}
+
+void benchColorConversion(Benchmark& bench)
+{
+	const size_t pixels = 65536;
+	const std::vector<uint8_t> yuv = randomBytes(3 * pixels);
+
+	bench.run("colorsys/yuv2rgb/65536", pixels, [&]() {
+		uint8_t r = 0, g = 0, b = 0;
+		uint64_t sum = 0;
+		for (size_t i = 0; i < 3 * pixels; i += 3)
+		{
+			ColorSys::yuv2rgb(yuv[i], yuv[i + 1], yuv[i + 2], r, g, b);
+			sum += r + g + b;
+		}
+		Benchmark::consume(sum);
+	});
+
+	const struct
+	{
+		RGBW::WhiteAlgorithm algorithm;
+		const char* name;
+	} algorithms[] = {
+		{ RGBW::WhiteAlgorithm::SUBTRACT_MINIMUM,    "subtract_minimum" },
+		{ RGBW::WhiteAlgorithm::SUB_MIN_WARM_ADJUST, "sub_min_warm_adjust" },
+		{ RGBW::WhiteAlgorithm::SUB_MIN_COOL_ADJUST, "sub_min_cool_adjust" },
+		{ RGBW::WhiteAlgorithm::WHITE_OFF,           "white_off" },
+	};
+
+	const size_t ledCount = 1000;
+	std::vector<ColorRgb> colors(ledCount);
+	for (ColorRgb& color : colors)
+	{
+		color = ColorRgb{ randomByte(), randomByte(), randomByte() };
+	}
+	std::vector<ColorRgbw> rgbw(ledCount);
+
+	for (const auto& algorithm : algorithms)
+	{
+		bench.run(QString("rgbw/%1/1000").arg(algorithm.name), ledCount, [&]() {
+			for (size_t i = 0; i < ledCount; ++i)
+			{
+				RGBW::Rgb_to_Rgbw(colors[i], &rgbw[i], algorithm.algorithm);
+			}
+			Benchmark::consume(rgbw[0].white);
+		});
+	}
+}
+
+void benchFlatbuffer(Benchmark& bench)
+{
+	const unsigned sizes[][2] = { {160, 90}, {1920, 1080} };
+
+	for (const auto& size : sizes)
+	{
+		// an image request as sent by FlatBufferConnection::setImage()
+		const Image<ColorRgb> image = randomImage(size[0], size[1]);
+		flatbuffers::FlatBufferBuilder builder;
+		uint8_t* buffer = nullptr;
+		auto imgData = builder.CreateUninitializedVector(image.size(), &buffer);
+		const size_t rowSize = image.width() * sizeof(ColorRgb);
+		for (unsigned y = 0; y < image.height(); ++y)
+		{
+			memcpy(buffer + y * rowSize, image.row(y), rowSize);
+		}
+		auto rawImg = hyperionnet::CreateRawImage(builder, imgData, image.width(), image.height());
+		auto imageReq = hyperionnet::CreateImage(builder, hyperionnet::ImageType_RawImage, rawImg.Union(), -1);
+		auto req = hyperionnet::CreateRequest(builder, hyperionnet::Command_Image, imageReq.Union());
+		builder.Finish(req);
+		const std::vector<uint8_t> message(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
+
+		// the parsing of FlatBufferClient::readyRead() and handleImageCommand()
+		bench.run("flatbuffer/image/" + sizeName(size[0], size[1]), 1, [&]() {
+			flatbuffers::Verifier verifier(message.data(), message.size());
+			if (!hyperionnet::VerifyRequestBuffer(verifier))
+			{
+				return;
+			}
+			const hyperionnet::Request* request = hyperionnet::GetRequest(message.data());
+			const hyperionnet::Image* imageCommand = request->command_as_Image();
+			const hyperionnet::RawImage* raw = (imageCommand != nullptr) ? imageCommand->data_as_RawImage() : nullptr;
+			if (raw != nullptr && (int) raw->data()->size() == raw->width() * raw->height() * 3)
+			{
+				const Image<ColorRgb> view(reinterpret_cast<const ColorRgb*>(raw->data()->data()), raw->width(), raw->height());
+				Benchmark::consume(view.width());
+			}
+		});
+	}
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	Parser parser("Microbenchmarks of the Hyperion processing pipeline. The timing is written as JSON, with a baseline report of a previous run the regressions are listed and the exit code is 1.");
+
+	Option        & argOutput    = parser.add<Option>       ('o', "output",    "Write the JSON report to this file instead of stdout");
+	Option        & argBaseline  = parser.add<Option>       ('b', "baseline",  "Compare with the JSON report of a previous run");
+	DoubleOption  & argThreshold = parser.add<DoubleOption> ('t', "threshold", "Slowdown in percent to report as regression [default: %1]", "10", 0.0);
+	Option        & argFilter    = parser.add<Option>       ('f', "filter",    "Run only benchmarks matching this regular expression, e.g. \"^resampler/\"");
+	IntOption     & argSamples   = parser.add<IntOption>    ('s', "samples",   "Number of timed samples per benchmark [default: %1]", "15", 1);
+	DoubleOption  & argMinTime   = parser.add<DoubleOption> (0x0, "min-time",  "Minimum duration of a sample in ms [default: %1]", "20", 0.1);
+	BooleanOption & argHelp      = parser.add<BooleanOption>('h', "help",      "Show this help message and exit");
+
+	parser.process(app);
+
+	if (parser.isSet(argHelp))
+	{
+		parser.showHelp(0);
+	}
+
+	const QRegularExpression filter(parser.isSet(argFilter) ? argFilter.value(parser) : QString());
+	if (!filter.isValid())
+	{
+		fprintf(stderr, "Invalid filter: %s\n", filter.errorString().toLocal8Bit().constData());
+		return 2;
+	}
+
+	QJsonObject baseline;
+	if (parser.isSet(argBaseline))
+	{
+		QFile file(argBaseline.value(parser));
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			fprintf(stderr, "Cannot read the baseline %s\n", file.fileName().toLocal8Bit().constData());
+			return 2;
+		}
+		baseline = QJsonDocument::fromJson(file.readAll()).object();
+	}
+
+	Benchmark bench(argSamples.getInt(parser), argMinTime.getDouble(parser), filter);
+
+	benchResampler(bench);
+	benchResamplerKernels(bench);
+	benchImageToLeds(bench);
+	benchColorAdjustment(bench);
+	benchSmoothingKernels(bench);
+	benchBlackBorder(bench);
+	benchColorConversion(bench);
+	benchFlatbuffer(bench);
+
+	QStringList regressions;
+	if (parser.isSet(argBaseline))
+	{
+		regressions = bench.compare(baseline, argThreshold.getDouble(parser) / 100.0);
+		fprintf(stderr, "%d regression(s)\n", regressions.size());
+	}
+
+	const QByteArray report = QJsonDocument(bench.toJson()).toJson();
+	if (parser.isSet(argOutput))
+	{
+		QFile file(argOutput.value(parser));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(report) != report.size())
+		{
+			fprintf(stderr, "Cannot write the report %s\n", file.fileName().toLocal8Bit().constData());
+			return 2;
+		}
+	}
+	else
+	{
+		fwrite(report.constData(), 1, report.size(), stdout);
+	}
+
+	return regressions.isEmpty() ? 0 : 1;
+}